@@ -0,0 +1,181 @@
+#pragma once
+
+#include "SyntheticScene.hpp"
+#include "io/PlyWriter.hpp"
+#include "codec/SequenceContainer.hpp"
+#include "codec/SequenceDecoder.hpp"
+#include "pipeline/FrameEncoder.hpp"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 容器往返检查的参数
+struct ContainerRoundTripSettings {
+    SyntheticSceneSettings scene;
+    // 序列的帧数，各帧由同一场景逐帧抖动坐标得到，帧间模式因此会产生预测帧
+    size_t frameCount = 5;
+    float frameJitter = 1e-3f;
+};
+
+/**
+ * @brief 序列容器的往返检查：合成序列按每种编码模式经FrameEncoder写入容器，只重新打开容器文件，
+ * 用SequenceDecoder解码的每一帧须与编码端的重建逐位相同。顺序解码之后再跳跃访问一遍，覆盖帧间模式的随机访问
+ */
+class ContainerRoundTrip {
+public:
+    /**
+     * @param encoderSettings 各模式共用的编码参数，名称须与SyntheticScene的属性名一致
+     * @param directory 容器文件与外存排序的临时目录，检查结束后整个删除
+     * @return 是否全部模式都逐位相同
+     */
+    static bool run(const ContainerRoundTripSettings& settings, const FrameEncoderSettings& encoderSettings, const std::filesystem::path& directory) {
+        std::filesystem::create_directories(directory);
+        const auto scene = SyntheticScene::generate(settings.scene);
+        const auto containerPath = (directory / "round-trip.gss").string();
+        bool passed = true;
+        for (const auto coding : {SequenceCoding::INTRA, SequenceCoding::TEMPORAL, SequenceCoding::PROGRESSIVE, SequenceCoding::TILED,
+                                  SequenceCoding::BLOCKED, SequenceCoding::RATE_CONTROLLED}) {
+            passed &= checkSequence(coding, scene, settings, encoderSettings, containerPath);
+        }
+        passed &= checkScene(scene, encoderSettings, directory);
+        std::filesystem::remove_all(directory);
+        return passed;
+    }
+
+private:
+    static const char* getName(SequenceCoding coding) {
+        switch (coding) {
+            case SequenceCoding::INTRA: return "intra";
+            case SequenceCoding::TEMPORAL: return "temporal";
+            case SequenceCoding::PROGRESSIVE: return "progressive";
+            case SequenceCoding::SCENE: return "scene";
+            case SequenceCoding::TILED: return "tiled";
+            case SequenceCoding::BLOCKED: return "blocked";
+            case SequenceCoding::RATE_CONTROLLED: return "rate controlled";
+        }
+        return "unknown";
+    }
+
+    static bool sameBits(const std::vector<std::vector<float>>& expected, const std::vector<std::vector<float>>& actual) {
+        if (expected.size() != actual.size()) {
+            return false;
+        }
+        for (size_t column = 0; column < expected.size(); ++column) {
+            if (expected[column].size() != actual[column].size()
+                || std::memcmp(expected[column].data(), actual[column].data(), expected[column].size() * sizeof(float)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool sameFrame(const DecodedFrame& expected, const DecodedFrame& actual) {
+        return sameBits(expected.positions, actual.positions) && sameBits(expected.attributes, actual.attributes)
+               && sameBits(expected.rotations, actual.rotations);
+    }
+
+    // 第frameIndex帧：坐标按点号确定性地抖动，点数与属性不变
+    static FrameContext makeFrame(const PlyData& scene, const FrameEncoderSettings& encoderSettings, size_t frameIndex, float jitter) {
+        FrameContext frame;
+        frame.frameIndex = frameIndex;
+        frame.filePath = "frame_" + std::to_string(frameIndex) + ".ply";
+        frame.positions = scene.getTypedProperties<float>("vertex", encoderSettings.positionNames);
+        frame.attributes = scene.getTypedProperties<float>("vertex", encoderSettings.attributeNames);
+        frame.rotations = scene.getTypedProperties<float>("vertex", encoderSettings.rotationNames);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            for (size_t i = 0; i < frame.positions[axis].size(); ++i) {
+                frame.positions[axis][i] += jitter * static_cast<float>(frameIndex) * static_cast<float>(static_cast<int>((i + axis) % 7) - 3);
+            }
+        }
+        return frame;
+    }
+
+    static bool checkSequence(SequenceCoding coding, const PlyData& scene, const ContainerRoundTripSettings& settings,
+                              const FrameEncoderSettings& encoderSettings, const std::string& containerPath) {
+        FrameEncoder encoder(encoderSettings, SpaceFillingCurve::MORTON, encoderSettings.threads);
+        std::vector<DecodedFrame> reconstructed;
+        {
+            SequenceWriter writer(containerPath, encoder.getMetadata(coding, SpaceFillingCurve::MORTON), settings.frameCount);
+            for (size_t i = 0; i < settings.frameCount; ++i) {
+                auto frame = makeFrame(scene, encoderSettings, i, settings.frameJitter);
+                if (coding == SequenceCoding::INTRA || coding == SequenceCoding::PROGRESSIVE) {
+                    encoder.preprocessFrame(frame);
+                    encoder.reorderFrame(frame);
+                }
+                switch (coding) {
+                    case SequenceCoding::INTRA: encoder.encodeFrame(frame, writer); break;
+                    case SequenceCoding::TEMPORAL: encoder.encodeTemporalFrame(frame, writer); break;
+                    case SequenceCoding::PROGRESSIVE: encoder.encodeProgressiveFrame(frame, writer); break;
+                    case SequenceCoding::TILED: encoder.encodeTiledFrame(frame, writer); break;
+                    case SequenceCoding::BLOCKED: encoder.encodeBlockedFrame(frame, writer); break;
+                    case SequenceCoding::RATE_CONTROLLED: encoder.encodeRateControlledFrame(frame, writer); break;
+                    case SequenceCoding::SCENE: break;
+                }
+                reconstructed.push_back({frame.data.getTypedProperties<float>("vertex", encoderSettings.positionNames),
+                                         frame.data.getTypedProperties<float>("vertex", encoderSettings.attributeNames),
+                                         frame.data.getTypedProperties<float>("vertex", encoderSettings.rotationNames)});
+            }
+            writer.finish();
+        }
+
+        // 顺序解码一遍，再以固定步长跳跃访问一遍，帧间模式的跳跃访问会从最近的关键帧重新开始
+        SequenceDecoder decoder(containerPath, encoderSettings.threads);
+        const size_t frameCount = decoder.getFrameCount();
+        std::vector<size_t> order;
+        for (size_t i = 0; i < frameCount; ++i) {
+            order.push_back(i);
+        }
+        for (size_t i = 0; i < frameCount; ++i) {
+            order.push_back((i * 3 + 2) % frameCount);
+        }
+        size_t keyFrames = 0;
+        for (size_t i = 0; i < frameCount; ++i) {
+            keyFrames += decoder.getReader().isKeyFrame(i);
+        }
+        bool passed = frameCount == reconstructed.size() && decoder.getMetadata().coding == coding;
+        for (const size_t index : order) {
+            if (passed && !sameFrame(reconstructed[index], decoder.decodeFrame(index))) {
+                SPDLOG_ERROR("{}: frame {} decoded from the container differs from the encoder's reconstruction", getName(coding), index);
+                passed = false;
+            }
+        }
+        // 帧间模式须真正经过预测帧的解码
+        if (coding == SequenceCoding::TEMPORAL && keyFrames == frameCount) {
+            SPDLOG_ERROR("{}: no predicted frames in the sequence", getName(coding));
+            passed = false;
+        }
+        if (passed) {
+            SPDLOG_INFO("{}: {} frames ({} key frames) decoded bit-identically", getName(coding), frameCount, keyFrames);
+        }
+        return passed;
+    }
+
+    static bool checkScene(const PlyData& scene, const FrameEncoderSettings& encoderSettings, const std::filesystem::path& directory) {
+        const auto plyPath = directory / "round-trip.ply";
+        const auto containerPath = (directory / "round-trip-scene.gss").string();
+        PlyWriter::writeDataToFile(plyPath.string(), scene, PlyFormat::BINARY_LITTLE_ENDIAN, encoderSettings.threads);
+        FrameEncoder encoder(encoderSettings, SpaceFillingCurve::HILBERT, encoderSettings.threads);
+        std::vector<DecodedFrame> reconstructed;
+        encoder.encodeScene(plyPath, SpaceFillingCurve::HILBERT, containerPath, (directory / "sort-runs").string(),
+                            [&reconstructed](size_t, DecodedFrame&& block) { reconstructed.push_back(std::move(block)); });
+
+        bool passed;
+        {
+            SequenceDecoder decoder(containerPath, encoderSettings.threads);
+            passed = decoder.getFrameCount() == reconstructed.size() && decoder.getMetadata().coding == SequenceCoding::SCENE;
+            for (size_t i = decoder.getFrameCount(); passed && i-- > 0;) {
+                if (!sameFrame(reconstructed[i], decoder.decodeFrame(i))) {
+                    SPDLOG_ERROR("scene: block {} decoded from the container differs from the encoder's reconstruction", i);
+                    passed = false;
+                }
+            }
+        }
+        if (passed) {
+            SPDLOG_INFO("scene: {} blocks decoded bit-identically", reconstructed.size());
+        }
+        return passed;
+    }
+};
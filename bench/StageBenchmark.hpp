@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 单个阶段的计时结果，samples为每次重复的耗时(ns)，已升序排列
+struct StageResult {
+    std::string name;
+    size_t splats = 0;
+    size_t bytes = 0;
+    std::vector<double> samples;
+
+    // 最近秩法求百分位，p取[0, 100]
+    double percentile(double p) const {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(samples.size())));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    }
+};
+
+/**
+ * @brief 阶段微基准：每个阶段先预热若干次，再重复计时，报告中位数的ns/splat与GB/s及耗时分位数
+ *
+ * 需要可修改输入的阶段(原地变换、重排)由setup准备一份输入，setup不计入耗时。
+ * bytes为该阶段读取的输入字节数，GB/s按中位数耗时计算
+ */
+class StageBenchmark {
+private:
+    size_t warmup;
+    size_t repetitions;
+    std::vector<StageResult> results;
+
+    // 阻止编译器把没有使用的结果优化掉
+    inline static const void* volatile sink = nullptr;
+
+    template<typename T>
+    static void keep(T& value) {
+        sink = &value;
+    }
+
+public:
+    StageBenchmark(size_t warmup, size_t repetitions) : warmup(warmup), repetitions(std::max<size_t>(1, repetitions)) {}
+
+    /**
+     * @brief 计时一个阶段
+     * @param setup 每次运行前调用，返回值以左值引用传给body
+     * @param body 被计时的部分，须有返回值，返回值在计时结束之后才析构
+     */
+    template<typename Setup, typename Body>
+    const StageResult& run(const std::string& name, size_t splats, size_t bytes, Setup&& setup, Body&& body) {
+        StageResult result{name, splats, bytes, {}};
+        result.samples.reserve(repetitions);
+        for (size_t i = 0; i < warmup + repetitions; ++i) {
+            auto input = setup();
+            const auto begin = std::chrono::steady_clock::now();
+            auto output = body(input);
+            const auto end = std::chrono::steady_clock::now();
+            keep(output);
+            if (i >= warmup) {
+                result.samples.push_back(std::chrono::duration<double, std::nano>(end - begin).count());
+            }
+        }
+        std::sort(result.samples.begin(), result.samples.end());
+
+        const double median = result.percentile(50);
+        SPDLOG_INFO("{:<24} {:>8.2f} ns/splat {:>7.2f} GB/s | ms min {:.3f} p50 {:.3f} p90 {:.3f} p99 {:.3f} max {:.3f}",
+                    name, median / static_cast<double>(splats), median > 0.0 ? static_cast<double>(bytes) / median : 0.0,
+                    result.samples.front() * 1e-6, median * 1e-6, result.percentile(90) * 1e-6, result.percentile(99) * 1e-6,
+                    result.samples.back() * 1e-6);
+        results.push_back(std::move(result));
+        return results.back();
+    }
+
+    // 不需要准备输入的阶段
+    template<typename Body>
+    const StageResult& run(const std::string& name, size_t splats, size_t bytes, Body&& body) {
+        return run(name, splats, bytes, [] { return 0; }, [&body](int&) { return body(); });
+    }
+
+    const std::vector<StageResult>& getResults() const {
+        return results;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "io/PlyData.hpp"
+#include "io/PlySchema.hpp"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// 合成场景的参数
+struct SyntheticSceneSettings {
+    size_t splatCount = 1'000'000;
+    // 点按高斯分布聚成若干团，团中心均匀分布在[-sceneExtent, sceneExtent]^3内
+    size_t clusterCount = 64;
+    float sceneExtent = 20.0f;
+    float clusterRadius = 0.5f;
+    // 离群点的比例，均匀分布在[-outlierExtent, outlierExtent]^3内，模拟重建出的远处漂浮点
+    double outlierFraction = 0.01;
+    float outlierExtent = 500.0f;
+    uint64_t seed = 1;
+};
+
+/**
+ * @brief 确定性的3DGS合成场景：坐标、f_dc、opacity(logit)、scale(对数)与单位四元数rot，属性名与真实数据一致
+ *
+ * 随机数使用splitmix64和自行实现的Box-Muller，不依赖标准库分布的实现：随机序列与平台无关，
+ * 生成的数值只受libm中log/cos/sqrt舍入的影响，相同参数在同一平台上逐位相同
+ */
+class SyntheticScene {
+private:
+    static constexpr float TwoPi = 6.28318530717958647f;
+
+    class Random {
+    private:
+        uint64_t state;
+
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // [0, 1)上的均匀分布，取高24位保证float可以精确表示
+        float uniform() {
+            return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+        }
+
+        float uniform(float low, float high) {
+            return low + (high - low) * uniform();
+        }
+
+        // 标准正态分布，每次只使用Box-Muller的一个输出
+        float normal() {
+            const float u = 1.0f - uniform();
+            return std::sqrt(-2.0f * std::log(u)) * std::cos(TwoPi * uniform());
+        }
+    };
+
+    struct Cluster {
+        float center[3];
+        float radius[3];
+        float color[3];
+    };
+
+public:
+    static const std::vector<std::string>& getPropertyNames() {
+        static const std::vector<std::string> names = {
+            "x", "y", "z",
+            "f_dc_0", "f_dc_1", "f_dc_2",
+            "opacity", "scale_0", "scale_1", "scale_2",
+            "rot_0", "rot_1", "rot_2", "rot_3"};
+        return names;
+    }
+
+    /**
+     * @brief 生成场景，属性均为float，可直接交给PlyWriter写出
+     * @throw std::invalid_argument 如果点数为0或超出PLY元素个数的范围，或没有团
+     */
+    static PlyData generate(const SyntheticSceneSettings& settings) {
+        if (settings.splatCount == 0 || settings.splatCount > static_cast<size_t>(INT32_MAX) || settings.clusterCount == 0) {
+            throw std::invalid_argument("Synthetic scene needs a positive splat count and at least one cluster");
+        }
+        Random random(settings.seed);
+        std::vector<Cluster> clusters(settings.clusterCount);
+        for (auto& cluster : clusters) {
+            for (int axis = 0; axis < 3; ++axis) {
+                cluster.center[axis] = random.uniform(-settings.sceneExtent, settings.sceneExtent);
+                // 各向异性的团，模拟表面附近的扁平分布
+                cluster.radius[axis] = settings.clusterRadius * random.uniform(0.2f, 1.0f);
+                cluster.color[axis] = random.normal();
+            }
+        }
+
+        const auto& names = getPropertyNames();
+        std::vector<std::vector<float>> columns(names.size(), std::vector<float>(settings.splatCount));
+        for (size_t i = 0; i < settings.splatCount; ++i) {
+            const bool outlier = random.uniform() < settings.outlierFraction;
+            const auto& cluster = clusters[random.next() % clusters.size()];
+            for (int axis = 0; axis < 3; ++axis) {
+                columns[axis][i] = outlier ? random.uniform(-settings.outlierExtent, settings.outlierExtent)
+                                           : cluster.center[axis] + cluster.radius[axis] * random.normal();
+                columns[3 + axis][i] = cluster.color[axis] + 0.3f * random.normal();
+            }
+            columns[6][i] = 2.0f + 2.0f * random.normal();
+            // 离群点通常更大
+            const float baseScale = std::log(settings.clusterRadius * (outlier ? 0.2f : 0.02f));
+            for (int axis = 0; axis < 3; ++axis) {
+                columns[7 + axis][i] = baseScale + 0.5f * random.normal();
+            }
+            float rotation[4];
+            float norm = 0.0f;
+            for (auto& component : rotation) {
+                component = random.normal();
+                norm += component * component;
+            }
+            norm = norm > 0.0f ? 1.0f / std::sqrt(norm) : 0.0f;
+            for (int component = 0; component < 4; ++component) {
+                columns[10 + component][i] = rotation[component] * norm;
+            }
+        }
+
+        PlyData data;
+        ElementSchema schema("vertex", static_cast<int32_t>(settings.splatCount));
+        for (const auto& name : names) {
+            schema.addProperty("vertex", name, "float");
+        }
+        data.setProperties("vertex", names, std::move(columns));
+        std::vector<ElementSchema> schemas;
+        schemas.push_back(std::move(schema));
+        data.setSchemas(std::move(schemas));
+        return data;
+    }
+};
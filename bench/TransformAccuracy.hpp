@@ -0,0 +1,143 @@
+#pragma once
+
+#include "codec/Quantization.hpp"
+#include "codec/Transform.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 对数变换的精度：正逆变换各自相对双精度参考的最大ulp误差，以及编码往返在对数域的最大误差(量化步长)
+struct TransformAccuracy {
+    int64_t forwardUlp = 0;
+    int64_t inverseUlp = 0;
+    double roundTripSteps = 0.0;
+};
+
+/**
+ * @brief 对称对数变换的精度检查，界限与Transform文档中的一致：
+ * 正逆变换相对双精度log1p/expm1舍入到float的结果不超过1ulp；
+ * 对数变换、量化、反量化、逆变换一轮之后，坐标与包围盒在对数域的误差小于一个量化步长
+ *
+ * 参考值超出float范围的输入(expm1溢出)不计入，±0按同一个值计
+ */
+class TransformAccuracyCheck {
+public:
+    static constexpr int64_t MaxUlp = 1;
+    static constexpr double MaxRoundTripSteps = 1.0;
+
+    /**
+     * @brief 按位模式等距取|x| <= limit的float及其相反数，从0开始，覆盖非规格化数和±0，末尾补上±limit
+     * @param stride 相邻两个取值的位模式间隔
+     */
+    static std::vector<float> makeSweep(float limit, uint32_t stride) {
+        uint32_t limitBits;
+        std::memcpy(&limitBits, &limit, sizeof(limitBits));
+        std::vector<float> values;
+        values.reserve(2 * (limitBits / stride + 2));
+        for (uint64_t bits = 0; bits <= limitBits; bits += stride) {
+            const uint32_t pattern = static_cast<uint32_t>(bits);
+            float value;
+            std::memcpy(&value, &pattern, sizeof(value));
+            values.push_back(value);
+            values.push_back(-value);
+        }
+        values.push_back(limit);
+        values.push_back(-limit);
+        return values;
+    }
+
+    static int64_t measureForwardUlp(const std::vector<float>& values) {
+        std::vector<std::vector<float>> transformed{values};
+        BoundingBox3D bbox(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+        Transform::logTransformInPlace(transformed, bbox);
+        int64_t maxUlp = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            maxUlp = std::max(maxUlp, ulpDistance(transformed[0][i], static_cast<float>(referenceLog1p(values[i]))));
+        }
+        return maxUlp;
+    }
+
+    static int64_t measureInverseUlp(const std::vector<float>& values) {
+        std::vector<std::vector<float>> transformed{values};
+        BoundingBox3D bbox(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+        Transform::inverseLogTransformInPlace(transformed, bbox);
+        int64_t maxUlp = 0;
+        for (size_t i = 0; i < values.size(); ++i) {
+            const double value = values[i];
+            const double reference = std::copysign(std::expm1(std::abs(value)), value);
+            if (std::abs(reference) > FLT_MAX) {
+                continue;
+            }
+            maxUlp = std::max(maxUlp, ulpDistance(transformed[0][i], static_cast<float>(reference)));
+        }
+        return maxUlp;
+    }
+
+    /**
+     * @brief 按编码器的流程做一轮：求包围盒、对数变换、量化、反量化、用包围盒的副本逆变换，
+     * 在双精度对数域中比较坐标与包围盒，误差以对数域包围盒上bitDepth位量化的步长为单位
+     */
+    static double measureRoundTripSteps(const std::vector<std::vector<float>>& positions, int bitDepth) {
+        const auto bbox = BoundingBox3D::calculateFromPoints(positions);
+        auto logBBox = bbox;
+        auto logPositions = positions;
+        Transform::logTransformInPlace(logPositions, logBBox);
+        const auto quantized = Quantization::quantizePositionWithBBox<uint32_t, float>(logPositions, logBBox, bitDepth);
+        auto decoded = Quantization::dequantizePositionWithBBox<float, uint32_t>(quantized, logBBox, bitDepth);
+        auto decodedBBox = logBBox;
+        Transform::inverseLogTransformInPlace(decoded, decodedBBox);
+
+        double maxSteps = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const double step = (static_cast<double>(logBBox.data[axis + 3]) - logBBox.data[axis]) / static_cast<double>((1u << bitDepth) - 1);
+            const auto toSteps = [step](float decodedValue, float originalValue) {
+                const double error = std::abs(referenceLog1p(decodedValue) - referenceLog1p(originalValue));
+                // 宽度为0的轴没有量化误差，只要求逐位还原
+                return step > 0.0 ? error / step : (error > 0.0 ? MaxRoundTripSteps : 0.0);
+            };
+            for (size_t i = 0; i < positions[axis].size(); ++i) {
+                maxSteps = std::max(maxSteps, toSteps(decoded[axis][i], positions[axis][i]));
+            }
+            maxSteps = std::max({maxSteps, toSteps(decodedBBox.data[axis], bbox.data[axis]),
+                                 toSteps(decodedBBox.data[axis + 3], bbox.data[axis + 3])});
+        }
+        return maxSteps;
+    }
+
+    /**
+     * @brief 输出精度并与界限比较
+     * @return 是否在界限之内
+     */
+    static bool report(const std::string& label, const TransformAccuracy& accuracy) {
+        const bool passed = accuracy.forwardUlp <= MaxUlp && accuracy.inverseUlp <= MaxUlp && accuracy.roundTripSteps < MaxRoundTripSteps;
+        if (passed) {
+            SPDLOG_INFO("{}: log1p {} ulp, expm1 {} ulp, round trip {:.4f} steps", label,
+                        accuracy.forwardUlp, accuracy.inverseUlp, accuracy.roundTripSteps);
+        } else {
+            SPDLOG_ERROR("{}: log1p {} ulp, expm1 {} ulp, round trip {:.4f} steps, exceeds {} ulp or {} step", label,
+                         accuracy.forwardUlp, accuracy.inverseUlp, accuracy.roundTripSteps, MaxUlp, MaxRoundTripSteps);
+        }
+        return passed;
+    }
+
+private:
+    static double referenceLog1p(float value) {
+        const double x = value;
+        return std::copysign(std::log1p(std::abs(x)), x);
+    }
+
+    // float映射到单调的整数后求差，即相隔的ulp数；+0与-0映射到同一个值
+    static int64_t ulpDistance(float a, float b) {
+        const auto toOrdered = [](float value) {
+            int32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits < 0 ? static_cast<int64_t>(INT32_MIN) - bits : static_cast<int64_t>(bits);
+        };
+        return std::abs(toOrdered(a) - toOrdered(b));
+    }
+};
@@ -0,0 +1,303 @@
+#include "SyntheticScene.hpp"
+#include "StageBenchmark.hpp"
+#include "TransformAccuracy.hpp"
+#include "ContainerRoundTrip.hpp"
+#include "io/PlyReader.hpp"
+#include "io/PlyWriter.hpp"
+#include "io/FileTools.hpp"
+#include "codec/OctreeCoder.hpp"
+#include "codec/AttributeCoder.hpp"
+#include "codec/QuaternionCoder.hpp"
+#include "codec/PositionPreprocessor.hpp"
+#include "codec/SpaceFillingCurve.hpp"
+#include "codec/Transform.hpp"
+#include "utils/RadixSort.hpp"
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 基准测试
+// 用法：gaussian-bench [synthetic [点数] [团数] [离群点比例] [重复次数]]  各阶段在合成场景上的微基准
+//       gaussian-bench accuracy                                          对数变换在密集扫描上的精度检查
+//       gaussian-bench container                                         每种编码模式的容器往返检查
+//       gaussian-bench <PLY目录> [位深]                                  在真实数据上对比不同点排列顺序
+// synthetic与accuracy都检查对数变换的精度，超出界限时返回非0；container在解码结果与编码端重建不一致时返回非0
+
+const std::vector<std::string> POSITION_NAMES = {"x", "y", "z"};
+const std::vector<std::string> ATTRIBUTE_NAMES = {
+    "f_dc_0", "f_dc_1", "f_dc_2",
+    "opacity","scale_0", "scale_1", "scale_2",
+    "rot_0", "rot_1", "rot_2", "rot_3"};
+
+const std::vector<AttributeQuantization> ATTRIBUTE_QUANTIZATION = {
+    {10}, {10}, {10},
+    {8, AttributeDomain::SIGMOID, std::array<float, 2>{0.0f, 1.0f}},
+    {10}, {10}, {10},
+    {10}, {10}, {10}, {10}};
+
+struct OrderingResult {
+    double keyMs = 0;
+    double sortMs = 0;
+    double reorderMs = 0;
+    size_t geometryBytes = 0;
+    size_t attributeBytes = 0;
+    // 相邻两点量化坐标的平均L1距离，衡量排列的局部性
+    double meanStep = 0;
+    // 相邻两点属性差的平均绝对值，越小越利于属性预测
+    double meanAttributeDelta = 0;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+OrderingResult benchmarkOrdering(const std::vector<std::vector<float>>& positions, std::vector<std::vector<float>> attributes,
+                                 SpaceFillingCurve curve, int bitDepth) {
+    OrderingResult result;
+    auto begin = std::chrono::steady_clock::now();
+    auto preprocessed = PositionPreprocessor::process<uint16_t>(positions, bitDepth, 0, curve);
+    result.keyMs = elapsedMs(begin);
+
+    begin = std::chrono::steady_clock::now();
+    RadixSort::sortPairs(preprocessed.curveKeys, preprocessed.indices, 0);
+    result.sortMs = elapsedMs(begin);
+
+    auto& quantized = preprocessed.quantizedPositions;
+    begin = std::chrono::steady_clock::now();
+    Transform::reorderColumnsInPlace(preprocessed.indices, 0, quantized, attributes);
+    result.reorderMs = elapsedMs(begin);
+
+    result.geometryBytes = OctreeCoder::encode(quantized, bitDepth, curve).size();
+    result.attributeBytes = AttributeCoder::encode(attributes, ATTRIBUTE_QUANTIZATION, 0).size();
+
+    const size_t count = quantized[0].size();
+    double step = 0;
+    double attributeDelta = 0;
+    for (size_t i = 1; i < count; ++i) {
+        for (const auto& axis : quantized) {
+            step += std::abs(static_cast<int>(axis[i]) - static_cast<int>(axis[i - 1]));
+        }
+        for (const auto& column : attributes) {
+            attributeDelta += std::abs(column[i] - column[i - 1]);
+        }
+    }
+    if (count > 1) {
+        result.meanStep = step / static_cast<double>(count - 1);
+        result.meanAttributeDelta = attributeDelta / static_cast<double>((count - 1) * attributes.size());
+    }
+    return result;
+}
+
+// 微基准的预热次数与默认重复次数
+const size_t STAGE_WARMUP = 2;
+const size_t STAGE_REPETITIONS = 10;
+const int STAGE_BIT_DEPTH = 16;
+
+/**
+ * @brief 在合成场景上依次计时编码流程的各个阶段，后一阶段的输入取自前一阶段的输出；
+ * 同时在场景坐标上检查对数变换的精度，SIMD实现的精度回退也能被发现
+ * @return 精度是否在界限之内
+ */
+bool runStageBenchmarks(const SyntheticSceneSettings& settings, size_t repetitions) {
+    const size_t threads = 0;
+    const auto scene = SyntheticScene::generate(settings);
+    const auto positions = scene.getTypedProperties<float>("vertex", POSITION_NAMES);
+    const auto attributes = scene.getTypedProperties<float>("vertex", {"f_dc_0", "f_dc_1", "f_dc_2", "opacity", "scale_0", "scale_1", "scale_2"});
+    const auto rotations = scene.getTypedProperties<float>("vertex", {"rot_0", "rot_1", "rot_2", "rot_3"});
+    const size_t n = positions[0].size();
+    const std::vector<AttributeQuantization> attributeQuantization(ATTRIBUTE_QUANTIZATION.begin(), ATTRIBUTE_QUANTIZATION.begin() + attributes.size());
+    SPDLOG_INFO("Synthetic scene: {} splats, {} clusters, {:.2f}% outliers, seed {}; {} threads, {} warmup + {} repetitions",
+                n, settings.clusterCount, settings.outlierFraction * 100, settings.seed, Parallel::resolveThreadCount(threads),
+                STAGE_WARMUP, repetitions);
+
+    StageBenchmark bench(STAGE_WARMUP, repetitions);
+    // PLY读写经过文件系统，结果包含页缓存的影响
+    const auto plyPath = (std::filesystem::temp_directory_path() / "gaussian-bench.ply").string();
+    const size_t plyBytes = n * SyntheticScene::getPropertyNames().size() * sizeof(float);
+    bench.run("ply write", n, plyBytes, [&] {
+        PlyWriter::writeDataToFile(plyPath, scene, PlyFormat::BINARY_LITTLE_ENDIAN, threads);
+        return 0;
+    });
+    bench.run("ply read", n, plyBytes, [&] { return PlyReader::readDataFromFile(plyPath, threads); });
+    std::filesystem::remove(plyPath);
+
+    const size_t positionBytes = n * 3 * sizeof(float);
+    bench.run("bbox", n, positionBytes, [&] { return BoundingBox3D::calculateFromPoints(positions, threads); });
+
+    auto logPositions = positions;
+    auto logBBox = BoundingBox3D::calculateFromPoints(positions, threads);
+    Transform::logTransformInPlace(logPositions, logBBox, threads);
+    bench.run("log transform", n, positionBytes, [&] { return std::make_pair(positions, logBBox); }, [&](auto& input) {
+        Transform::logTransformInPlace(input.first, input.second, threads);
+        return 0;
+    });
+    bench.run("inverse log transform", n, positionBytes, [&] { return std::make_pair(logPositions, logBBox); }, [&](auto& input) {
+        Transform::inverseLogTransformInPlace(input.first, input.second, threads);
+        return 0;
+    });
+
+    bench.run("quantization", n, positionBytes, [&] {
+        return Quantization::quantizePositionWithBBox<uint16_t, float>(logPositions, logBBox, STAGE_BIT_DEPTH, threads);
+    });
+    const auto quantized = Quantization::quantizePositionWithBBox<uint16_t, float>(logPositions, logBBox, STAGE_BIT_DEPTH, threads);
+    bench.run("dequantization", n, n * 3 * sizeof(uint16_t), [&] {
+        return Quantization::dequantizePositionWithBBox<float, uint16_t>(quantized, logBBox, STAGE_BIT_DEPTH, threads);
+    });
+
+    // 排序键与排序分开计时，融合的预处理(对数变换 + 量化 + 排序键)单独计时
+    std::vector<uint64_t> keys(n);
+    for (const auto curve : {SpaceFillingCurve::MORTON, SpaceFillingCurve::HILBERT}) {
+        bench.run(std::string(CurveOrder::getName(curve)) + " keys", n, n * 3 * sizeof(uint16_t), [&] {
+            Parallel::forRange(n, threads, [&](size_t begin, size_t end) {
+                CurveOrder::encode3DKeys(curve, quantized[0].data() + begin, quantized[1].data() + begin, quantized[2].data() + begin,
+                                         keys.data() + begin, end - begin, STAGE_BIT_DEPTH);
+            }, 1 << 16);
+            return keys[0];
+        });
+    }
+    bench.run("preprocess (fused)", n, positionBytes, [&] {
+        return PositionPreprocessor::process<uint16_t>(positions, STAGE_BIT_DEPTH, threads, SpaceFillingCurve::MORTON);
+    });
+
+    auto preprocessed = PositionPreprocessor::process<uint16_t>(positions, STAGE_BIT_DEPTH, threads, SpaceFillingCurve::MORTON);
+    const size_t sortBytes = n * (sizeof(uint64_t) + sizeof(uint32_t));
+    bench.run("radix sort", n, sortBytes, [&] { return std::make_pair(preprocessed.curveKeys, preprocessed.indices); }, [&](auto& input) {
+        RadixSort::sortPairs(input.first, input.second, threads);
+        return 0;
+    });
+    RadixSort::sortPairs(preprocessed.curveKeys, preprocessed.indices, threads);
+
+    struct Columns {
+        std::vector<std::vector<uint16_t>> quantized;
+        std::vector<std::vector<float>> attributes;
+        std::vector<std::vector<float>> rotations;
+    };
+    const size_t columnBytes = n * (3 * sizeof(uint16_t) + (attributes.size() + rotations.size()) * sizeof(float));
+    bench.run("reorder", n, columnBytes, [&] { return Columns{preprocessed.quantizedPositions, attributes, rotations}; }, [&](Columns& input) {
+        Transform::reorderColumnsInPlace(preprocessed.indices, threads, input.quantized, input.attributes, input.rotations);
+        return 0;
+    });
+    Columns sorted{preprocessed.quantizedPositions, attributes, rotations};
+    Transform::reorderColumnsInPlace(preprocessed.indices, threads, sorted.quantized, sorted.attributes, sorted.rotations);
+
+    // 编解码阶段的字节数均按未压缩的一侧计算
+    const size_t geometryBytes = n * 3 * sizeof(uint16_t);
+    const size_t attributeBytes = n * attributes.size() * sizeof(float);
+    const size_t rotationBytes = n * rotations.size() * sizeof(float);
+    const auto geometry = OctreeCoder::encode(sorted.quantized, STAGE_BIT_DEPTH, SpaceFillingCurve::MORTON);
+    const auto attributeStream = AttributeCoder::encode(sorted.attributes, attributeQuantization, threads);
+    const auto rotationStream = QuaternionCoder::encode(sorted.rotations, threads);
+    bench.run("octree encode", n, geometryBytes, [&] { return OctreeCoder::encode(sorted.quantized, STAGE_BIT_DEPTH, SpaceFillingCurve::MORTON); });
+    bench.run("octree decode", n, geometryBytes, [&] { return OctreeCoder::decode<uint16_t>(geometry); });
+    bench.run("attribute encode", n, attributeBytes, [&] { return AttributeCoder::encode(sorted.attributes, attributeQuantization, threads); });
+    bench.run("attribute decode", n, attributeBytes, [&] { return AttributeCoder::decode(attributeStream, threads); });
+    bench.run("quaternion encode", n, rotationBytes, [&] { return QuaternionCoder::encode(sorted.rotations, threads); });
+    bench.run("quaternion decode", n, rotationBytes, [&] { return QuaternionCoder::decode(rotationStream, threads); });
+    SPDLOG_INFO("Compressed: geometry {:.3f} bpp, attributes {:.3f} bytes per splat, rotations {:.3f} bytes per splat, {:.3f} bytes per splat in total",
+                geometry.size() * 8.0 / n, static_cast<double>(attributeStream.size()) / n, static_cast<double>(rotationStream.size()) / n,
+                static_cast<double>(geometry.size() + attributeStream.size() + rotationStream.size()) / n);
+
+    TransformAccuracy accuracy;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        accuracy.forwardUlp = std::max(accuracy.forwardUlp, TransformAccuracyCheck::measureForwardUlp(positions[axis]));
+        accuracy.inverseUlp = std::max(accuracy.inverseUlp, TransformAccuracyCheck::measureInverseUlp(logPositions[axis]));
+    }
+    accuracy.roundTripSteps = TransformAccuracyCheck::measureRoundTripSteps(positions, STAGE_BIT_DEPTH);
+    return TransformAccuracyCheck::report("log transform on scene", accuracy);
+}
+
+// 精度检查的扫描间隔(位模式)，正逆变换各约3300万个输入，往返每个范围约200万个点
+const uint32_t ACCURACY_SWEEP_STRIDE = 257;
+const uint32_t ACCURACY_ROUND_TRIP_STRIDE = 4099;
+const int ACCURACY_BIT_DEPTH = 16;
+// 逆变换的有效输入范围|y| <= ln(FLT_MAX)，取不超过它的最大float
+const float LOG_FLT_MAX = 88.7228317f;
+
+/**
+ * @brief 对数变换在按位模式的密集扫描上的精度检查，覆盖非规格化数、±0、最大有限值，
+ * 往返检查在几个量级的坐标范围上进行，范围的边界即包围盒的边界
+ * @return 是否全部在界限之内
+ */
+bool runAccuracyCheck() {
+    TransformAccuracy accuracy;
+    accuracy.forwardUlp = TransformAccuracyCheck::measureForwardUlp(TransformAccuracyCheck::makeSweep(FLT_MAX, ACCURACY_SWEEP_STRIDE));
+    accuracy.inverseUlp = TransformAccuracyCheck::measureInverseUlp(TransformAccuracyCheck::makeSweep(LOG_FLT_MAX, ACCURACY_SWEEP_STRIDE));
+    for (const float extent : {1.0f, 1e3f, FLT_MAX}) {
+        const auto values = TransformAccuracyCheck::makeSweep(extent, ACCURACY_ROUND_TRIP_STRIDE);
+        const double steps = TransformAccuracyCheck::measureRoundTripSteps({values, values, values}, ACCURACY_BIT_DEPTH);
+        SPDLOG_INFO("round trip over [-{:g}, {:g}] at {} bits: {:.4f} steps", extent, extent, ACCURACY_BIT_DEPTH, steps);
+        accuracy.roundTripSteps = std::max(accuracy.roundTripSteps, steps);
+    }
+    return TransformAccuracyCheck::report("log transform sweep", accuracy);
+}
+
+// 容器往返检查的合成序列：点数少、块小，使分块、分段与外存排序都有多个单元
+const size_t ROUND_TRIP_SPLATS = 20'000;
+const size_t ROUND_TRIP_CLUSTERS = 16;
+const size_t ROUND_TRIP_KEYFRAME_INTERVAL = 3;
+
+/**
+ * @brief 每种编码模式把合成序列写入容器后只从容器文件解码，检查与编码端的重建逐位相同
+ * @return 是否全部一致
+ */
+bool runContainerRoundTrip() {
+    ContainerRoundTripSettings settings;
+    settings.scene.splatCount = ROUND_TRIP_SPLATS;
+    settings.scene.clusterCount = ROUND_TRIP_CLUSTERS;
+
+    FrameEncoderSettings encoderSettings;
+    encoderSettings.positionNames = POSITION_NAMES;
+    encoderSettings.attributeNames = {"f_dc_0", "f_dc_1", "f_dc_2", "opacity", "scale_0", "scale_1", "scale_2"};
+    encoderSettings.rotationNames = {"rot_0", "rot_1", "rot_2", "rot_3"};
+    encoderSettings.attributeQuantization.assign(ATTRIBUTE_QUANTIZATION.begin(), ATTRIBUTE_QUANTIZATION.begin() + encoderSettings.attributeNames.size());
+    encoderSettings.keyframeInterval = ROUND_TRIP_KEYFRAME_INTERVAL;
+    encoderSettings.tilesPerFrame = 4;
+    // 预算低于16位几何所需，码率控制选择较低的位深，解码端须从几何码流读取位深
+    encoderSettings.rateTarget = RateTarget{ROUND_TRIP_SPLATS * 10};
+    encoderSettings.sceneChunkSplats = ROUND_TRIP_SPLATS / 3;
+    encoderSettings.sceneSortMemory = ROUND_TRIP_SPLATS * 16;
+    encoderSettings.sceneBlockSplats = ROUND_TRIP_SPLATS / 4;
+    encoderSettings.threads = 0;
+    return ContainerRoundTrip::run(settings, encoderSettings, std::filesystem::temp_directory_path() / "gaussian-bench-container");
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "accuracy") {
+        return runAccuracyCheck() ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "container") {
+        return runContainerRoundTrip() ? 0 : 1;
+    }
+    if (argc < 2 || std::string(argv[1]) == "synthetic") {
+        SyntheticSceneSettings settings;
+        settings.splatCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : settings.splatCount;
+        settings.clusterCount = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : settings.clusterCount;
+        settings.outlierFraction = argc > 4 ? std::atof(argv[4]) : settings.outlierFraction;
+        return runStageBenchmarks(settings, argc > 5 ? std::strtoull(argv[5], nullptr, 10) : STAGE_REPETITIONS) ? 0 : 1;
+    }
+    const int bitDepth = argc > 2 ? std::atoi(argv[2]) : 16;
+    auto files = FileTools::findFilesMatchingPattern(argv[1], R"(.*\.ply)");
+    SPDLOG_INFO("Benchmarking {} PLY files at {} bits", files.size(), bitDepth);
+
+    for (const auto& file : files) {
+        auto data = PlyReader::readDataFromFile(file.string(), 0);
+        const auto positions = data.takeTypedProperties<float>("vertex", POSITION_NAMES);
+        const auto attributes = data.takeTypedProperties<float>("vertex", ATTRIBUTE_NAMES);
+        const size_t count = positions[0].size();
+
+        for (const auto curve : {SpaceFillingCurve::MORTON, SpaceFillingCurve::HILBERT}) {
+            const auto result = benchmarkOrdering(positions, attributes, curve, bitDepth);
+            SPDLOG_INFO("{} {:>7}: keys {:.2f} ms, sort {:.2f} ms, reorder {:.2f} ms, geometry {} bytes ({:.3f} bpp), attributes {} bytes ({:.3f} bytes per splat), mean step {:.1f}, mean attribute delta {:.4f}",
+                        file.filename().string(), CurveOrder::getName(curve), result.keyMs, result.sortMs, result.reorderMs,
+                        result.geometryBytes, result.geometryBytes * 8.0 / count,
+                        result.attributeBytes, static_cast<double>(result.attributeBytes) / count, result.meanStep, result.meanAttributeDelta);
+        }
+    }
+    return 0;
+}
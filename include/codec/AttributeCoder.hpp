@@ -0,0 +1,235 @@
+#pragma once
+
+#include "ResidualCoder.hpp"
+#include "utils/Parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 属性量化所在的值域
+enum class AttributeDomain : uint8_t {
+    // 直接量化存储值，适用于f_dc、已是对数域的scale和旋转分量
+    LINEAR = 0,
+    // 先做sigmoid再量化，适用于以logit存储的opacity
+    SIGMOID = 1
+};
+
+// 单个属性的量化设置，可只给出位深，例如{10}
+struct AttributeQuantization {
+    int bitDepth;
+    AttributeDomain domain;
+    // 量化范围(变换后的值域)，未指定时使用数据的最小最大值，超出范围的值被截断
+    std::optional<std::array<float, 2>> range;
+
+    AttributeQuantization(int bitDepth = 12, AttributeDomain domain = AttributeDomain::LINEAR,
+                          std::optional<std::array<float, 2>> range = std::nullopt)
+        : bitDepth(bitDepth), domain(domain), range(range) {}
+};
+
+// 属性编码器：每列属性独立量化，以曲线顺序上的前一个点为预测，残差由ResidualCoder熵编码
+// 码流：点数(uint32) + 列数(uint8) + 各列字节数(uint32) + 各列数据
+// 列数据：值域(uint8) + 位深(uint8) + 范围(2 x float) + 残差码流
+class AttributeCoder {
+private:
+    static constexpr size_t ColumnHeaderSize = 10;
+    // sigmoid值域反变换时的截断，避免logit得到无穷大
+    static constexpr float SigmoidEpsilon = 1e-7f;
+
+    static float fromDomain(float value, AttributeDomain domain) {
+        if (domain != AttributeDomain::SIGMOID) {
+            return value;
+        }
+        value = std::clamp(value, SigmoidEpsilon, 1.0f - SigmoidEpsilon);
+        return std::log(value / (1.0f - value));
+    }
+
+    static void checkBitDepth(int bitDepth) {
+        if (bitDepth < 1 || bitDepth > MaxBitDepth) {
+            SPDLOG_ERROR("Invalid attribute bit depth: {}", bitDepth);
+            throw std::runtime_error("Invalid attribute bit depth: " + std::to_string(bitDepth));
+        }
+    }
+
+    static std::vector<uint8_t> encodeColumn(const std::vector<float>& values, const AttributeQuantization& settings) {
+        const auto range = settings.range ? *settings.range : computeRange(values, settings.domain);
+        const auto levels = quantize(values, settings.domain, settings.bitDepth, range);
+
+        std::vector<uint8_t> column(ColumnHeaderSize);
+        column[0] = static_cast<uint8_t>(settings.domain);
+        column[1] = static_cast<uint8_t>(settings.bitDepth);
+        std::memcpy(column.data() + 2, range.data(), sizeof(range));
+        const auto residuals = ResidualCoder::encodeDelta(levels.data(), levels.size(), settings.bitDepth);
+        column.insert(column.end(), residuals.begin(), residuals.end());
+        return column;
+    }
+
+    static std::vector<float> decodeColumn(const uint8_t* data, size_t size, size_t count) {
+        if (size < ColumnHeaderSize) {
+            throw std::runtime_error("Truncated attribute column");
+        }
+        const auto domain = static_cast<AttributeDomain>(data[0]);
+        const int bitDepth = data[1];
+        if (data[0] > static_cast<uint8_t>(AttributeDomain::SIGMOID)) {
+            throw std::runtime_error("Corrupted attribute column: unknown domain");
+        }
+        checkBitDepth(bitDepth);
+        std::array<float, 2> range;
+        std::memcpy(range.data(), data + 2, sizeof(range));
+
+        std::vector<uint16_t> levels(count);
+        ResidualCoder::decodeDelta(data + ColumnHeaderSize, size - ColumnHeaderSize, levels.data(), count, bitDepth);
+        return dequantize(levels, domain, bitDepth, range);
+    }
+
+public:
+    static constexpr int MaxBitDepth = 16;
+
+    /**
+     * @brief 变换到量化所在的值域，量化误差在该值域内度量
+     */
+    static float toDomain(float value, AttributeDomain domain) {
+        return domain == AttributeDomain::SIGMOID ? 1.0f / (1.0f + std::exp(-value)) : value;
+    }
+
+    /**
+     * @brief 变换后值域的最小最大值，跳过NaN，全部为NaN时为[0, 0]
+     */
+    static std::array<float, 2> computeRange(const std::vector<float>& values, AttributeDomain domain) {
+        float minValue = std::numeric_limits<float>::infinity();
+        float maxValue = -std::numeric_limits<float>::infinity();
+        for (const float value : values) {
+            const float transformed = toDomain(value, domain);
+            minValue = std::min(minValue, transformed);
+            maxValue = std::max(maxValue, transformed);
+        }
+        if (minValue <= maxValue) {
+            return {minValue, maxValue};
+        }
+        return {0.0f, 0.0f};
+    }
+
+    /**
+     * @brief 将一列属性量化为[0, 2^bitDepth - 1]的整数，超出range的值被截断，NaN落到0
+     * @throw std::runtime_error 如果位深无效
+     */
+    static std::vector<uint16_t> quantize(const std::vector<float>& values, AttributeDomain domain, int bitDepth, const std::array<float, 2>& range) {
+        checkBitDepth(bitDepth);
+        const float maxLevel = static_cast<float>((1u << bitDepth) - 1);
+        const float extent = range[1] - range[0];
+        const float scale = extent > 0.0f ? maxLevel / extent : 0.0f;
+        std::vector<uint16_t> levels(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            // std::max在第二个参数为NaN时返回第一个参数
+            const float level = std::min(std::max(0.0f, (toDomain(values[i], domain) - range[0]) * scale), maxLevel);
+            levels[i] = static_cast<uint16_t>(std::nearbyint(level));
+        }
+        return levels;
+    }
+
+    /**
+     * @brief quantize的逆变换
+     * @throw std::runtime_error 如果位深无效
+     */
+    static std::vector<float> dequantize(const std::vector<uint16_t>& levels, AttributeDomain domain, int bitDepth, const std::array<float, 2>& range) {
+        checkBitDepth(bitDepth);
+        const float step = (range[1] - range[0]) / static_cast<float>((1u << bitDepth) - 1);
+        std::vector<float> values(levels.size());
+        for (size_t i = 0; i < levels.size(); ++i) {
+            values[i] = fromDomain(std::fma(static_cast<float>(levels[i]), step, range[0]), domain);
+        }
+        return values;
+    }
+
+    /**
+     * @brief 编码已按曲线顺序排列的属性列
+     * @param attributes 属性列，每列长度相同
+     * @param settings 与attributes一一对应的量化设置
+     * @param numThreads 线程数，各列并行编码，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果列数与设置不匹配、列长度不一致或位深无效
+     */
+    static std::vector<uint8_t> encode(const std::vector<std::vector<float>>& attributes, const std::vector<AttributeQuantization>& settings, size_t numThreads = 1) {
+        if (attributes.size() != settings.size() || attributes.size() > UINT8_MAX) {
+            SPDLOG_ERROR("Attribute count {} does not match {} quantization settings", attributes.size(), settings.size());
+            throw std::runtime_error("Attribute count does not match quantization settings");
+        }
+        const size_t count = attributes.empty() ? 0 : attributes[0].size();
+        for (size_t column = 0; column < attributes.size(); ++column) {
+            if (attributes[column].size() != count) {
+                throw std::runtime_error("Attribute columns must have equal length");
+            }
+            checkBitDepth(settings[column].bitDepth);
+        }
+        if (count > UINT32_MAX) {
+            throw std::runtime_error("Too many points for attribute coding");
+        }
+
+        std::vector<std::vector<uint8_t>> columns(attributes.size());
+        Parallel::forRange(attributes.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                columns[column] = encodeColumn(attributes[column], settings[column]);
+            }
+        });
+
+        std::vector<uint8_t> bitstream(5 + 4 * columns.size());
+        const uint32_t pointCount = static_cast<uint32_t>(count);
+        std::memcpy(bitstream.data(), &pointCount, sizeof(pointCount));
+        bitstream[4] = static_cast<uint8_t>(columns.size());
+        for (size_t column = 0; column < columns.size(); ++column) {
+            const uint32_t columnSize = static_cast<uint32_t>(columns[column].size());
+            std::memcpy(bitstream.data() + 5 + 4 * column, &columnSize, sizeof(columnSize));
+        }
+        for (const auto& column : columns) {
+            bitstream.insert(bitstream.end(), column.begin(), column.end());
+        }
+        return bitstream;
+    }
+
+    /**
+     * @brief 解码属性码流
+     * @param numThreads 线程数，各列并行解码，0表示使用全部硬件线程
+     * @return 属性列，顺序与编码时一致
+     * @throw std::runtime_error 如果码流损坏
+     */
+    static std::vector<std::vector<float>> decode(const uint8_t* bitstream, size_t size, size_t numThreads = 1) {
+        if (size < 5) {
+            throw std::runtime_error("Truncated attribute bitstream");
+        }
+        uint32_t pointCount;
+        std::memcpy(&pointCount, bitstream, sizeof(pointCount));
+        const size_t columnCount = bitstream[4];
+        if (size < 5 + 4 * columnCount) {
+            throw std::runtime_error("Truncated attribute bitstream");
+        }
+
+        std::vector<size_t> offsets(columnCount + 1, 5 + 4 * columnCount);
+        for (size_t column = 0; column < columnCount; ++column) {
+            uint32_t columnSize;
+            std::memcpy(&columnSize, bitstream + 5 + 4 * column, sizeof(columnSize));
+            offsets[column + 1] = offsets[column] + columnSize;
+        }
+        if (offsets.back() > size) {
+            SPDLOG_ERROR("Attribute bitstream needs {} bytes, got {}", offsets.back(), size);
+            throw std::runtime_error("Truncated attribute bitstream");
+        }
+
+        std::vector<std::vector<float>> attributes(columnCount);
+        Parallel::forRange(columnCount, numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                attributes[column] = decodeColumn(bitstream + offsets[column], offsets[column + 1] - offsets[column], pointCount);
+            }
+        });
+        return attributes;
+    }
+
+    static std::vector<std::vector<float>> decode(const std::vector<uint8_t>& bitstream, size_t numThreads = 1) {
+        return decode(bitstream.data(), bitstream.size(), numThreads);
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 按位写出，低位在前
+class BitWriter {
+private:
+    std::vector<uint8_t> output;
+    uint64_t buffer = 0;
+    int bufferedBits = 0;
+
+public:
+    // 写出value的低numBits位，numBits不超过32
+    void write(uint32_t value, int numBits) {
+        if (numBits == 0) {
+            return;
+        }
+        buffer |= static_cast<uint64_t>(value & (0xFFFFFFFFu >> (32 - numBits))) << bufferedBits;
+        bufferedBits += numBits;
+        while (bufferedBits >= 8) {
+            output.push_back(static_cast<uint8_t>(buffer));
+            buffer >>= 8;
+            bufferedBits -= 8;
+        }
+    }
+
+    // 补齐最后一个字节并取出数据
+    std::vector<uint8_t> finish() {
+        if (bufferedBits > 0) {
+            output.push_back(static_cast<uint8_t>(buffer));
+            buffer = 0;
+            bufferedBits = 0;
+        }
+        return std::move(output);
+    }
+};
+
+// 与BitWriter对应的读取器，读越界时按0补齐
+class BitReader {
+private:
+    const uint8_t* cursor;
+    const uint8_t* end;
+    uint64_t buffer = 0;
+    int bufferedBits = 0;
+
+public:
+    BitReader(const uint8_t* data, size_t size) : cursor(data), end(data + size) {}
+
+    uint32_t read(int numBits) {
+        if (numBits == 0) {
+            return 0;
+        }
+        while (bufferedBits < numBits) {
+            const uint64_t byte = cursor < end ? *cursor++ : 0;
+            buffer |= byte << bufferedBits;
+            bufferedBits += 8;
+        }
+        const uint32_t value = static_cast<uint32_t>(buffer & (0xFFFFFFFFu >> (32 - numBits)));
+        buffer >>= numBits;
+        bufferedBits -= numBits;
+        return value;
+    }
+};
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "OctreeCoder.hpp"
+#include "PositionPreprocessor.hpp"
+#include "Quantization.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "Transform.hpp"
+#include "utils/Parallel.hpp"
+#include "utils/RadixSort.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 一个量化块：曲线上连续的一段点，坐标以块内最小点为原点，在块自己的步长和位深下表示
+struct QuantizationBlock {
+    // 块在输出点序中的起始位置与点数
+    uint32_t begin = 0;
+    uint32_t count = 0;
+    // 块的原点，全局网格上的坐标
+    std::array<uint32_t, 3> origin{};
+    // 块的量化步长为全局步长的2^shift倍，全局网格坐标 = 原点 + (块内坐标 << shift)
+    int shift = 0;
+    // 块内坐标的位深
+    int bitDepth = 1;
+};
+
+// 分块量化的结果，点按块依次排列，块内按块坐标的曲线顺序排列
+struct BlockQuantizedPositions {
+    // 对数域的全局包围盒与全局网格位深，所有块共用同一量化步长
+    BoundingBox3D bbox{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    int gridBitDepth = 16;
+    std::vector<QuantizationBlock> blocks;
+    std::vector<std::vector<uint16_t>> localPositions;
+    // 输出点序对应的输入下标，用于重排属性；解码结果中为空
+    std::vector<uint32_t> order;
+};
+
+/**
+ * @brief 分块自适应的位置量化：各块有自己的紧凑包围盒、量化步长和位深，整帧满足同一个最大几何误差
+ *
+ * 坐标在对数域上均匀量化，还原到世界坐标时误差随|x|增长，因此少量远处的漂浮点决定了整帧需要的位深，
+ * 而占大多数的近处密集点被量化得过细。这里先在精细的全局网格上量化并按曲线排序，再沿曲线贪心切块：
+ * 块内点数达到上限或跨度超过16位时开新块。每块以块内各轴最小值为原点，按块内最远点选取满足误差上限的最粗步长
+ * (全局步长的2的幂倍)，块内坐标按该步长取整，位深为跨度所需的位数，各块独立八叉树编码。
+ * 误差上限默认取全局网格在整帧最远点处的误差，此时最大几何误差与全局网格相同，而密集区域的块少用若干位。
+ *
+ * 几何码流：点数(uint32) + 全局位深(uint8) + 曲线(uint8) + 对数域包围盒(6 x float) + 块数(uint32)
+ *          + 块表{点数(uint32), 原点(3 x uint32), 步长位移(uint8), 位深(uint8), 八叉树字节数(uint32)} + 各块八叉树码流
+ */
+class BlockQuantizer {
+private:
+    static constexpr size_t BlockEntrySize = 22;
+    // 块内坐标的最大位深，与OctreeCoder的uint16坐标一致
+    static constexpr int MaxLocalBitDepth = 16;
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& output, T value) {
+        const size_t offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static T read(const uint8_t* data, size_t size, size_t& offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::runtime_error("Truncated block quantized bitstream");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    // 沿曲线顺序贪心切块
+    static std::vector<QuantizationBlock> partition(const std::vector<std::vector<uint32_t>>& quantized, const std::vector<uint32_t>& sortedIndices,
+                                                    size_t blockSize) {
+        std::vector<QuantizationBlock> blocks;
+        const uint32_t maxExtent = (1u << MaxLocalBitDepth) - 1;
+        std::array<uint32_t, 3> minValue{};
+        std::array<uint32_t, 3> maxValue{};
+        size_t blockBegin = 0;
+        for (size_t i = 0; i < sortedIndices.size(); ++i) {
+            const uint32_t index = sortedIndices[i];
+            bool fits = i > blockBegin && i - blockBegin < blockSize;
+            for (size_t axis = 0; fits && axis < 3; ++axis) {
+                const uint32_t value = quantized[axis][index];
+                fits = std::max(maxValue[axis], value) - std::min(minValue[axis], value) <= maxExtent;
+            }
+            if (!fits) {
+                if (i > blockBegin) {
+                    blocks.push_back({static_cast<uint32_t>(blockBegin), static_cast<uint32_t>(i - blockBegin), minValue});
+                }
+                blockBegin = i;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    minValue[axis] = maxValue[axis] = quantized[axis][index];
+                }
+                continue;
+            }
+            for (size_t axis = 0; axis < 3; ++axis) {
+                minValue[axis] = std::min(minValue[axis], quantized[axis][index]);
+                maxValue[axis] = std::max(maxValue[axis], quantized[axis][index]);
+            }
+        }
+        if (sortedIndices.size() > blockBegin) {
+            blocks.push_back({static_cast<uint32_t>(blockBegin), static_cast<uint32_t>(sortedIndices.size() - blockBegin), minValue});
+        }
+        return blocks;
+    }
+
+    // 对数域坐标v还原到世界坐标后的量级|x| = expm1(|v|)，对数域误差h在该处造成的世界坐标误差不超过(1 + |x|) * expm1(h)
+    static float getMagnitude(const QuantizationParams& params, size_t axis, uint32_t level) {
+        return std::expm1(std::abs(std::fma(static_cast<float>(level), params.step[axis], params.offset[axis])));
+    }
+
+    // 满足各轴误差上限的最大步长位移：位移s时块内取整误差不超过2^(s - 1)个全局步长，加上全局量化本身的半个步长
+    static int chooseShift(const QuantizationParams& params, const QuantizationBlock& block, const std::array<uint32_t, 3>& extent,
+                           const std::array<float, 3>& maxError, int maxShift) {
+        int shift = maxShift;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            if (params.step[axis] <= 0.0f) {
+                continue;
+            }
+            const float magnitude = std::max(getMagnitude(params, axis, block.origin[axis]), getMagnitude(params, axis, block.origin[axis] + extent[axis]));
+            const float allowed = std::log1p(maxError[axis] / (1.0f + magnitude)) / params.step[axis];
+            int axisShift = 0;
+            while (axisShift < shift && static_cast<float>(1u << axisShift) + 0.5f <= allowed) {
+                ++axisShift;
+            }
+            shift = std::min(shift, axisShift);
+        }
+        return shift;
+    }
+
+    static void checkGridBitDepth(int gridBitDepth) {
+        // 全局网格坐标参与64位曲线排序键
+        if (gridBitDepth < 1 || gridBitDepth > 21) {
+            SPDLOG_ERROR("Invalid block quantization grid bit depth: {}", gridBitDepth);
+            throw std::runtime_error("Invalid block quantization grid bit depth: " + std::to_string(gridBitDepth));
+        }
+    }
+
+public:
+    /**
+     * @brief 分块量化
+     * @param positions 3列原始坐标，点的顺序任意
+     * @param gridBitDepth 全局网格的位深，决定量化步长，不超过21
+     * @param blockSize 每块的最大点数
+     * @param maxError 世界坐标下每轴的最大误差，不大于0时取全局网格在整帧最远点处的误差
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @throw std::invalid_argument 如果输入不是3个等长的非空坐标数组
+     * @throw std::runtime_error 如果位深或块大小无效
+     */
+    static BlockQuantizedPositions quantize(const std::vector<std::vector<float>>& positions, int gridBitDepth, size_t blockSize, float maxError = 0.0f,
+                                            size_t numThreads = 1, SpaceFillingCurve curve = SpaceFillingCurve::MORTON) {
+        checkGridBitDepth(gridBitDepth);
+        if (blockSize == 0 || blockSize > UINT32_MAX) {
+            throw std::runtime_error("Invalid quantization block size: " + std::to_string(blockSize));
+        }
+        auto preprocessed = PositionPreprocessor::process<uint32_t>(positions, gridBitDepth, numThreads, curve);
+        RadixSort::sortPairs(preprocessed.curveKeys, preprocessed.indices, numThreads);
+        preprocessed.curveKeys = {};
+        const auto& quantized = preprocessed.quantizedPositions;
+        const auto& sortedIndices = preprocessed.indices;
+
+        BlockQuantizedPositions result;
+        result.bbox = preprocessed.bbox;
+        result.gridBitDepth = gridBitDepth;
+        result.blocks = partition(quantized, sortedIndices, blockSize);
+        const size_t count = sortedIndices.size();
+        result.localPositions.assign(3, std::vector<uint16_t>(count));
+        result.order.resize(count);
+
+        const auto params = Quantization::makeParams(result.bbox, gridBitDepth);
+        const uint32_t maxLevel = (1u << gridBitDepth) - 1;
+        std::array<float, 3> axisMaxError;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            axisMaxError[axis] = maxError > 0.0f ? maxError
+                               : (1.0f + std::max(getMagnitude(params, axis, 0), getMagnitude(params, axis, maxLevel))) * std::expm1(0.5f * params.step[axis]);
+        }
+
+        // 块内坐标相对原点，曲线顺序与全局坐标不同，块内重新排序
+        Parallel::forRange(result.blocks.size(), numThreads, [&](size_t begin, size_t end) {
+            std::vector<uint16_t> axes[3];
+            std::vector<uint64_t> keys;
+            std::vector<uint32_t> permutation;
+            for (size_t b = begin; b < end; ++b) {
+                auto& block = result.blocks[b];
+                std::array<uint32_t, 3> extent{};
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    for (uint32_t i = 0; i < block.count; ++i) {
+                        extent[axis] = std::max(extent[axis], quantized[axis][sortedIndices[block.begin + i]] - block.origin[axis]);
+                    }
+                }
+                block.shift = chooseShift(params, block, extent, axisMaxError, gridBitDepth - 1);
+                const uint32_t half = block.shift > 0 ? 1u << (block.shift - 1) : 0u;
+                uint32_t maxLocal = 0;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    axes[axis].resize(block.count);
+                    for (uint32_t i = 0; i < block.count; ++i) {
+                        const uint32_t value = (quantized[axis][sortedIndices[block.begin + i]] - block.origin[axis] + half) >> block.shift;
+                        axes[axis][i] = static_cast<uint16_t>(value);
+                        maxLocal = std::max(maxLocal, value);
+                    }
+                }
+                block.bitDepth = std::max(1, static_cast<int>(std::bit_width(maxLocal)));
+
+                keys.resize(block.count);
+                permutation.resize(block.count);
+                CurveOrder::encode3DKeys(curve, axes[0].data(), axes[1].data(), axes[2].data(), keys.data(), block.count, block.bitDepth);
+                std::iota(permutation.begin(), permutation.end(), 0u);
+                RadixSort::sortPairs(keys, permutation, 1);
+                for (uint32_t i = 0; i < block.count; ++i) {
+                    const uint32_t source = permutation[i];
+                    for (size_t axis = 0; axis < 3; ++axis) {
+                        result.localPositions[axis][block.begin + i] = axes[axis][source];
+                    }
+                    result.order[block.begin + i] = sortedIndices[block.begin + source];
+                }
+            }
+        });
+        return result;
+    }
+
+    /**
+     * @brief 反量化反变换，得到原始坐标，点序与localPositions一致
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
+    static std::vector<std::vector<float>> dequantize(const BlockQuantizedPositions& positions, size_t numThreads = 1) {
+        const size_t count = positions.localPositions.empty() ? 0 : positions.localPositions[0].size();
+        const uint64_t maxLevel = (uint64_t{1} << positions.gridBitDepth) - 1;
+        std::vector<std::vector<uint32_t>> global(3, std::vector<uint32_t>(count));
+        Parallel::forRange(positions.blocks.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                const auto& block = positions.blocks[b];
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    for (uint32_t i = block.begin; i < block.begin + block.count; ++i) {
+                        // 块内取整可能越过全局网格的上界
+                        const uint64_t level = block.origin[axis] + (static_cast<uint64_t>(positions.localPositions[axis][i]) << block.shift);
+                        global[axis][i] = static_cast<uint32_t>(std::min(level, maxLevel));
+                    }
+                }
+            }
+        });
+        auto bbox = positions.bbox;
+        auto result = Quantization::dequantizePositionWithBBox<float, uint32_t>(global, bbox, positions.gridBitDepth, numThreads);
+        Transform::inverseLogTransformInPlace(result, bbox, numThreads);
+        return result;
+    }
+
+    /**
+     * @brief 编码块表与各块的八叉树，各块并行编码
+     * @throw std::runtime_error 如果块信息与坐标不一致
+     */
+    static std::vector<uint8_t> encode(const BlockQuantizedPositions& positions, SpaceFillingCurve curve, size_t numThreads = 1) {
+        const auto& blocks = positions.blocks;
+        std::vector<std::vector<uint8_t>> octrees(blocks.size());
+        Parallel::forRange(blocks.size(), numThreads, [&](size_t begin, size_t end) {
+            std::vector<std::vector<uint16_t>> local(3);
+            for (size_t b = begin; b < end; ++b) {
+                const auto& block = blocks[b];
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    const auto first = positions.localPositions[axis].begin() + block.begin;
+                    local[axis].assign(first, first + block.count);
+                }
+                octrees[b] = OctreeCoder::encode(local, block.bitDepth, curve);
+            }
+        });
+
+        const size_t count = positions.localPositions[0].size();
+        std::vector<uint8_t> bitstream;
+        append(bitstream, static_cast<uint32_t>(count));
+        append(bitstream, static_cast<uint8_t>(positions.gridBitDepth));
+        append(bitstream, static_cast<uint8_t>(curve));
+        for (const float value : positions.bbox.data) {
+            append(bitstream, value);
+        }
+        append(bitstream, static_cast<uint32_t>(blocks.size()));
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            append(bitstream, blocks[b].count);
+            for (const uint32_t value : blocks[b].origin) {
+                append(bitstream, value);
+            }
+            append(bitstream, static_cast<uint8_t>(blocks[b].shift));
+            append(bitstream, static_cast<uint8_t>(blocks[b].bitDepth));
+            append(bitstream, static_cast<uint32_t>(octrees[b].size()));
+        }
+        for (const auto& octree : octrees) {
+            bitstream.insert(bitstream.end(), octree.begin(), octree.end());
+        }
+        return bitstream;
+    }
+
+    /**
+     * @brief 解码块表与各块的八叉树，各块并行解码
+     * @throw std::runtime_error 如果码流损坏
+     */
+    static BlockQuantizedPositions decode(const uint8_t* bitstream, size_t size, size_t numThreads = 1) {
+        size_t offset = 0;
+        BlockQuantizedPositions result;
+        const size_t count = read<uint32_t>(bitstream, size, offset);
+        result.gridBitDepth = read<uint8_t>(bitstream, size, offset);
+        const uint8_t curve = read<uint8_t>(bitstream, size, offset);
+        checkGridBitDepth(result.gridBitDepth);
+        if (curve > static_cast<uint8_t>(SpaceFillingCurve::HILBERT)) {
+            throw std::runtime_error("Corrupted block quantized bitstream: invalid curve");
+        }
+        for (float& value : result.bbox.data) {
+            value = read<float>(bitstream, size, offset);
+        }
+        const size_t blockCount = read<uint32_t>(bitstream, size, offset);
+        if (blockCount > (size - offset) / BlockEntrySize) {
+            throw std::runtime_error("Truncated block quantized bitstream");
+        }
+
+        result.blocks.resize(blockCount);
+        std::vector<size_t> octreeOffsets(blockCount);
+        std::vector<size_t> octreeSizes(blockCount);
+        size_t pointTotal = 0;
+        size_t octreeOffset = offset + blockCount * BlockEntrySize;
+        for (size_t b = 0; b < blockCount; ++b) {
+            auto& block = result.blocks[b];
+            block.begin = static_cast<uint32_t>(pointTotal);
+            block.count = read<uint32_t>(bitstream, size, offset);
+            for (uint32_t& value : block.origin) {
+                value = read<uint32_t>(bitstream, size, offset);
+            }
+            block.shift = read<uint8_t>(bitstream, size, offset);
+            block.bitDepth = read<uint8_t>(bitstream, size, offset);
+            octreeSizes[b] = read<uint32_t>(bitstream, size, offset);
+            octreeOffsets[b] = octreeOffset;
+            if (block.shift >= result.gridBitDepth || block.bitDepth < 1 || block.bitDepth > MaxLocalBitDepth || octreeSizes[b] > size - octreeOffset || block.count > count - pointTotal) {
+                throw std::runtime_error("Corrupted block quantized bitstream: invalid block");
+            }
+            octreeOffset += octreeSizes[b];
+            pointTotal += block.count;
+        }
+        if (pointTotal != count) {
+            throw std::runtime_error("Corrupted block quantized bitstream: point count mismatch");
+        }
+
+        result.localPositions.assign(3, std::vector<uint16_t>(count));
+        Parallel::forRange(blockCount, numThreads, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                const auto& block = result.blocks[b];
+                const auto local = OctreeCoder::decode<uint16_t>(bitstream + octreeOffsets[b], octreeSizes[b]);
+                if (local[0].size() != block.count) {
+                    throw std::runtime_error("Corrupted block quantized bitstream: block size mismatch");
+                }
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    std::copy(local[axis].begin(), local[axis].end(), result.localPositions[axis].begin() + block.begin);
+                }
+            }
+        });
+        return result;
+    }
+
+    static BlockQuantizedPositions decode(const std::vector<uint8_t>& bitstream, size_t numThreads = 1) {
+        return decode(bitstream.data(), bitstream.size(), numThreads);
+    }
+};
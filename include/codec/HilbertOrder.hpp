@@ -0,0 +1,150 @@
+#pragma once
+
+#include "MortonOrder.hpp"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 3D希尔伯特曲线的状态机：24个朝向状态，每个状态给出8个子立方体(八分体，x在最低位)的访问次序和子状态
+// 相邻的希尔伯特码对应的格点总是相邻，避免莫顿序在块边界上的长距离跳跃
+class HilbertCurve {
+public:
+    static constexpr int States = 24;
+
+    // Rank[state][octant]：八分体在当前状态下的访问次序
+    static constexpr uint8_t Rank[States][8] = {
+        {0, 1, 3, 2, 7, 6, 4, 5}, {0, 7, 1, 6, 3, 4, 2, 5}, {0, 3, 7, 4, 1, 2, 6, 5}, {0, 1, 7, 6, 3, 2, 4, 5},
+        {6, 1, 5, 2, 7, 0, 4, 3}, {4, 3, 5, 2, 7, 0, 6, 1}, {4, 5, 3, 2, 7, 6, 0, 1}, {0, 7, 3, 4, 1, 6, 2, 5},
+        {6, 5, 7, 4, 1, 2, 0, 3}, {6, 1, 7, 0, 5, 2, 4, 3}, {6, 5, 1, 2, 7, 4, 0, 3}, {2, 5, 3, 4, 1, 6, 0, 7},
+        {4, 5, 7, 6, 3, 2, 0, 1}, {2, 5, 1, 6, 3, 4, 0, 7}, {4, 3, 7, 0, 5, 2, 6, 1}, {0, 3, 1, 2, 7, 4, 6, 5},
+        {4, 7, 5, 6, 3, 0, 2, 1}, {6, 7, 5, 4, 1, 0, 2, 3}, {4, 7, 3, 0, 5, 6, 2, 1}, {2, 3, 1, 0, 5, 4, 6, 7},
+        {2, 1, 3, 0, 5, 6, 4, 7}, {2, 1, 5, 6, 3, 0, 4, 7}, {6, 7, 1, 0, 5, 4, 2, 3}, {2, 3, 5, 4, 1, 0, 6, 7}
+    };
+
+    // Next[state][octant]：进入该八分体后的子状态，根节点为状态0
+    static constexpr uint8_t Next[States][8] = {
+        {1, 3, 4, 0, 5, 6, 7, 0}, {2, 18, 15, 16, 22, 3, 1, 1}, {0, 8, 12, 15, 7, 2, 14, 2}, {7, 0, 14, 12, 9, 3, 1, 3},
+        {10, 21, 4, 4, 15, 16, 17, 0}, {23, 6, 5, 5, 10, 21, 15, 16}, {11, 6, 5, 6, 4, 0, 13, 12}, {15, 16, 17, 0, 2, 18, 7, 7},
+        {9, 8, 3, 10, 11, 8, 6, 2}, {8, 20, 2, 18, 9, 9, 22, 3}, {4, 10, 13, 10, 0, 8, 12, 15}, {11, 11, 23, 6, 8, 20, 10, 21},
+        {13, 12, 9, 3, 14, 12, 11, 6}, {13, 13, 10, 21, 19, 12, 8, 20}, {19, 12, 8, 20, 14, 14, 2, 18}, {3, 10, 1, 15, 6, 2, 5, 15},
+        {21, 22, 16, 1, 18, 23, 16, 5}, {22, 1, 17, 4, 23, 5, 17, 7}, {20, 17, 16, 19, 18, 7, 18, 14}, {19, 13, 22, 9, 19, 14, 23, 11},
+        {20, 9, 21, 22, 20, 11, 18, 23}, {21, 4, 21, 13, 20, 17, 16, 19}, {17, 7, 19, 14, 22, 9, 22, 1}, {23, 11, 23, 5, 17, 4, 19, 13}
+    };
+};
+
+// 希尔伯特码生成：先用运行时分派的莫顿内核把坐标交织为八分体序列，再查表逐层把八分体换成访问次序
+class HilbertEncoder {
+private:
+    // 每次查表处理的层数，表项为 次序(9位) | 子状态 << 9，共24 * 512项
+    static constexpr int LevelsPerLookup = 3;
+    static constexpr int DigitBits = LevelsPerLookup * 3;
+    static constexpr uint32_t Digits = 1u << DigitBits;
+
+    static constexpr std::array<uint16_t, HilbertCurve::States * Digits> makeTable() {
+        std::array<uint16_t, HilbertCurve::States * Digits> table{};
+        for (uint32_t state = 0; state < HilbertCurve::States; ++state) {
+            for (uint32_t digits = 0; digits < Digits; ++digits) {
+                uint32_t current = state;
+                uint32_t rank = 0;
+                for (int level = LevelsPerLookup - 1; level >= 0; --level) {
+                    const uint32_t octant = (digits >> (level * 3)) & 7;
+                    rank = (rank << 3) | HilbertCurve::Rank[current][octant];
+                    current = HilbertCurve::Next[current][octant];
+                }
+                table[state * Digits + digits] = static_cast<uint16_t>(rank | current << DigitBits);
+            }
+        }
+        return table;
+    }
+
+    static const std::array<uint16_t, HilbertCurve::States * Digits>& getTable() {
+        static constexpr auto table = makeTable();
+        return table;
+    }
+
+public:
+    static constexpr int MaxBitsPerDimension = MortonKernels::MaxBitsPerDimension;
+
+    /**
+     * @brief 将莫顿码原地转换为希尔伯特码
+     * @param keys 莫顿码，每维只使用低bitDepth位
+     * @param bitDepth 每维位深，决定曲线根节点的尺度，同一批排序的码必须使用相同位深
+     */
+    static void convertMortonKeys(uint64_t* keys, size_t count, int bitDepth) {
+        const auto& table = getTable();
+        // 位深不是3的倍数时，先按单层处理最高的几层
+        const int leadingLevels = bitDepth % LevelsPerLookup;
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t morton = keys[i];
+            uint64_t hilbert = 0;
+            uint32_t state = 0;
+            int level = bitDepth - 1;
+            for (; level >= bitDepth - leadingLevels; --level) {
+                const uint32_t octant = static_cast<uint32_t>(morton >> (level * 3)) & 7;
+                hilbert = (hilbert << 3) | HilbertCurve::Rank[state][octant];
+                state = HilbertCurve::Next[state][octant];
+            }
+            for (; level >= 0; level -= LevelsPerLookup) {
+                const uint32_t digits = static_cast<uint32_t>(morton >> ((level - LevelsPerLookup + 1) * 3)) & (Digits - 1);
+                const uint32_t entry = table[state * Digits + digits];
+                hilbert = (hilbert << DigitBits) | (entry & (Digits - 1));
+                state = entry >> DigitBits;
+            }
+            keys[i] = hilbert;
+        }
+    }
+
+    // 批量计算count个点的3D希尔伯特码，坐标需小于2^bitDepth
+    template<typename CoordinateType>
+    static void encode3DHilbertKeys(const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count, int bitDepth) {
+        checkBitDepth(bitDepth);
+        MortonEncoder::encode3DMortonKeys(x, y, z, keys, count);
+        convertMortonKeys(keys, count, bitDepth);
+    }
+
+    static uint64_t encode3DHilbertIndex(uint32_t x, uint32_t y, uint32_t z, int bitDepth) {
+        checkBitDepth(bitDepth);
+        uint64_t key = MortonEncoder::encode3DMortonIndex(x, y, z);
+        convertMortonKeys(&key, 1, bitDepth);
+        return key;
+    }
+
+    /**
+     * @brief 计算3D坐标的希尔伯特序
+     * @param coordinates 3列坐标{x, y, z}
+     * @param bitDepth 每维位深
+     * @param numThreads 计算希尔伯特码与基数排序的线程数，0表示使用全部硬件线程
+     * @return 按希尔伯特码升序排列的点索引，码相同的点保持原有顺序
+     */
+    template<typename IndicesType = uint64_t, typename CoordinateType = uint32_t>
+    static std::vector<IndicesType> encode3DHilbertIndices(const std::vector<std::vector<CoordinateType>>& coordinates, int bitDepth, size_t numThreads = 1) {
+        if (coordinates.size() != 3) {
+            throw std::runtime_error("Dimension mismatch in encode3DHilbertIndices");
+        }
+        checkBitDepth(bitDepth);
+
+        const size_t numPoints = coordinates[0].size();
+        std::vector<uint64_t> hilbertKeys(numPoints);
+        std::vector<IndicesType> indices(numPoints);
+        std::iota(indices.begin(), indices.end(), 0);
+
+        Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+            encode3DHilbertKeys(coordinates[0].data() + begin, coordinates[1].data() + begin, coordinates[2].data() + begin,
+                                hilbertKeys.data() + begin, end - begin, bitDepth);
+        }, 1 << 16);
+
+        RadixSort::sortPairs(hilbertKeys, indices, numThreads);
+        return indices;
+    }
+
+private:
+    static void checkBitDepth(int bitDepth) {
+        if (bitDepth < 1 || bitDepth > MaxBitsPerDimension) {
+            SPDLOG_ERROR("Invalid Hilbert bit depth: {}", bitDepth);
+            throw std::runtime_error("Invalid Hilbert bit depth: " + std::to_string(bitDepth));
+        }
+    }
+};
@@ -1,57 +1,322 @@
 #pragma once
 
+#include "utils/CpuFeatures.hpp"
+#include "utils/Parallel.hpp"
+#include "utils/RadixSort.hpp"
+#include <array>
 #include <cstdint>
-#include <morton-nd/mortonND_BMI2.h>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 #include <stdexcept>
 #include <numeric>
 #include <algorithm>
 
-// Morton编码辅助类，基于morton-nd库实现
+// 3D莫顿码的编解码内核：每维最多21位，x在最低位，z在最高位
+// 提供魔数位运算/查表、BMI2(PDEP/PEXT)和AVX2三类实现，运行时按CPU特性选择
+class MortonKernels {
+public:
+    static constexpr int MaxBitsPerDimension = 21;
+
+    enum class Kind {
+        LUT,
+        AVX2,
+        BMI2
+    };
+
+    // PDEP/PEXT快速时优先使用BMI2，否则使用AVX2一次处理4个点，都不支持时编码查表、解码用魔数位运算
+    static Kind select() {
+        const auto& features = CpuFeatures::get();
+        if (features.hasFastBmi2()) return Kind::BMI2;
+        if (features.hasAvx2()) return Kind::AVX2;
+        return Kind::LUT;
+    }
+
+    static Kind get() {
+        static const Kind kind = select();
+        return kind;
+    }
+
+    // 将value的低21位分散到每3位中的最低位
+    static constexpr uint64_t splitBy3(uint64_t value) {
+        value &= 0x1FFFFF;
+        value = (value | value << 32) & 0x1F00000000FFFFull;
+        value = (value | value << 16) & 0x1F0000FF0000FFull;
+        value = (value | value << 8) & 0x100F00F00F00F00Full;
+        value = (value | value << 4) & 0x10C30C30C30C30C3ull;
+        value = (value | value << 2) & 0x1249249249249249ull;
+        return value;
+    }
+
+    // splitBy3的逆运算，取出每3位中的最低位
+    static constexpr uint64_t compactBy3(uint64_t value) {
+        value &= 0x1249249249249249ull;
+        value = (value ^ (value >> 2)) & 0x10C30C30C30C30C3ull;
+        value = (value ^ (value >> 4)) & 0x100F00F00F00F00Full;
+        value = (value ^ (value >> 8)) & 0x1F0000FF0000FFull;
+        value = (value ^ (value >> 16)) & 0x1F00000000FFFFull;
+        value = (value ^ (value >> 32)) & 0x1FFFFF;
+        return value;
+    }
+
+    static constexpr uint64_t encode(uint64_t x, uint64_t y, uint64_t z) {
+        return splitBy3(x) | splitBy3(y) << 1 | splitBy3(z) << 2;
+    }
+
+    static constexpr std::tuple<uint32_t, uint32_t, uint32_t> decode(uint64_t key) {
+        return {static_cast<uint32_t>(compactBy3(key)), static_cast<uint32_t>(compactBy3(key >> 1)), static_cast<uint32_t>(compactBy3(key >> 2))};
+    }
+
+private:
+    // 编码表：8位值分散到24位中每3位的最低位
+    static constexpr std::array<uint32_t, 256> makeEncodeTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            table[i] = static_cast<uint32_t>(splitBy3(i));
+        }
+        return table;
+    }
+
+    static const std::array<uint32_t, 256>& encodeTable() {
+        static constexpr auto table = makeEncodeTable();
+        return table;
+    }
+
+    static constexpr uint64_t XMask = 0x1249249249249249ull;
+
+public:
+    template<typename CoordinateType>
+    static void encodeLut(const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count) {
+        const auto& table = encodeTable();
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t xi = static_cast<uint32_t>(x[i]);
+            const uint32_t yi = static_cast<uint32_t>(y[i]);
+            const uint32_t zi = static_cast<uint32_t>(z[i]);
+            uint64_t key = 0;
+            // 21位分为8 + 8 + 5位三段
+            for (int shift = 16; shift >= 0; shift -= 8) {
+                const uint32_t mask = shift == 16 ? 0x1F : 0xFF;
+                const uint64_t chunk = table[(xi >> shift) & mask]
+                                     | table[(yi >> shift) & mask] << 1
+                                     | table[(zi >> shift) & mask] << 2;
+                key = key << 24 | chunk;
+            }
+            keys[i] = key;
+        }
+    }
+
+    // 解码时魔数位运算比按9位分段查表更快，标量路径直接使用
+    template<typename CoordinateType>
+    static void decodeScalar(const uint64_t* keys, size_t count, CoordinateType* x, CoordinateType* y, CoordinateType* z) {
+        for (size_t i = 0; i < count; ++i) {
+            x[i] = static_cast<CoordinateType>(compactBy3(keys[i]));
+            y[i] = static_cast<CoordinateType>(compactBy3(keys[i] >> 1));
+            z[i] = static_cast<CoordinateType>(compactBy3(keys[i] >> 2));
+        }
+    }
+
+#if defined(GS_ARCH_X86)
+    template<typename CoordinateType>
+    GS_TARGET_BMI2 static void encodeBmi2(const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            keys[i] = _pdep_u64(static_cast<uint64_t>(x[i]), XMask)
+                    | _pdep_u64(static_cast<uint64_t>(y[i]), XMask << 1)
+                    | _pdep_u64(static_cast<uint64_t>(z[i]), XMask << 2);
+        }
+    }
+
+    template<typename CoordinateType>
+    GS_TARGET_BMI2 static void decodeBmi2(const uint64_t* keys, size_t count, CoordinateType* x, CoordinateType* y, CoordinateType* z) {
+        for (size_t i = 0; i < count; ++i) {
+            x[i] = static_cast<CoordinateType>(_pext_u64(keys[i], XMask));
+            y[i] = static_cast<CoordinateType>(_pext_u64(keys[i], XMask << 1));
+            z[i] = static_cast<CoordinateType>(_pext_u64(keys[i], XMask << 2));
+        }
+    }
+
+private:
+    GS_TARGET_AVX2 static __m256i splitBy3Avx2(__m256i value) {
+        value = _mm256_and_si256(value, _mm256_set1_epi64x(0x1FFFFF));
+        value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 32)), _mm256_set1_epi64x(0x1F00000000FFFFll));
+        value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 16)), _mm256_set1_epi64x(0x1F0000FF0000FFll));
+        value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 8)), _mm256_set1_epi64x(0x100F00F00F00F00Fll));
+        value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 4)), _mm256_set1_epi64x(0x10C30C30C30C30C3ll));
+        value = _mm256_and_si256(_mm256_or_si256(value, _mm256_slli_epi64(value, 2)), _mm256_set1_epi64x(0x1249249249249249ll));
+        return value;
+    }
+
+    GS_TARGET_AVX2 static __m256i compactBy3Avx2(__m256i value) {
+        value = _mm256_and_si256(value, _mm256_set1_epi64x(0x1249249249249249ll));
+        value = _mm256_and_si256(_mm256_xor_si256(value, _mm256_srli_epi64(value, 2)), _mm256_set1_epi64x(0x10C30C30C30C30C3ll));
+        value = _mm256_and_si256(_mm256_xor_si256(value, _mm256_srli_epi64(value, 4)), _mm256_set1_epi64x(0x100F00F00F00F00Fll));
+        value = _mm256_and_si256(_mm256_xor_si256(value, _mm256_srli_epi64(value, 8)), _mm256_set1_epi64x(0x1F0000FF0000FFll));
+        value = _mm256_and_si256(_mm256_xor_si256(value, _mm256_srli_epi64(value, 16)), _mm256_set1_epi64x(0x1F00000000FFFFll));
+        value = _mm256_and_si256(_mm256_xor_si256(value, _mm256_srli_epi64(value, 32)), _mm256_set1_epi64x(0x1FFFFF));
+        return value;
+    }
+
+    // 读取4个坐标并零扩展到64位
+    template<typename CoordinateType>
+    GS_TARGET_AVX2 static __m256i load4Avx2(const CoordinateType* src) {
+        if constexpr (sizeof(CoordinateType) == 2) {
+            return _mm256_cvtepu16_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+        } else {
+            return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+        }
+    }
+
+    // 将4个64位通道的低位截断后写出
+    template<typename CoordinateType>
+    GS_TARGET_AVX2 static void store4Avx2(CoordinateType* dst, __m256i value) {
+        const __m128i packed = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(value, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+        if constexpr (sizeof(CoordinateType) == 2) {
+            // 与标量路径一致按位截断，不做饱和
+            const __m128i lowHalves = _mm_shuffle_epi8(packed, _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), lowHalves);
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), packed);
+        }
+    }
+
+public:
+    // 返回已处理的点数，尾部由调用方补齐
+    template<typename CoordinateType>
+    GS_TARGET_AVX2 static size_t encodeAvx2(const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m256i key = _mm256_or_si256(_mm256_or_si256(splitBy3Avx2(load4Avx2(x + i)),
+                                                                _mm256_slli_epi64(splitBy3Avx2(load4Avx2(y + i)), 1)),
+                                                _mm256_slli_epi64(splitBy3Avx2(load4Avx2(z + i)), 2));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(keys + i), key);
+        }
+        return i;
+    }
+
+    template<typename CoordinateType>
+    GS_TARGET_AVX2 static size_t decodeAvx2(const uint64_t* keys, size_t count, CoordinateType* x, CoordinateType* y, CoordinateType* z) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+            store4Avx2(x + i, compactBy3Avx2(key));
+            store4Avx2(y + i, compactBy3Avx2(_mm256_srli_epi64(key, 1)));
+            store4Avx2(z + i, compactBy3Avx2(_mm256_srli_epi64(key, 2)));
+        }
+        return i;
+    }
+#endif
+
+    template<typename CoordinateType>
+    static void encode(Kind kind, const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count) {
+        static_assert(std::is_unsigned_v<CoordinateType> && sizeof(CoordinateType) <= 4, "CoordinateType must be an unsigned integer of at most 32 bits");
+        size_t i = 0;
+#if defined(GS_ARCH_X86)
+        if (kind == Kind::BMI2) {
+            encodeBmi2(x, y, z, keys, count);
+            return;
+        }
+        if constexpr (sizeof(CoordinateType) >= 2) {
+            if (kind == Kind::AVX2) {
+                i = encodeAvx2(x, y, z, keys, count);
+            }
+        }
+#endif
+        encodeLut(x + i, y + i, z + i, keys + i, count - i);
+    }
+
+    template<typename CoordinateType>
+    static void decode(Kind kind, const uint64_t* keys, size_t count, CoordinateType* x, CoordinateType* y, CoordinateType* z) {
+        static_assert(std::is_unsigned_v<CoordinateType> && sizeof(CoordinateType) <= 4, "CoordinateType must be an unsigned integer of at most 32 bits");
+        size_t i = 0;
+#if defined(GS_ARCH_X86)
+        if (kind == Kind::BMI2) {
+            decodeBmi2(keys, count, x, y, z);
+            return;
+        }
+        if constexpr (sizeof(CoordinateType) >= 2) {
+            if (kind == Kind::AVX2) {
+                i = decodeAvx2(keys, count, x, y, z);
+            }
+        }
+#endif
+        decodeScalar(keys + i, count - i, x + i, y + i, z + i);
+    }
+};
+
+// Morton编码辅助类
 class MortonEncoder {
 public:
+    // 单个点的3D莫顿码，每维只取低21位
+    static constexpr uint64_t encode3DMortonIndex(uint32_t x, uint32_t y, uint32_t z) {
+        return MortonKernels::encode(x, y, z);
+    }
+
+    // 批量计算count个点的3D莫顿码，x在最低位，z在最高位；坐标超过21位的部分被忽略
+    template<typename CoordinateType>
+    static void encode3DMortonKeys(const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count) {
+        MortonKernels::encode(MortonKernels::get(), x, y, z, keys, count);
+    }
+
+    /**
+     * @brief 计算3D坐标的莫顿序
+     * @param coordinates 3列坐标{x, y, z}
+     * @param numThreads 计算莫顿码与基数排序的线程数，0表示使用全部硬件线程
+     * @return 按莫顿码升序排列的点索引，莫顿码相同的点保持原有顺序
+     */
     template<typename IndicesType = uint64_t, typename CoordinateType = uint32_t>
-    static std::vector<IndicesType> encode3DMortonIndices(const std::vector<std::vector<CoordinateType>>& coordinates) {
+    static std::vector<IndicesType> encode3DMortonIndices(const std::vector<std::vector<CoordinateType>>& coordinates, size_t numThreads = 1) {
         const size_t Dimensions = 3;
         if(coordinates.size() != Dimensions) {
             throw std::runtime_error("Dimension mismatch in calculateMortonIndices");
         }
 
         size_t numPoints = coordinates[0].size();
-        std::vector<IndicesType> mortonIndices(numPoints);
+        std::vector<uint64_t> mortonIndices(numPoints);
         std::vector<IndicesType> indices(numPoints);
 
         std::iota(indices.begin(), indices.end(), 0);
 
-        using MortonND = mortonnd::MortonNDBmi<Dimensions, IndicesType>;
-        // auto [quantizedPositions, bbox] = Quantization::quantizePosition<uint32_t, float, MortonND::FieldBits>(coordinates);
+        Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+            encode3DMortonKeys(coordinates[0].data() + begin, coordinates[1].data() + begin, coordinates[2].data() + begin,
+                               mortonIndices.data() + begin, end - begin);
+        }, 1 << 16);
 
-        for(size_t i = 0; i < numPoints; ++i) {
-            auto& x = coordinates[0][i];
-            auto& y = coordinates[1][i];
-            auto& z = coordinates[2][i];
-            mortonIndices[i] = MortonND::Encode(z, y, x);
-        }
-
-        std::sort(indices.begin(), indices.end(),
-            [&mortonIndices](IndicesType a, IndicesType b) {
-                return mortonIndices[a] < mortonIndices[b];
-            }
-        );
+        // 对(莫顿码, 索引)对做基数排序，取值恒定的高位段会被跳过
+        RadixSort::sortPairs(mortonIndices, indices, numThreads);
 
         return indices;
     }
 };
 
 class MortonDecoder{
+private:
+    // 取出奇数或偶数位
+    static constexpr uint64_t compactBy2(uint64_t value) {
+        value &= 0x5555555555555555ull;
+        value = (value | (value >> 1)) & 0x3333333333333333ull;
+        value = (value | (value >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+        value = (value | (value >> 4)) & 0x00FF00FF00FF00FFull;
+        value = (value | (value >> 8)) & 0x0000FFFF0000FFFFull;
+        value = (value | (value >> 16)) & 0x00000000FFFFFFFFull;
+        return value;
+    }
+
 public:
+    // 返回{高位维, 低位维}，与编码时的参数顺序一致
     template<typename T>
     static std::tuple<T, T> decode2DMortonIndex(T mortonIndex) {
-        const size_t Dimensions = 2;
-        using MortonND = mortonnd::MortonNDBmi<Dimensions, T>;
+        static_assert(std::is_unsigned_v<T> && sizeof(T) <= 8, "T must be an unsigned integer of at most 64 bits");
+        const uint64_t key = static_cast<uint64_t>(mortonIndex);
+        return {static_cast<T>(compactBy2(key >> 1)), static_cast<T>(compactBy2(key))};
+    }
 
-        return MortonND::Decode(mortonIndex);
+    // 单个3D莫顿码解码为{x, y, z}
+    static constexpr std::tuple<uint32_t, uint32_t, uint32_t> decode3DMortonIndex(uint64_t key) {
+        return MortonKernels::decode(key);
     }
 
-};
\ No newline at end of file
+    // 批量解码count个3D莫顿码，与MortonEncoder::encode3DMortonKeys互逆
+    template<typename CoordinateType>
+    static void decode3DMortonKeys(const uint64_t* keys, size_t count, CoordinateType* x, CoordinateType* y, CoordinateType* z) {
+        MortonKernels::decode(MortonKernels::get(), keys, count, x, y, z);
+    }
+};
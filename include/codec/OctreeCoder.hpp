@@ -0,0 +1,305 @@
+#pragma once
+
+#include "RangeCoder.hpp"
+#include "SpaceFillingCurve.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 基于八叉树占用码的几何编码器
+// 输入为已按空间填充曲线(莫顿或希尔伯特)排列的量化坐标，逐层广度优先地编码每个节点的子节点占用字节，
+// 子节点按曲线规定的次序展开；占用字节的每一位使用以父节点占用数和已编码位为上下文的自适应二元区间编码；叶节点编码重复点数。
+// 解码按同样的广度优先顺序展开，输出的点天然保持曲线顺序，与编码端属性的排列一致，无需重新排序。
+class OctreeCoder {
+private:
+    // 码流头：点数(uint32) + 每维位深(uint8) + 曲线类型(uint8)
+    static constexpr size_t HeaderSize = 6;
+    static constexpr int MaxBitDepth = 32;
+
+public:
+    // 以下为逐节点编码的基本操作，渐进式编码按层复用同一套上下文模型
+
+    // 占用字节的上下文模型：父节点占用数(1~8) x 二叉树节点(1~255)
+    struct OccupancyModels {
+        std::array<AdaptiveBitModel, 8 * 256> bits;
+        AdaptiveBitModel duplicate;
+        std::array<AdaptiveBitModel, 32> countPrefix;
+    };
+
+    template<typename CoordinateType>
+    static int getOctant(const std::vector<std::vector<CoordinateType>>& positions, size_t index, int shift) {
+        // 与MortonEncoder保持一致：x在最低位，z在最高位
+        return static_cast<int>((positions[0][index] >> shift) & 1u)
+             | static_cast<int>((positions[1][index] >> shift) & 1u) << 1
+             | static_cast<int>((positions[2][index] >> shift) & 1u) << 2;
+    }
+
+    static void encodeOccupancy(RangeEncoder& encoder, OccupancyModels& models, uint8_t occupancy, int parentOccupied) {
+        AdaptiveBitModel* contextModels = &models.bits[static_cast<size_t>(parentOccupied - 1) * 256];
+        uint32_t node = 1;
+        for (int i = 0; i < 8; ++i) {
+            const int bit = (occupancy >> i) & 1;
+            // 前7位全为0时最后一位必为1
+            if (node != 0x80) {
+                encoder.encodeBit(contextModels[node], bit);
+            }
+            node = (node << 1) | static_cast<uint32_t>(bit);
+        }
+    }
+
+    static uint8_t decodeOccupancy(RangeDecoder& decoder, OccupancyModels& models, int parentOccupied) {
+        AdaptiveBitModel* contextModels = &models.bits[static_cast<size_t>(parentOccupied - 1) * 256];
+        uint32_t node = 1;
+        for (int i = 0; i < 8; ++i) {
+            const int bit = node != 0x80 ? decoder.decodeBit(contextModels[node]) : 1;
+            node = (node << 1) | static_cast<uint32_t>(bit);
+        }
+        // 二叉树路径的低8位即为按位序排列的占用字节的位反转
+        uint8_t occupancy = 0;
+        for (int i = 0; i < 8; ++i) {
+            occupancy |= static_cast<uint8_t>(((node >> (7 - i)) & 1u) << i);
+        }
+        return occupancy;
+    }
+
+    // 叶节点重复点数：先编码是否重复，再以指数哥伦布码编码count - 2
+    static void encodeCount(RangeEncoder& encoder, OccupancyModels& models, uint32_t count) {
+        encoder.encodeBit(models.duplicate, count > 1);
+        if (count <= 1) {
+            return;
+        }
+        const uint32_t value = count - 1;
+        const int prefix = std::bit_width(value) - 1;
+        for (int i = 0; i < prefix; ++i) {
+            encoder.encodeBit(models.countPrefix[i], 1);
+        }
+        if (prefix < 31) {
+            encoder.encodeBit(models.countPrefix[prefix], 0);
+        }
+        encoder.encodeDirectBits(value, prefix);
+    }
+
+    static uint32_t decodeCount(RangeDecoder& decoder, OccupancyModels& models) {
+        if (!decoder.decodeBit(models.duplicate)) {
+            return 1;
+        }
+        int prefix = 0;
+        while (prefix < 31 && decoder.decodeBit(models.countPrefix[prefix])) {
+            ++prefix;
+        }
+        const uint32_t value = (1u << prefix) | decoder.decodeDirectBits(prefix);
+        return value + 1;
+    }
+
+    /**
+     * @brief 编码已按曲线顺序排列的量化坐标
+     * @param sortedPositions 3列量化坐标{x, y, z}，需按curve排列
+     * @param bitDepth 每维坐标的位深
+     * @param curve 点的排列顺序，写入码流，解码输出相同的顺序
+     * @return 几何码流
+     * @throw std::runtime_error 如果输入维度不匹配、坐标超出位深或未按曲线顺序排列
+     */
+    template<typename CoordinateType>
+    static std::vector<uint8_t> encode(const std::vector<std::vector<CoordinateType>>& sortedPositions, int bitDepth,
+                                       SpaceFillingCurve curve = SpaceFillingCurve::MORTON) {
+        static_assert(std::is_unsigned_v<CoordinateType>, "CoordinateType must be unsigned");
+        if (sortedPositions.size() != 3
+            || sortedPositions[1].size() != sortedPositions[0].size()
+            || sortedPositions[2].size() != sortedPositions[0].size()) {
+            throw std::runtime_error("Octree coding requires 3 coordinate arrays of equal length");
+        }
+        if (bitDepth < 1 || bitDepth > MaxBitDepth || bitDepth > static_cast<int>(sizeof(CoordinateType) * 8)) {
+            SPDLOG_ERROR("Invalid octree bit depth: {}", bitDepth);
+            throw std::runtime_error("Invalid octree bit depth: " + std::to_string(bitDepth));
+        }
+        const size_t count = sortedPositions[0].size();
+        if (count > UINT32_MAX) {
+            throw std::runtime_error("Too many points for octree coding");
+        }
+        if (bitDepth < static_cast<int>(sizeof(CoordinateType) * 8)) {
+            for (const auto& axis : sortedPositions) {
+                for (const auto value : axis) {
+                    if ((static_cast<uint64_t>(value) >> bitDepth) != 0) {
+                        SPDLOG_ERROR("Coordinate {} exceeds octree bit depth {}", static_cast<uint64_t>(value), bitDepth);
+                        throw std::runtime_error("Coordinate exceeds octree bit depth");
+                    }
+                }
+            }
+        }
+
+        std::vector<uint8_t> bitstream(HeaderSize);
+        const uint32_t pointCount = static_cast<uint32_t>(count);
+        std::memcpy(bitstream.data(), &pointCount, sizeof(pointCount));
+        bitstream[4] = static_cast<uint8_t>(bitDepth);
+        bitstream[5] = static_cast<uint8_t>(curve);
+        if (count == 0) {
+            return bitstream;
+        }
+
+        // 每个节点对应排序后数组中的一个连续区间
+        struct Node {
+            uint32_t begin;
+            uint32_t end;
+            uint8_t parentOccupied;
+            uint8_t state;
+        };
+
+        const auto& traversal = CurveOrder::getTraversal(curve);
+        auto models = std::make_unique<OccupancyModels>();
+        RangeEncoder encoder;
+        std::vector<Node> nodes{{0, pointCount, 8, 0}};
+        std::vector<Node> children;
+        for (int level = 0; level < bitDepth; ++level) {
+            const int shift = bitDepth - 1 - level;
+            children.clear();
+            children.reserve(nodes.size() * 2);
+            for (const auto& node : nodes) {
+                uint8_t occupancy = 0;
+                const size_t firstChild = children.size();
+                const auto& rank = traversal.rank[node.state];
+                int previousOctant = -1;
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    const int octant = getOctant(sortedPositions, i, shift);
+                    if (octant == previousOctant) {
+                        continue;
+                    }
+                    if (previousOctant >= 0 && rank[octant] < rank[previousOctant]) {
+                        SPDLOG_ERROR("Positions are not in {} order at index {}", CurveOrder::getName(curve), i);
+                        throw std::runtime_error("Octree coding requires positions sorted along the curve");
+                    }
+                    if (previousOctant >= 0) {
+                        children.back().end = i;
+                    }
+                    children.push_back({i, node.end, 0, traversal.next[node.state][octant]});
+                    occupancy |= static_cast<uint8_t>(1u << octant);
+                    previousOctant = octant;
+                }
+
+                encodeOccupancy(encoder, *models, occupancy, node.parentOccupied);
+                const uint8_t occupied = static_cast<uint8_t>(std::popcount(occupancy));
+                for (size_t c = firstChild; c < children.size(); ++c) {
+                    children[c].parentOccupied = occupied;
+                }
+            }
+            nodes.swap(children);
+        }
+
+        for (const auto& node : nodes) {
+            encodeCount(encoder, *models, node.end - node.begin);
+        }
+
+        auto payload = encoder.finish();
+        bitstream.insert(bitstream.end(), payload.begin(), payload.end());
+        return bitstream;
+    }
+
+    /**
+     * @brief 解码几何码流，输出按编码时的曲线顺序排列的量化坐标
+     * @param bitstream 由encode生成的码流
+     * @return 3列量化坐标{x, y, z}
+     * @throw std::runtime_error 如果码流损坏或位深超出CoordinateType
+     */
+    template<typename CoordinateType>
+    static std::vector<std::vector<CoordinateType>> decode(const uint8_t* bitstream, size_t size) {
+        static_assert(std::is_unsigned_v<CoordinateType>, "CoordinateType must be unsigned");
+        if (size < HeaderSize) {
+            throw std::runtime_error("Truncated octree bitstream");
+        }
+        uint32_t pointCount;
+        std::memcpy(&pointCount, bitstream, sizeof(pointCount));
+        const int bitDepth = bitstream[4];
+        if (bitDepth < 1 || bitDepth > static_cast<int>(sizeof(CoordinateType) * 8)) {
+            SPDLOG_ERROR("Octree bit depth {} does not fit the coordinate type", bitDepth);
+            throw std::runtime_error("Invalid octree bit depth in bitstream");
+        }
+        const uint8_t curveId = bitstream[5];
+        if (curveId > static_cast<uint8_t>(SpaceFillingCurve::HILBERT)) {
+            SPDLOG_ERROR("Unknown space filling curve {} in octree bitstream", curveId);
+            throw std::runtime_error("Invalid curve in octree bitstream");
+        }
+        const auto& traversal = CurveOrder::getTraversal(static_cast<SpaceFillingCurve>(curveId));
+
+        std::vector<std::vector<CoordinateType>> positions(3);
+        for (auto& axis : positions) {
+            axis.reserve(pointCount);
+        }
+        if (pointCount == 0) {
+            return positions;
+        }
+
+        struct Node {
+            uint32_t x;
+            uint32_t y;
+            uint32_t z;
+            uint8_t parentOccupied;
+            uint8_t state;
+        };
+
+        auto models = std::make_unique<OccupancyModels>();
+        RangeDecoder decoder(bitstream + HeaderSize, size - HeaderSize);
+        std::vector<Node> nodes{{0, 0, 0, 8, 0}};
+        std::vector<Node> children;
+        for (int level = 0; level < bitDepth; ++level) {
+            children.clear();
+            children.reserve(nodes.size() * 2);
+            for (const auto& node : nodes) {
+                const uint8_t occupancy = decodeOccupancy(decoder, *models, node.parentOccupied);
+                const uint8_t occupied = static_cast<uint8_t>(std::popcount(occupancy));
+                for (uint32_t rank = 0; rank < 8; ++rank) {
+                    const uint32_t octant = traversal.octant[node.state][rank];
+                    if ((occupancy >> octant) & 1u) {
+                        children.push_back({(node.x << 1) | (octant & 1u),
+                                            (node.y << 1) | ((octant >> 1) & 1u),
+                                            (node.z << 1) | ((octant >> 2) & 1u),
+                                            occupied,
+                                            traversal.next[node.state][octant]});
+                    }
+                }
+            }
+            // 每个被占用的节点至少包含一个点
+            if (children.size() > pointCount) {
+                throw std::runtime_error("Corrupted octree bitstream: too many occupied nodes");
+            }
+            nodes.swap(children);
+        }
+
+        for (const auto& node : nodes) {
+            const uint32_t count = decodeCount(decoder, *models);
+            if (count > pointCount - positions[0].size()) {
+                throw std::runtime_error("Corrupted octree bitstream: too many points");
+            }
+            positions[0].insert(positions[0].end(), count, static_cast<CoordinateType>(node.x));
+            positions[1].insert(positions[1].end(), count, static_cast<CoordinateType>(node.y));
+            positions[2].insert(positions[2].end(), count, static_cast<CoordinateType>(node.z));
+        }
+        if (positions[0].size() != pointCount) {
+            SPDLOG_ERROR("Octree bitstream decoded {} points, expected {}", positions[0].size(), pointCount);
+            throw std::runtime_error("Corrupted octree bitstream: point count mismatch");
+        }
+
+        return positions;
+    }
+
+    template<typename CoordinateType>
+    static std::vector<std::vector<CoordinateType>> decode(const std::vector<uint8_t>& bitstream) {
+        return decode<CoordinateType>(bitstream.data(), bitstream.size());
+    }
+
+    /**
+     * @brief 码流记录的量化位深，反量化时需要与之一致
+     * @throw std::runtime_error 如果码流头不完整
+     */
+    static int getBitDepth(const uint8_t* bitstream, size_t size) {
+        if (size < HeaderSize) {
+            throw std::runtime_error("Truncated octree bitstream");
+        }
+        return bitstream[4];
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Quantization.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "Transform.hpp"
+#include "utils/Parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 位置预处理的结果，点仍保持输入顺序
+template<typename QuantizedType>
+struct PreprocessedPositions {
+    // 对数域的包围盒，反量化时使用
+    BoundingBox3D bbox;
+    std::vector<std::vector<QuantizedType>> quantizedPositions;
+    // 空间填充曲线上的排序键
+    std::vector<uint64_t> curveKeys;
+    // 与curveKeys一一对应的点索引，按排序键排序后即为重排用的排列
+    std::vector<uint32_t> indices;
+};
+
+// 融合的位置预处理：第一遍并行归约求包围盒，第二遍按块对每个点依次做对数变换、量化和曲线编码，
+// 直接写出量化坐标与(莫顿码, 索引)对，不产生中间的变换后坐标和类型转换副本
+class PositionPreprocessor {
+private:
+    // 每个块的点数，块内的对数变换结果保存在栈上的缓冲区中
+    static constexpr size_t BlockPoints = 1024;
+    // 并行处理时每个线程区间的最小点数
+    static constexpr size_t ParallelMinPoints = 1 << 14;
+
+    static void checkBitDepth(int bitDepth, int digits) {
+        if (bitDepth > 21 || bitDepth > digits) {
+            SPDLOG_ERROR("Position bit depth {} exceeds the quantized type or 64-bit curve keys", bitDepth);
+            throw std::runtime_error("Position bit depth out of range: " + std::to_string(bitDepth));
+        }
+    }
+
+public:
+    /**
+     * @brief 对数域的包围盒
+     * @throw std::invalid_argument 如果输入不是3个等长的非空坐标数组
+     */
+    static BoundingBox3D computeBBox(const std::vector<std::vector<float>>& positions, size_t numThreads = 1) {
+        // 对数变换单调，变换后点集的包围盒即为原包围盒的变换
+        auto bbox = BoundingBox3D::calculateFromPoints(positions, numThreads);
+        Transform::logTransformInPlace(std::span<float>(bbox.data));
+        return bbox;
+    }
+
+    /**
+     * @brief 对原始坐标做对数变换、量化并计算曲线排序键
+     * @param positions 3列原始坐标{x, y, z}，不会被修改
+     * @param bitDepth 每维量化位深，不超过QuantizedType的位数且不超过21（排序键为64位）
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @param curve 排序键使用的空间填充曲线
+     * @throw std::invalid_argument 如果输入不是3个等长的非空坐标数组
+     * @throw std::runtime_error 如果位深无效
+     */
+    template<typename QuantizedType = uint16_t>
+    static PreprocessedPositions<QuantizedType> process(const std::vector<std::vector<float>>& positions, int bitDepth, size_t numThreads = 1,
+                                                        SpaceFillingCurve curve = SpaceFillingCurve::MORTON) {
+        checkBitDepth(bitDepth, std::numeric_limits<QuantizedType>::digits);
+        return process<QuantizedType>(positions, computeBBox(positions, numThreads), bitDepth, numThreads, curve);
+    }
+
+    /**
+     * @brief 在给定的对数域包围盒上量化，用于多帧共享同一量化网格，包围盒之外的点被截断到边界
+     * @param bbox 对数域的量化包围盒
+     * @throw std::invalid_argument 如果输入不是3个等长的非空坐标数组
+     * @throw std::runtime_error 如果位深无效
+     */
+    template<typename QuantizedType = uint16_t>
+    static PreprocessedPositions<QuantizedType> process(const std::vector<std::vector<float>>& positions, const BoundingBox3D& bbox, int bitDepth,
+                                                        size_t numThreads = 1, SpaceFillingCurve curve = SpaceFillingCurve::MORTON) {
+        static_assert(std::is_unsigned_v<QuantizedType>, "QuantizedType must be unsigned");
+        checkBitDepth(bitDepth, std::numeric_limits<QuantizedType>::digits);
+        if (positions.size() != 3 || positions[0].size() != positions[1].size() || positions[0].size() != positions[2].size()) {
+            throw std::invalid_argument("Positions must be 3 columns of equal length");
+        }
+        const auto params = Quantization::makeParams(bbox, bitDepth);
+
+        const size_t numPoints = positions[0].size();
+        if (numPoints > UINT32_MAX) {
+            throw std::runtime_error("Too many points for 32-bit indices");
+        }
+        PreprocessedPositions<QuantizedType> result{
+            bbox,
+            std::vector<std::vector<QuantizedType>>(3, std::vector<QuantizedType>(numPoints)),
+            std::vector<uint64_t>(numPoints),
+            std::vector<uint32_t>(numPoints)
+        };
+        auto& quantized = result.quantizedPositions;
+
+        Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+            std::array<std::array<float, BlockPoints>, 3> transformed;
+            for (size_t blockBegin = begin; blockBegin < end; blockBegin += BlockPoints) {
+                const size_t count = std::min(BlockPoints, end - blockBegin);
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    std::copy_n(positions[axis].data() + blockBegin, count, transformed[axis].data());
+                    Transform::logTransformInPlace(std::span<float>(transformed[axis].data(), count));
+                }
+
+                const float* src[3] = {transformed[0].data(), transformed[1].data(), transformed[2].data()};
+                QuantizedType* dst[3] = {quantized[0].data() + blockBegin, quantized[1].data() + blockBegin, quantized[2].data() + blockBegin};
+                Quantization::quantizeBlock(params, src, dst, count);
+
+                CurveOrder::encode3DKeys(curve, dst[0], dst[1], dst[2], result.curveKeys.data() + blockBegin, count, bitDepth);
+                std::iota(result.indices.begin() + blockBegin, result.indices.begin() + blockBegin + count, static_cast<uint32_t>(blockBegin));
+            }
+        }, ParallelMinPoints);
+
+        return result;
+    }
+};
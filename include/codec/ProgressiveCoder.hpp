@@ -0,0 +1,524 @@
+#pragma once
+
+#include "AttributeCoder.hpp"
+#include "OctreeCoder.hpp"
+#include "QuaternionCoder.hpp"
+#include "RangeCoder.hpp"
+#include "ResidualCoder.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "utils/Parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 渐进式解码的结果，点按曲线顺序排列
+template<typename CoordinateType>
+struct ProgressiveLevel {
+    // 解码到的层级：0~bitDepth为八叉树深度，每个被占用的单元一个代表点；bitDepth + 1为包含重复点的完整数据
+    int level = 0;
+    // 全分辨率网格上的量化坐标，未到最细层时为单元中心
+    std::vector<std::vector<CoordinateType>> positions;
+    std::vector<std::vector<float>> attributes;
+    // 编码时没有旋转则为空
+    std::vector<std::vector<float>> rotations;
+};
+
+/**
+ * @brief 渐进式细节层次编码：按八叉树深度由粗到细输出，任意前缀都可以解码出一个完整的预览
+ *
+ * 每个被占用的单元以其中曲线顺序上的第一个点为代表点。父单元的代表点落在第一个被占用的子单元中并被其继承，
+ * 因此第L层只需新增其余子单元的代表点；最后一层补上叶节点的重复点。第L层的数据块包含深度L - 1各节点的占用字节
+ * (每层独立结束区间编码，上下文模型跨层延续)以及新增代表点的属性，解码前L + 1个数据块即得到深度L上每个单元一个点。
+ * 完整解码的输出顺序与编码输入一致。
+ *
+ * 码流：点数(uint32) + 位深(uint8) + 曲线(uint8) + 是否含旋转(uint8) + 属性列数(uint8) + 各列{值域, 位深, 范围(2 x float)}
+ *      + 数据块数(uint8) + 各块字节数(uint32) + 各数据块
+ * 数据块：若干分段{几何, 各属性列, 旋转}，每个分段为字节数(uint32) + 数据
+ */
+class ProgressiveCoder {
+private:
+    static constexpr size_t ParallelMinPoints = 1 << 14;
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& output, T value) {
+        const size_t offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static T read(const uint8_t* data, size_t size, size_t& offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::runtime_error("Truncated progressive bitstream");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    static void appendSection(std::vector<uint8_t>& output, const std::vector<uint8_t>& section) {
+        append(output, static_cast<uint32_t>(section.size()));
+        output.insert(output.end(), section.begin(), section.end());
+    }
+
+    static std::pair<const uint8_t*, size_t> readSection(const uint8_t* data, size_t size, size_t& offset) {
+        const size_t sectionSize = read<uint32_t>(data, size, offset);
+        if (sectionSize > size - offset) {
+            throw std::runtime_error("Truncated progressive bitstream");
+        }
+        const uint8_t* sectionData = data + offset;
+        offset += sectionSize;
+        return {sectionData, sectionSize};
+    }
+
+    // 码流头解析结果
+    struct Header {
+        uint32_t pointCount = 0;
+        int bitDepth = 0;
+        SpaceFillingCurve curve = SpaceFillingCurve::MORTON;
+        bool hasRotations = false;
+        std::vector<AttributeQuantization> attributes;
+        std::vector<uint32_t> chunkSizes;
+        size_t size = 0;
+    };
+
+    static Header readHeader(const uint8_t* data, size_t size) {
+        Header header;
+        size_t offset = 0;
+        header.pointCount = read<uint32_t>(data, size, offset);
+        header.bitDepth = read<uint8_t>(data, size, offset);
+        const uint8_t curve = read<uint8_t>(data, size, offset);
+        header.hasRotations = read<uint8_t>(data, size, offset) != 0;
+        if (header.bitDepth < 1 || curve > static_cast<uint8_t>(SpaceFillingCurve::HILBERT)) {
+            throw std::runtime_error("Corrupted progressive bitstream: invalid header");
+        }
+        header.curve = static_cast<SpaceFillingCurve>(curve);
+        header.attributes.resize(read<uint8_t>(data, size, offset));
+        for (auto& attribute : header.attributes) {
+            const uint8_t domain = read<uint8_t>(data, size, offset);
+            attribute.bitDepth = read<uint8_t>(data, size, offset);
+            if (domain > static_cast<uint8_t>(AttributeDomain::SIGMOID) || attribute.bitDepth < 1 || attribute.bitDepth > AttributeCoder::MaxBitDepth) {
+                throw std::runtime_error("Corrupted progressive bitstream: invalid attribute header");
+            }
+            attribute.domain = static_cast<AttributeDomain>(domain);
+            const float minValue = read<float>(data, size, offset);
+            const float maxValue = read<float>(data, size, offset);
+            attribute.range = std::array<float, 2>{minValue, maxValue};
+        }
+        header.chunkSizes.resize(read<uint8_t>(data, size, offset));
+        if (header.chunkSizes.size() != static_cast<size_t>(header.bitDepth) + 2) {
+            throw std::runtime_error("Corrupted progressive bitstream: chunk count mismatch");
+        }
+        for (auto& chunkSize : header.chunkSizes) {
+            chunkSize = read<uint32_t>(data, size, offset);
+        }
+        header.size = offset;
+        return header;
+    }
+
+    // 一个数据块的属性与旋转分段，points为本块新增点在输入中的下标
+    static void appendPointSections(std::vector<uint8_t>& chunk, const std::vector<uint32_t>& points, const std::vector<std::vector<uint16_t>>& levels,
+                                    const std::vector<AttributeQuantization>& settings, const std::vector<uint32_t>& rotationWords, bool hasRotations) {
+        std::vector<uint16_t> gathered(points.size());
+        for (size_t column = 0; column < levels.size(); ++column) {
+            for (size_t i = 0; i < points.size(); ++i) {
+                gathered[i] = levels[column][points[i]];
+            }
+            appendSection(chunk, ResidualCoder::encodeDelta(gathered.data(), gathered.size(), settings[column].bitDepth));
+        }
+        if (hasRotations) {
+            std::vector<uint8_t> words(points.size() * sizeof(uint32_t));
+            for (size_t i = 0; i < points.size(); ++i) {
+                std::memcpy(words.data() + i * sizeof(uint32_t), &rotationWords[points[i]], sizeof(uint32_t));
+            }
+            appendSection(chunk, words);
+        }
+    }
+
+public:
+    /**
+     * @brief 编码已按曲线顺序排列的一帧
+     * @param sortedPositions 3列量化坐标，需按curve排列
+     * @param attributes 属性列，与settings一一对应，未指定范围的列使用数据范围
+     * @param rotations 4列旋转分量，可以为空
+     * @param numThreads 线程数，各数据块并行编码，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果列数或长度不匹配、位深无效或未按曲线顺序排列
+     */
+    template<typename CoordinateType>
+    static std::vector<uint8_t> encode(const std::vector<std::vector<CoordinateType>>& sortedPositions, int bitDepth, SpaceFillingCurve curve,
+                                       const std::vector<std::vector<float>>& attributes, const std::vector<AttributeQuantization>& settings,
+                                       const std::vector<std::vector<float>>& rotations, size_t numThreads = 1) {
+        static_assert(std::is_unsigned_v<CoordinateType>, "CoordinateType must be unsigned");
+        if (sortedPositions.size() != 3 || attributes.size() != settings.size() || attributes.size() > UINT8_MAX
+            || (!rotations.empty() && rotations.size() != 4)) {
+            throw std::runtime_error("Progressive coding requires 3 position, matching attribute and 0 or 4 rotation columns");
+        }
+        const size_t count = sortedPositions[0].size();
+        const auto checkLength = [count](const auto& columns) {
+            for (const auto& column : columns) {
+                if (column.size() != count) {
+                    throw std::runtime_error("Progressive coding requires columns of equal length");
+                }
+            }
+        };
+        checkLength(sortedPositions);
+        checkLength(attributes);
+        checkLength(rotations);
+        if (bitDepth < 1 || bitDepth > static_cast<int>(sizeof(CoordinateType) * 8) || bitDepth > 32) {
+            SPDLOG_ERROR("Invalid progressive bit depth: {}", bitDepth);
+            throw std::runtime_error("Invalid progressive bit depth: " + std::to_string(bitDepth));
+        }
+        if (count == 0 || count > UINT32_MAX) {
+            throw std::runtime_error("Progressive coding requires between 1 and 2^32 - 1 points");
+        }
+        if (bitDepth < static_cast<int>(sizeof(CoordinateType) * 8)) {
+            for (const auto& axis : sortedPositions) {
+                for (const auto value : axis) {
+                    if ((static_cast<uint64_t>(value) >> bitDepth) != 0) {
+                        SPDLOG_ERROR("Coordinate {} exceeds progressive bit depth {}", static_cast<uint64_t>(value), bitDepth);
+                        throw std::runtime_error("Coordinate exceeds progressive bit depth");
+                    }
+                }
+            }
+        }
+        const bool hasRotations = !rotations.empty();
+
+        // 属性先整体量化，各数据块只取用其中的一部分
+        std::vector<AttributeQuantization> resolved = settings;
+        std::vector<std::vector<uint16_t>> levels(attributes.size());
+        Parallel::forRange(attributes.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                if (!resolved[column].range) {
+                    resolved[column].range = AttributeCoder::computeRange(attributes[column], resolved[column].domain);
+                }
+                levels[column] = AttributeCoder::quantize(attributes[column], resolved[column].domain, resolved[column].bitDepth, *resolved[column].range);
+            }
+        });
+        std::vector<uint32_t> rotationWords(hasRotations ? count : 0);
+        if (hasRotations) {
+            Parallel::forRange(count, numThreads, [&](size_t begin, size_t end) {
+                const float* src[4] = {rotations[0].data() + begin, rotations[1].data() + begin, rotations[2].data() + begin, rotations[3].data() + begin};
+                QuaternionCoder::packBlock(src, rotationWords.data() + begin, end - begin);
+            }, ParallelMinPoints);
+        }
+
+        // 逐层展开八叉树，记录各层的占用码流与新增代表点；第0块为根单元的代表点，最后一块为重复点
+        struct Node {
+            uint32_t begin;
+            uint32_t end;
+            uint8_t parentOccupied;
+            uint8_t state;
+        };
+        const size_t chunkCount = static_cast<size_t>(bitDepth) + 2;
+        std::vector<std::vector<uint8_t>> geometry(chunkCount);
+        std::vector<std::vector<uint32_t>> chunkPoints(chunkCount);
+        chunkPoints[0].push_back(0);
+
+        const auto& traversal = CurveOrder::getTraversal(curve);
+        auto models = std::make_unique<OctreeCoder::OccupancyModels>();
+        std::vector<Node> nodes{{0, static_cast<uint32_t>(count), 8, 0}};
+        std::vector<Node> children;
+        for (int level = 0; level < bitDepth; ++level) {
+            const int shift = bitDepth - 1 - level;
+            RangeEncoder encoder;
+            children.clear();
+            children.reserve(nodes.size() * 2);
+            auto& points = chunkPoints[level + 1];
+            for (const auto& node : nodes) {
+                uint8_t occupancy = 0;
+                const size_t firstChild = children.size();
+                const auto& rank = traversal.rank[node.state];
+                int previousOctant = -1;
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    const int octant = OctreeCoder::getOctant(sortedPositions, i, shift);
+                    if (octant == previousOctant) {
+                        continue;
+                    }
+                    if (previousOctant >= 0 && rank[octant] < rank[previousOctant]) {
+                        SPDLOG_ERROR("Positions are not in {} order at index {}", CurveOrder::getName(curve), i);
+                        throw std::runtime_error("Progressive coding requires positions sorted along the curve");
+                    }
+                    if (previousOctant >= 0) {
+                        children.back().end = i;
+                        // 第一个子单元继承父单元的代表点，其余子单元的第一个点是新的代表点
+                        points.push_back(i);
+                    }
+                    children.push_back({i, node.end, 0, traversal.next[node.state][octant]});
+                    occupancy |= static_cast<uint8_t>(1u << octant);
+                    previousOctant = octant;
+                }
+
+                OctreeCoder::encodeOccupancy(encoder, *models, occupancy, node.parentOccupied);
+                const uint8_t occupied = static_cast<uint8_t>(std::popcount(occupancy));
+                for (size_t c = firstChild; c < children.size(); ++c) {
+                    children[c].parentOccupied = occupied;
+                }
+            }
+            geometry[level + 1] = encoder.finish();
+            nodes.swap(children);
+        }
+        {
+            RangeEncoder encoder;
+            auto& points = chunkPoints.back();
+            for (const auto& node : nodes) {
+                OctreeCoder::encodeCount(encoder, *models, node.end - node.begin);
+                for (uint32_t i = node.begin + 1; i < node.end; ++i) {
+                    points.push_back(i);
+                }
+            }
+            geometry.back() = encoder.finish();
+        }
+
+        std::vector<std::vector<uint8_t>> chunks(chunkCount);
+        Parallel::forRange(chunkCount, numThreads, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                appendSection(chunks[chunk], geometry[chunk]);
+                appendPointSections(chunks[chunk], chunkPoints[chunk], levels, resolved, rotationWords, hasRotations);
+            }
+        });
+
+        std::vector<uint8_t> bitstream;
+        append(bitstream, static_cast<uint32_t>(count));
+        append(bitstream, static_cast<uint8_t>(bitDepth));
+        append(bitstream, static_cast<uint8_t>(curve));
+        append(bitstream, static_cast<uint8_t>(hasRotations));
+        append(bitstream, static_cast<uint8_t>(resolved.size()));
+        for (const auto& attribute : resolved) {
+            append(bitstream, static_cast<uint8_t>(attribute.domain));
+            append(bitstream, static_cast<uint8_t>(attribute.bitDepth));
+            append(bitstream, (*attribute.range)[0]);
+            append(bitstream, (*attribute.range)[1]);
+        }
+        append(bitstream, static_cast<uint8_t>(chunkCount));
+        for (const auto& chunk : chunks) {
+            if (chunk.size() > UINT32_MAX) {
+                throw std::runtime_error("Progressive chunk too large");
+            }
+            append(bitstream, static_cast<uint32_t>(chunk.size()));
+        }
+        for (const auto& chunk : chunks) {
+            bitstream.insert(bitstream.end(), chunk.begin(), chunk.end());
+        }
+        return bitstream;
+    }
+
+    /**
+     * @brief 码流的层级数，可解码的level为[0, getLevelCount() - 1]
+     * @param size 已收到的字节数，须包含完整的码流头
+     * @throw std::runtime_error 如果码流头不完整或损坏
+     */
+    static int getLevelCount(const uint8_t* bitstream, size_t size) {
+        return static_cast<int>(readHeader(bitstream, size).chunkSizes.size());
+    }
+
+    /**
+     * @brief 解码到level层所需的码流前缀字节数，供按层级截断传输
+     * @throw std::runtime_error 如果码流头不完整或level越界
+     */
+    static size_t getPrefixSize(const uint8_t* bitstream, size_t size, int level) {
+        const auto header = readHeader(bitstream, size);
+        if (level < 0 || static_cast<size_t>(level) >= header.chunkSizes.size()) {
+            throw std::runtime_error("Progressive level out of range: " + std::to_string(level));
+        }
+        size_t prefixSize = header.size;
+        for (int chunk = 0; chunk <= level; ++chunk) {
+            prefixSize += header.chunkSizes[chunk];
+        }
+        return prefixSize;
+    }
+
+    /**
+     * @brief 解码码流前缀，在字节预算或目标层级处提前结束
+     * @param bitstream 码流的前size个字节，即字节预算；不完整的数据块被忽略
+     * @param maxLevel 目标层级，超过可用层级时解码到可用的最细层
+     * @param numThreads 线程数，各属性列并行解码，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果前缀不足以解码第0层或码流损坏
+     */
+    template<typename CoordinateType>
+    static ProgressiveLevel<CoordinateType> decode(const uint8_t* bitstream, size_t size, int maxLevel = INT_MAX, size_t numThreads = 1) {
+        static_assert(std::is_unsigned_v<CoordinateType>, "CoordinateType must be unsigned");
+        const auto header = readHeader(bitstream, size);
+        const int bitDepth = header.bitDepth;
+        if (bitDepth > static_cast<int>(sizeof(CoordinateType) * 8)) {
+            SPDLOG_ERROR("Progressive bit depth {} does not fit the coordinate type", bitDepth);
+            throw std::runtime_error("Invalid progressive bit depth in bitstream");
+        }
+
+        // 预算内完整的数据块数决定可解码的层级
+        int level = -1;
+        size_t available = header.size;
+        for (size_t chunk = 0; chunk < header.chunkSizes.size() && static_cast<int>(chunk) <= maxLevel; ++chunk) {
+            if (header.chunkSizes[chunk] > size - available) {
+                break;
+            }
+            available += header.chunkSizes[chunk];
+            level = static_cast<int>(chunk);
+        }
+        if (level < 0) {
+            SPDLOG_ERROR("Progressive bitstream prefix of {} bytes does not contain level 0", size);
+            throw std::runtime_error("Progressive bitstream prefix too short");
+        }
+
+        // 已解码的代表点与重复点，按引入顺序编号
+        const size_t columnCount = header.attributes.size();
+        std::vector<std::vector<uint16_t>> levels(columnCount);
+        std::vector<uint32_t> rotationWords;
+        size_t decodedCount = 0;
+        auto decodePoints = [&](const uint8_t* chunk, size_t chunkSize, size_t& offset, size_t pointCount) {
+            std::vector<std::pair<const uint8_t*, size_t>> sections(columnCount);
+            for (auto& section : sections) {
+                section = readSection(chunk, chunkSize, offset);
+            }
+            const size_t first = decodedCount;
+            Parallel::forRange(columnCount, numThreads, [&](size_t begin, size_t end) {
+                for (size_t column = begin; column < end; ++column) {
+                    levels[column].resize(first + pointCount);
+                    ResidualCoder::decodeDelta(sections[column].first, sections[column].second, levels[column].data() + first, pointCount,
+                                               header.attributes[column].bitDepth);
+                }
+            });
+            decodedCount += pointCount;
+            if (header.hasRotations) {
+                rotationWords.resize(decodedCount);
+                const auto [words, wordsSize] = readSection(chunk, chunkSize, offset);
+                if (wordsSize != pointCount * sizeof(uint32_t)) {
+                    throw std::runtime_error("Corrupted progressive bitstream: rotation size mismatch");
+                }
+                std::memcpy(rotationWords.data() + first, words, wordsSize);
+            }
+        };
+
+        struct Node {
+            uint32_t x;
+            uint32_t y;
+            uint32_t z;
+            uint32_t representative;
+            uint8_t parentOccupied;
+            uint8_t state;
+        };
+        const auto& traversal = CurveOrder::getTraversal(header.curve);
+        auto models = std::make_unique<OctreeCoder::OccupancyModels>();
+        std::vector<Node> nodes{{0, 0, 0, 0, 8, 0}};
+        std::vector<Node> children;
+        std::vector<uint32_t> leafCounts;
+        const uint8_t* chunk = bitstream + header.size;
+        for (int chunkIndex = 0; chunkIndex <= level; chunk += header.chunkSizes[chunkIndex++]) {
+            const size_t chunkSize = header.chunkSizes[chunkIndex];
+            size_t offset = 0;
+            const auto [geometryData, geometrySize] = readSection(chunk, chunkSize, offset);
+            RangeDecoder decoder(geometryData, geometrySize);
+            size_t newPoints = 0;
+            if (chunkIndex == 0) {
+                newPoints = 1;
+            } else if (chunkIndex <= bitDepth) {
+                children.clear();
+                children.reserve(nodes.size() * 2);
+                for (const auto& node : nodes) {
+                    const uint8_t occupancy = OctreeCoder::decodeOccupancy(decoder, *models, node.parentOccupied);
+                    const uint8_t occupied = static_cast<uint8_t>(std::popcount(occupancy));
+                    bool firstChild = true;
+                    for (uint32_t rank = 0; rank < 8; ++rank) {
+                        const uint32_t octant = traversal.octant[node.state][rank];
+                        if (!((occupancy >> octant) & 1u)) {
+                            continue;
+                        }
+                        const uint32_t representative = firstChild ? node.representative : static_cast<uint32_t>(decodedCount + newPoints++);
+                        firstChild = false;
+                        children.push_back({(node.x << 1) | (octant & 1u),
+                                            (node.y << 1) | ((octant >> 1) & 1u),
+                                            (node.z << 1) | ((octant >> 2) & 1u),
+                                            representative, occupied, traversal.next[node.state][octant]});
+                    }
+                }
+                if (children.size() > header.pointCount) {
+                    throw std::runtime_error("Corrupted progressive bitstream: too many occupied nodes");
+                }
+                nodes.swap(children);
+            } else {
+                leafCounts.resize(nodes.size());
+                size_t total = 0;
+                for (size_t i = 0; i < nodes.size(); ++i) {
+                    leafCounts[i] = OctreeCoder::decodeCount(decoder, *models);
+                    total += leafCounts[i];
+                    if (total > header.pointCount) {
+                        throw std::runtime_error("Corrupted progressive bitstream: too many points");
+                    }
+                }
+                if (total != header.pointCount) {
+                    throw std::runtime_error("Corrupted progressive bitstream: point count mismatch");
+                }
+                newPoints = total - nodes.size();
+            }
+            decodePoints(chunk, chunkSize, offset, newPoints);
+        }
+
+        // 输出每个单元的代表点；完整层级下叶节点的重复点紧随其代表点，编号从叶节点代表点之后连续分配
+        std::vector<uint32_t> order;
+        std::vector<Node> outputNodes;
+        const bool full = level == bitDepth + 1;
+        const size_t outputCount = full ? header.pointCount : nodes.size();
+        order.reserve(outputCount);
+        outputNodes.reserve(outputCount);
+        uint32_t duplicate = static_cast<uint32_t>(decodedCount - (full ? header.pointCount - nodes.size() : 0));
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            order.push_back(nodes[i].representative);
+            outputNodes.push_back(nodes[i]);
+            for (uint32_t k = 1; full && k < leafCounts[i]; ++k) {
+                order.push_back(duplicate++);
+                outputNodes.push_back(nodes[i]);
+            }
+        }
+
+        ProgressiveLevel<CoordinateType> result;
+        result.level = level;
+        const int depth = std::min(level, bitDepth);
+        const int shift = bitDepth - depth;
+        const uint32_t center = shift > 0 ? 1u << (shift - 1) : 0u;
+        result.positions.assign(3, std::vector<CoordinateType>(outputCount));
+        for (size_t i = 0; i < outputCount; ++i) {
+            result.positions[0][i] = static_cast<CoordinateType>((static_cast<uint64_t>(outputNodes[i].x) << shift) | center);
+            result.positions[1][i] = static_cast<CoordinateType>((static_cast<uint64_t>(outputNodes[i].y) << shift) | center);
+            result.positions[2][i] = static_cast<CoordinateType>((static_cast<uint64_t>(outputNodes[i].z) << shift) | center);
+        }
+        result.attributes.resize(columnCount);
+        Parallel::forRange(columnCount, numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                std::vector<uint16_t> gathered(outputCount);
+                for (size_t i = 0; i < outputCount; ++i) {
+                    gathered[i] = levels[column][order[i]];
+                }
+                const auto& attribute = header.attributes[column];
+                result.attributes[column] = AttributeCoder::dequantize(gathered, attribute.domain, attribute.bitDepth, *attribute.range);
+            }
+        });
+        if (header.hasRotations) {
+            std::vector<uint32_t> words(outputCount);
+            for (size_t i = 0; i < outputCount; ++i) {
+                words[i] = rotationWords[order[i]];
+            }
+            result.rotations.assign(4, std::vector<float>(outputCount));
+            Parallel::forRange(outputCount, numThreads, [&](size_t begin, size_t end) {
+                float* dst[4] = {result.rotations[0].data() + begin, result.rotations[1].data() + begin,
+                                 result.rotations[2].data() + begin, result.rotations[3].data() + begin};
+                QuaternionCoder::unpackBlock(words.data() + begin, dst, end - begin);
+            }, ParallelMinPoints);
+        }
+        return result;
+    }
+
+    template<typename CoordinateType>
+    static ProgressiveLevel<CoordinateType> decode(const std::vector<uint8_t>& bitstream, int maxLevel = INT_MAX, size_t numThreads = 1) {
+        return decode<CoordinateType>(bitstream.data(), bitstream.size(), maxLevel, numThreads);
+    }
+};
@@ -1,10 +1,23 @@
 #pragma once
 
+#include "utils/CpuFeatures.hpp"
+#include "utils/Parallel.hpp"
 #include <vector>
 #include <stdexcept>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <spdlog/spdlog.h>
 
 class BoundingBox3D {
+private:
+    // 并行求包围盒时每个区间的最小点数
+    static constexpr size_t ReductionMinPoints = 1 << 16;
+
 public:
     std::array<float, 6> data; // {minX, minY, minZ, maxX, maxY, maxZ}
 
@@ -19,8 +32,13 @@ public:
     float maxY() const { return data[4]; }
     float maxZ() const { return data[5]; }
 
+    /**
+     * @brief 计算点集的包围盒，按区间并行归约
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @throw std::invalid_argument 如果不是3个等长的非空坐标数组
+     */
     template<typename T>
-    static BoundingBox3D calculateFromPoints(const std::vector<std::vector<T>>& points) {
+    static BoundingBox3D calculateFromPoints(const std::vector<std::vector<T>>& points, size_t numThreads = 1) {
         if (points.size() != 3 || points[0].empty()) {
             throw std::invalid_argument("Points must contain 3 non-empty coordinate arrays.");
         }
@@ -30,95 +48,309 @@ public:
             throw std::invalid_argument("All coordinate arrays must have the same length.");
         }
 
-        float minX = points[0][0], maxX = points[0][0];
-        float minY = points[1][0], maxY = points[1][0];
-        float minZ = points[2][0], maxZ = points[2][0];
-
-        for (size_t i = 1; i < n; ++i) {
-            float x = points[0][i];
-            float y = points[1][i];
-            float z = points[2][i];
-
-            if (x < minX) minX = x;
-            else if (x > maxX) maxX = x;
-
-            if (y < minY) minY = y;
-            else if (y > maxY) maxY = y;
+        // 每个区间独立求最值，最后合并
+        const size_t chunks = std::min(Parallel::resolveThreadCount(numThreads), (n + ReductionMinPoints - 1) / ReductionMinPoints);
+        std::vector<std::array<float, 6>> partials(chunks);
+        Parallel::forRange(chunks, chunks, [&](size_t first, size_t last) {
+            for (size_t chunk = first; chunk < last; ++chunk) {
+                const size_t begin = n * chunk / chunks;
+                const size_t end = n * (chunk + 1) / chunks;
+                auto& bounds = partials[chunk];
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    const T* values = points[axis].data();
+                    float minValue = static_cast<float>(values[begin]);
+                    float maxValue = minValue;
+                    for (size_t i = begin + 1; i < end; ++i) {
+                        const float value = static_cast<float>(values[i]);
+                        minValue = value < minValue ? value : minValue;
+                        maxValue = value > maxValue ? value : maxValue;
+                    }
+                    bounds[axis] = minValue;
+                    bounds[axis + 3] = maxValue;
+                }
+            }
+        });
 
-            if (z < minZ) minZ = z;
-            else if (z > maxZ) maxZ = z;
+        std::array<float, 6> bounds = partials[0];
+        for (size_t chunk = 1; chunk < chunks; ++chunk) {
+            for (size_t axis = 0; axis < 3; ++axis) {
+                bounds[axis] = std::min(bounds[axis], partials[chunk][axis]);
+                bounds[axis + 3] = std::max(bounds[axis + 3], partials[chunk][axis + 3]);
+            }
         }
 
-        return BoundingBox3D(minX, minY, minZ, maxX, maxY, maxZ);
+        return BoundingBox3D(bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5]);
     }
 };
 
+// 量化参数：q = round((x - offset) * scale)，x = q * step + offset
+struct QuantizationParams {
+    std::array<float, 3> offset;
+    std::array<float, 3> scale;
+    std::array<float, 3> step;
+    float maxLevel;
+};
+
 class Quantization {
-public:
+private:
+    // float可以精确表示的最大量化位深
+    static constexpr int MaxBitDepth = 24;
+    // 并行处理时每个线程区间的最小点数
+    static constexpr size_t ParallelMinPoints = 1 << 14;
 
-    template<typename OutType, typename InType, size_t BitsPerDimension>
-    static std::vector<std::vector<OutType>> quantizePositionWithBBox(const std::vector<std::vector<InType>>& points, const BoundingBox3D& bbox) {
+    template<typename OutType>
+    static constexpr bool isSimdQuantizedType = std::is_same_v<OutType, uint16_t> || std::is_same_v<OutType, uint32_t>;
+
+    template<typename QuantizedType>
+    static void checkBitDepth(int bitDepth) {
+        if (bitDepth < 1 || bitDepth > MaxBitDepth) {
+            SPDLOG_ERROR("Quantization bit depth {} is out of range [1, {}]", bitDepth, MaxBitDepth);
+            throw std::runtime_error("Quantization bit depth out of range: " + std::to_string(bitDepth));
+        }
+        if constexpr (std::is_integral_v<QuantizedType>) {
+            if (bitDepth > std::numeric_limits<QuantizedType>::digits) {
+                SPDLOG_ERROR("Quantization bit depth {} does not fit the quantized type", bitDepth);
+                throw std::runtime_error("Quantization bit depth does not fit the quantized type: " + std::to_string(bitDepth));
+            }
+        }
+    }
+
+    template<typename T>
+    static void checkPoints(const std::vector<std::vector<T>>& points) {
         if (points.size() != 3) {
             throw std::runtime_error("Only 3D points are supported for quantization.");
         }
+        if (points[1].size() != points[0].size() || points[2].size() != points[0].size()) {
+            throw std::runtime_error("All coordinate arrays must have the same length.");
+        }
+    }
 
-        size_t numPoints = points[0].size();
+    template<typename OutType, typename InType>
+    static void quantizeRowsScalar(const QuantizationParams& params, const InType* const* src, OutType* const* dst, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t axis = 0; axis < 3; ++axis) {
+                float value = (static_cast<float>(src[axis][i]) - params.offset[axis]) * params.scale[axis];
+                // NaN同样被截断到0
+                value = value > 0.0f ? value : 0.0f;
+                value = value < params.maxLevel ? value : params.maxLevel;
+                dst[axis][i] = static_cast<OutType>(std::nearbyint(value));
+            }
+        }
+    }
 
-        // auto bbox = BoundingBox3D::calculateFromPoints(points);
-        float minX = bbox.minX();
-        float minY = bbox.minY();
-        float minZ = bbox.minZ();
-        float maxX = bbox.maxX();
-        float maxY = bbox.maxY();
-        float maxZ = bbox.maxZ();
+    template<typename OutType, typename InType>
+    static void dequantizeRowsScalar(const QuantizationParams& params, const InType* const* src, OutType* const* dst, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t axis = 0; axis < 3; ++axis) {
+                dst[axis][i] = static_cast<OutType>(std::fma(static_cast<float>(src[axis][i]), params.step[axis], params.offset[axis]));
+            }
+        }
+    }
 
-        uint32_t levels = 1 << BitsPerDimension;
-        std::vector<std::vector<OutType>> quantizedData(3, std::vector<OutType>(numPoints));
+#if defined(GS_ARCH_X86)
+    // SIMD路径与标量路径的运算一致（量化先减后乘，反量化使用FMA），结果逐位相同
+    template<typename OutType>
+    GS_TARGET_AVX2 static size_t quantizeRowsAvx2(const QuantizationParams& params, const float* const* src, OutType* const* dst, size_t begin, size_t end) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 maxLevel = _mm256_set1_ps(params.maxLevel);
+        size_t i = begin;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const __m256 offset = _mm256_set1_ps(params.offset[axis]);
+            const __m256 scale = _mm256_set1_ps(params.scale[axis]);
+            for (i = begin; i + 8 <= end; i += 8) {
+                __m256 value = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(src[axis] + i), offset), scale);
+                value = _mm256_min_ps(_mm256_max_ps(value, zero), maxLevel);
+                const __m256i quantized = _mm256_cvtps_epi32(value);
+                if constexpr (std::is_same_v<OutType, uint16_t>) {
+                    const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(quantized), _mm256_extracti128_si256(quantized, 1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[axis] + i), packed);
+                } else {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst[axis] + i), quantized);
+                }
+            }
+        }
+        return i;
+    }
 
-        for (size_t i = 0; i < numPoints; ++i) {
-            OutType qx = static_cast<OutType>(((points[0][i] - minX) / (maxX - minX)) * (levels - 1));
-            OutType qy = static_cast<OutType>(((points[1][i] - minY) / (maxY - minY)) * (levels - 1));
-            OutType qz = static_cast<OutType>(((points[2][i] - minZ) / (maxZ - minZ)) * (levels - 1));
+    template<typename OutType>
+    GS_TARGET_AVX512 static size_t quantizeRowsAvx512(const QuantizationParams& params, const float* const* src, OutType* const* dst, size_t begin, size_t end) {
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 maxLevel = _mm512_set1_ps(params.maxLevel);
+        size_t i = begin;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const __m512 offset = _mm512_set1_ps(params.offset[axis]);
+            const __m512 scale = _mm512_set1_ps(params.scale[axis]);
+            for (i = begin; i + 16 <= end; i += 16) {
+                __m512 value = _mm512_mul_ps(_mm512_sub_ps(_mm512_loadu_ps(src[axis] + i), offset), scale);
+                value = _mm512_min_ps(_mm512_max_ps(value, zero), maxLevel);
+                const __m512i quantized = _mm512_cvtps_epi32(value);
+                if constexpr (std::is_same_v<OutType, uint16_t>) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst[axis] + i), _mm512_cvtusepi32_epi16(quantized));
+                } else {
+                    _mm512_storeu_si512(dst[axis] + i, quantized);
+                }
+            }
+        }
+        return i;
+    }
 
-            quantizedData[0][i] = qx;
-            quantizedData[1][i] = qy;
-            quantizedData[2][i] = qz;
+    template<typename InType>
+    GS_TARGET_AVX2 static size_t dequantizeRowsAvx2(const QuantizationParams& params, const InType* const* src, float* const* dst, size_t begin, size_t end) {
+        size_t i = begin;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const __m256 offset = _mm256_set1_ps(params.offset[axis]);
+            const __m256 step = _mm256_set1_ps(params.step[axis]);
+            for (i = begin; i + 8 <= end; i += 8) {
+                __m256i quantized;
+                if constexpr (std::is_same_v<InType, uint16_t>) {
+                    quantized = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src[axis] + i)));
+                } else {
+                    quantized = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src[axis] + i));
+                }
+                const __m256 value = _mm256_fmadd_ps(_mm256_cvtepi32_ps(quantized), step, offset);
+                _mm256_storeu_ps(dst[axis] + i, value);
+            }
         }
+        return i;
+    }
 
-        return quantizedData;
+    template<typename InType>
+    GS_TARGET_AVX512 static size_t dequantizeRowsAvx512(const QuantizationParams& params, const InType* const* src, float* const* dst, size_t begin, size_t end) {
+        size_t i = begin;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const __m512 offset = _mm512_set1_ps(params.offset[axis]);
+            const __m512 step = _mm512_set1_ps(params.step[axis]);
+            for (i = begin; i + 16 <= end; i += 16) {
+                __m512i quantized;
+                if constexpr (std::is_same_v<InType, uint16_t>) {
+                    quantized = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src[axis] + i)));
+                } else {
+                    quantized = _mm512_loadu_si512(src[axis] + i);
+                }
+                const __m512 value = _mm512_fmadd_ps(_mm512_cvtepi32_ps(quantized), step, offset);
+                _mm512_storeu_ps(dst[axis] + i, value);
+            }
+        }
+        return i;
     }
+#endif
 
-    template<typename OutType, typename InType, size_t BitsPerDimension>
-    static std::vector<std::vector<OutType>> dequantizePositionWithBBox(const std::vector<std::vector<InType>>& quantizedPoints, const BoundingBox3D& bbox) {
-        if (quantizedPoints.size() != 3) {
-            throw std::runtime_error("Only 3D points are supported for dequantization.");
+    // 按CPU特性选择内核，SIMD内核处理不完的尾部由标量路径补齐
+    template<typename OutType, typename InType>
+    static void quantizeRows(const QuantizationParams& params, const InType* const* src, OutType* const* dst, size_t begin, size_t end, SimdLevel simdLevel) {
+        size_t i = begin;
+#if defined(GS_ARCH_X86)
+        if constexpr (std::is_same_v<InType, float> && isSimdQuantizedType<OutType>) {
+            if (simdLevel >= SimdLevel::AVX512) {
+                i = quantizeRowsAvx512(params, src, dst, begin, end);
+            } else if (simdLevel >= SimdLevel::AVX2) {
+                i = quantizeRowsAvx2(params, src, dst, begin, end);
+            }
+        }
+#endif
+        quantizeRowsScalar(params, src, dst, i, end);
+    }
+
+    template<typename OutType, typename InType>
+    static void dequantizeRows(const QuantizationParams& params, const InType* const* src, OutType* const* dst, size_t begin, size_t end, SimdLevel simdLevel) {
+        size_t i = begin;
+#if defined(GS_ARCH_X86)
+        if constexpr (std::is_same_v<OutType, float> && isSimdQuantizedType<InType>) {
+            if (simdLevel >= SimdLevel::AVX512) {
+                i = dequantizeRowsAvx512(params, src, dst, begin, end);
+            } else if (simdLevel >= SimdLevel::AVX2) {
+                i = dequantizeRowsAvx2(params, src, dst, begin, end);
+            }
         }
+#endif
+        dequantizeRowsScalar(params, src, dst, i, end);
+    }
 
-        size_t numPoints = quantizedPoints[0].size();
+public:
+    /**
+     * @brief 由包围盒和位深计算量化参数，包围盒某一维宽度为0时该维全部量化到0
+     * @throw std::runtime_error 如果位深超出[1, 24]
+     */
+    static QuantizationParams makeParams(const BoundingBox3D& bbox, int bitDepth) {
+        checkBitDepth<float>(bitDepth);
+        QuantizationParams params{};
+        params.maxLevel = static_cast<float>((1u << bitDepth) - 1);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const float minValue = bbox.data[axis];
+            const float extent = bbox.data[axis + 3] - minValue;
+            params.offset[axis] = minValue;
+            params.scale[axis] = extent > 0.0f ? params.maxLevel / extent : 0.0f;
+            params.step[axis] = extent > 0.0f ? extent / params.maxLevel : 0.0f;
+        }
+        return params;
+    }
 
-        float minX = bbox.minX();
-        float minY = bbox.minY();
-        float minZ = bbox.minZ();
-        float maxX = bbox.maxX();
-        float maxY = bbox.maxY();
-        float maxZ = bbox.maxZ();
+    /**
+     * @brief 按包围盒将坐标量化到[0, 2^bitDepth - 1]，舍入到最近整数并截断到该范围
+     * 三个轴在同一次遍历中处理，按运行时检测到的指令集选择AVX-512/AVX2/标量内核
+     * @param bitDepth 每维位深，运行时指定，范围[1, 24]且不超过OutType的位数
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果不是3维坐标或位深无效
+     */
+    template<typename OutType, typename InType>
+    static std::vector<std::vector<OutType>> quantizePositionWithBBox(const std::vector<std::vector<InType>>& points, const BoundingBox3D& bbox, int bitDepth, size_t numThreads = 1) {
+        checkPoints(points);
+        checkBitDepth<OutType>(bitDepth);
+        const auto params = makeParams(bbox, bitDepth);
 
-        uint32_t levels = 1 << BitsPerDimension;
-        std::vector<std::vector<OutType>> dequantizedData(3, std::vector<OutType>(numPoints));
+        const size_t numPoints = points[0].size();
+        std::vector<std::vector<OutType>> quantizedData(3, std::vector<OutType>(numPoints));
+        const InType* src[3] = {points[0].data(), points[1].data(), points[2].data()};
+        OutType* dst[3] = {quantizedData[0].data(), quantizedData[1].data(), quantizedData[2].data()};
 
-        for (size_t i = 0; i < numPoints; ++i) {
-            OutType x = static_cast<OutType>(quantizedPoints[0][i]) / (levels - 1) * (maxX - minX) + minX;
-            OutType y = static_cast<OutType>(quantizedPoints[1][i]) / (levels - 1) * (maxY - minY) + minY;
-            OutType z = static_cast<OutType>(quantizedPoints[2][i]) / (levels - 1) * (maxZ - minZ) + minZ;
+        const SimdLevel simdLevel = CpuFeatures::get().simdLevel;
+        Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+            quantizeRows(params, src, dst, begin, end, simdLevel);
+        }, ParallelMinPoints);
 
-            dequantizedData[0][i] = x;
-            dequantizedData[1][i] = y;
-            dequantizedData[2][i] = z;
-        }
+        return quantizedData;
+    }
+
+    /**
+     * @brief quantizePositionWithBBox的逆过程，x = q * (extent / (2^bitDepth - 1)) + min
+     * @param bitDepth 每维位深，需与量化时一致
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果不是3维坐标或位深无效
+     */
+    template<typename OutType, typename InType>
+    static std::vector<std::vector<OutType>> dequantizePositionWithBBox(const std::vector<std::vector<InType>>& quantizedPoints, const BoundingBox3D& bbox, int bitDepth, size_t numThreads = 1) {
+        checkPoints(quantizedPoints);
+        const auto params = makeParams(bbox, bitDepth);
+
+        const size_t numPoints = quantizedPoints[0].size();
+        std::vector<std::vector<OutType>> dequantizedData(3, std::vector<OutType>(numPoints));
+        const InType* src[3] = {quantizedPoints[0].data(), quantizedPoints[1].data(), quantizedPoints[2].data()};
+        OutType* dst[3] = {dequantizedData[0].data(), dequantizedData[1].data(), dequantizedData[2].data()};
+
+        const SimdLevel simdLevel = CpuFeatures::get().simdLevel;
+        Parallel::forRange(numPoints, numThreads, [&](size_t begin, size_t end) {
+            dequantizeRows(params, src, dst, begin, end, simdLevel);
+        }, ParallelMinPoints);
 
         return dequantizedData;
     }
 
+    // 量化count个点的三个轴，src与dst各为3个轴的指针，供按块处理的融合流程调用
+    template<typename OutType, typename InType>
+    static void quantizeBlock(const QuantizationParams& params, const InType* const* src, OutType* const* dst, size_t count) {
+        quantizeRows(params, src, dst, 0, count, CpuFeatures::get().simdLevel);
+    }
+
+    template<typename OutType, typename InType, size_t BitsPerDimension>
+    static std::vector<std::vector<OutType>> quantizePositionWithBBox(const std::vector<std::vector<InType>>& points, const BoundingBox3D& bbox) {
+        return quantizePositionWithBBox<OutType, InType>(points, bbox, static_cast<int>(BitsPerDimension));
+    }
+
+    template<typename OutType, typename InType, size_t BitsPerDimension>
+    static std::vector<std::vector<OutType>> dequantizePositionWithBBox(const std::vector<std::vector<InType>>& quantizedPoints, const BoundingBox3D& bbox) {
+        return dequantizePositionWithBBox<OutType, InType>(quantizedPoints, bbox, static_cast<int>(BitsPerDimension));
+    }
+
     template<typename OutType, typename InType>
     static std::vector<OutType> castVector(const std::vector<InType>& input) {
         std::vector<OutType> output;
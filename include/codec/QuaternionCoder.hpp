@@ -0,0 +1,258 @@
+#pragma once
+
+#include "utils/CpuFeatures.hpp"
+#include "utils/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 旋转四元数的smallest-three压缩：归一化后去掉绝对值最大的分量，
+// 保证被去掉的分量非负(q与-q表示同一旋转)，其余三个分量落在[-1/sqrt(2), 1/sqrt(2)]内，各量化为10位。
+// 每个四元数打包为一个32位字：最大分量下标(2位) << 30 | 三个分量按下标升序依次占[29:20]、[19:10]、[9:0]
+// 四元数分量顺序与PLY一致：rot_0为w，rot_1~rot_3为x、y、z；零长度或非有限值的四元数按单位四元数处理
+class QuaternionCoder {
+private:
+    static constexpr int ComponentBits = 10;
+    static constexpr uint32_t ComponentMask = (1u << ComponentBits) - 1;
+    // 只使用奇数个量化级(0~1022)，使分量0恰好落在中间一级上，单位四元数可以精确还原
+    static constexpr float MaxLevel = static_cast<float>(ComponentMask - 1);
+    static constexpr float HalfLevel = MaxLevel * 0.5f;
+    // 分量v映射到 v * EncodeScale + HalfLevel，解码为 q * DecodeScale + DecodeOffset
+    static constexpr float EncodeScale = HalfLevel * 1.41421356237309515f;
+    static constexpr float DecodeScale = 1.0f / EncodeScale;
+    static constexpr float DecodeOffset = -HalfLevel * DecodeScale;
+    static constexpr size_t HeaderSize = 4;
+    static constexpr size_t ParallelMinPoints = 1 << 14;
+
+    // SIMD路径与标量路径的运算逐条对应(平方和与线性映射均使用FMA)，打包结果与解码结果逐位相同
+    static uint32_t packScalar(float w, float x, float y, float z) {
+        float norm2 = std::fma(w, w, std::fma(x, x, std::fma(y, y, z * z)));
+        if (!(norm2 > 0.0f && norm2 < INFINITY)) {
+            w = 1.0f;
+            x = y = z = 0.0f;
+            norm2 = 1.0f;
+        }
+        const float components[4] = {w, x, y, z};
+        uint32_t largest = 0;
+        float largestAbs = std::fabs(w);
+        for (uint32_t i = 1; i < 4; ++i) {
+            if (std::fabs(components[i]) > largestAbs) {
+                largestAbs = std::fabs(components[i]);
+                largest = i;
+            }
+        }
+        // 最大分量为负时整体取反，再乘以模长的倒数完成归一化
+        const float scale = std::copysign(1.0f / std::sqrt(norm2), components[largest]);
+        uint32_t word = largest << 30;
+        int shift = 2 * ComponentBits;
+        for (uint32_t i = 0; i < 4; ++i) {
+            if (i == largest) {
+                continue;
+            }
+            const float level = std::fma(components[i] * scale, EncodeScale, HalfLevel);
+            const uint32_t quantized = static_cast<uint32_t>(std::nearbyint(std::min(std::max(level, 0.0f), MaxLevel)));
+            word |= quantized << shift;
+            shift -= ComponentBits;
+        }
+        return word;
+    }
+
+    static void unpackScalar(uint32_t word, float& w, float& x, float& y, float& z) {
+        const uint32_t largest = word >> 30;
+        const float a = std::fma(static_cast<float>((word >> 20) & ComponentMask), DecodeScale, DecodeOffset);
+        const float b = std::fma(static_cast<float>((word >> 10) & ComponentMask), DecodeScale, DecodeOffset);
+        const float c = std::fma(static_cast<float>(word & ComponentMask), DecodeScale, DecodeOffset);
+        const float l = std::sqrt(std::max(1.0f - std::fma(a, a, std::fma(b, b, c * c)), 0.0f));
+        w = largest == 0 ? l : a;
+        x = largest == 0 ? a : (largest == 1 ? l : b);
+        y = largest <= 1 ? b : (largest == 2 ? l : c);
+        z = largest <= 2 ? c : l;
+    }
+
+#if defined(GS_ARCH_X86)
+    GS_TARGET_AVX2 static size_t packAvx2(const float* const* src, uint32_t* dst, size_t begin, size_t end) {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000u)));
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 infinity = _mm256_set1_ps(INFINITY);
+        const __m256 maxLevel = _mm256_set1_ps(MaxLevel);
+        const __m256 encodeScale = _mm256_set1_ps(EncodeScale);
+        const __m256 halfLevel = _mm256_set1_ps(HalfLevel);
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            __m256 w = _mm256_loadu_ps(src[0] + i);
+            __m256 x = _mm256_loadu_ps(src[1] + i);
+            __m256 y = _mm256_loadu_ps(src[2] + i);
+            __m256 z = _mm256_loadu_ps(src[3] + i);
+            __m256 norm2 = _mm256_fmadd_ps(w, w, _mm256_fmadd_ps(x, x, _mm256_fmadd_ps(y, y, _mm256_mul_ps(z, z))));
+            const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(norm2, zero, _CMP_GT_OQ), _mm256_cmp_ps(norm2, infinity, _CMP_LT_OQ));
+            w = _mm256_blendv_ps(one, w, valid);
+            x = _mm256_and_ps(x, valid);
+            y = _mm256_and_ps(y, valid);
+            z = _mm256_and_ps(z, valid);
+            norm2 = _mm256_blendv_ps(one, norm2, valid);
+
+            // 与标量路径相同，只有严格更大时才更新最大分量
+            __m256i largest = _mm256_setzero_si256();
+            __m256 largestValue = w;
+            __m256 largestAbs = _mm256_and_ps(w, absMask);
+            const __m256 others[3] = {x, y, z};
+            for (int c = 0; c < 3; ++c) {
+                const __m256 componentAbs = _mm256_and_ps(others[c], absMask);
+                const __m256 greater = _mm256_cmp_ps(componentAbs, largestAbs, _CMP_GT_OQ);
+                largestAbs = _mm256_blendv_ps(largestAbs, componentAbs, greater);
+                largestValue = _mm256_blendv_ps(largestValue, others[c], greater);
+                largest = _mm256_blendv_epi8(largest, _mm256_set1_epi32(c + 1), _mm256_castps_si256(greater));
+            }
+            const __m256 inverseNorm = _mm256_div_ps(one, _mm256_sqrt_ps(norm2));
+            const __m256 scale = _mm256_or_ps(inverseNorm, _mm256_and_ps(largestValue, signMask));
+
+            // 按最大分量下标选出其余三个分量：a = idx == 0 ? x : w，b = idx <= 1 ? y : x，c = idx <= 2 ? z : y
+            const __m256 isZero = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_setzero_si256()));
+            const __m256 atMostOne = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(2), largest));
+            const __m256 atMostTwo = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(3), largest));
+            const __m256 selected[3] = {
+                _mm256_blendv_ps(w, x, isZero),
+                _mm256_blendv_ps(x, y, atMostOne),
+                _mm256_blendv_ps(y, z, atMostTwo)
+            };
+            __m256i word = _mm256_slli_epi32(largest, 30);
+            for (int c = 0; c < 3; ++c) {
+                __m256 level = _mm256_fmadd_ps(_mm256_mul_ps(selected[c], scale), encodeScale, halfLevel);
+                level = _mm256_min_ps(_mm256_max_ps(level, zero), maxLevel);
+                const __m256i quantized = _mm256_cvtps_epi32(level);
+                word = _mm256_or_si256(word, _mm256_sllv_epi32(quantized, _mm256_set1_epi32((2 - c) * ComponentBits)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), word);
+        }
+        return i;
+    }
+
+    GS_TARGET_AVX2 static size_t unpackAvx2(const uint32_t* src, float* const* dst, size_t begin, size_t end) {
+        const __m256i mask = _mm256_set1_epi32(static_cast<int>(ComponentMask));
+        const __m256 decodeScale = _mm256_set1_ps(DecodeScale);
+        const __m256 decodeOffset = _mm256_set1_ps(DecodeOffset);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256i word = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            const __m256i largest = _mm256_srli_epi32(word, 30);
+            const __m256 a = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(word, 20), mask)), decodeScale, decodeOffset);
+            const __m256 b = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(word, 10), mask)), decodeScale, decodeOffset);
+            const __m256 c = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_and_si256(word, mask)), decodeScale, decodeOffset);
+            const __m256 sum = _mm256_fmadd_ps(a, a, _mm256_fmadd_ps(b, b, _mm256_mul_ps(c, c)));
+            const __m256 l = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(one, sum), zero));
+
+            const __m256 is0 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_setzero_si256()));
+            const __m256 is1 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(1)));
+            const __m256 is2 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(2)));
+            const __m256 is3 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(largest, _mm256_set1_epi32(3)));
+            _mm256_storeu_ps(dst[0] + i, _mm256_blendv_ps(a, l, is0));
+            _mm256_storeu_ps(dst[1] + i, _mm256_blendv_ps(_mm256_blendv_ps(b, l, is1), a, is0));
+            _mm256_storeu_ps(dst[2] + i, _mm256_blendv_ps(_mm256_blendv_ps(c, l, is2), b, _mm256_or_ps(is0, is1)));
+            _mm256_storeu_ps(dst[3] + i, _mm256_blendv_ps(c, l, is3));
+        }
+        return i;
+    }
+#endif
+
+public:
+    /**
+     * @brief 打包count个四元数
+     * @param src 4列分量{w, x, y, z}的指针
+     * @param dst 输出count个32位字
+     */
+    static void packBlock(const float* const* src, uint32_t* dst, size_t count) {
+        size_t i = 0;
+#if defined(GS_ARCH_X86)
+        if (CpuFeatures::get().hasAvx2()) {
+            i = packAvx2(src, dst, 0, count);
+        }
+#endif
+        for (; i < count; ++i) {
+            dst[i] = packScalar(src[0][i], src[1][i], src[2][i], src[3][i]);
+        }
+    }
+
+    // 解包count个32位字为单位四元数，dst为4列分量{w, x, y, z}的指针
+    static void unpackBlock(const uint32_t* src, float* const* dst, size_t count) {
+        size_t i = 0;
+#if defined(GS_ARCH_X86)
+        if (CpuFeatures::get().hasAvx2()) {
+            i = unpackAvx2(src, dst, 0, count);
+        }
+#endif
+        for (; i < count; ++i) {
+            unpackScalar(src[i], dst[0][i], dst[1][i], dst[2][i], dst[3][i]);
+        }
+    }
+
+    /**
+     * @brief 编码旋转四元数
+     * @param rotations 4列分量{rot_0, rot_1, rot_2, rot_3}
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @return 点数(uint32) + 每点一个小端32位字
+     * @throw std::runtime_error 如果输入不是4个等长的列
+     */
+    static std::vector<uint8_t> encode(const std::vector<std::vector<float>>& rotations, size_t numThreads = 1) {
+        if (rotations.size() != 4
+            || rotations[1].size() != rotations[0].size()
+            || rotations[2].size() != rotations[0].size()
+            || rotations[3].size() != rotations[0].size()) {
+            throw std::runtime_error("Quaternion coding requires 4 rotation arrays of equal length");
+        }
+        const size_t count = rotations[0].size();
+        if (count > UINT32_MAX) {
+            throw std::runtime_error("Too many points for quaternion coding");
+        }
+
+        std::vector<uint32_t> words(count);
+        Parallel::forRange(count, numThreads, [&](size_t begin, size_t end) {
+            const float* src[4] = {rotations[0].data() + begin, rotations[1].data() + begin, rotations[2].data() + begin, rotations[3].data() + begin};
+            packBlock(src, words.data() + begin, end - begin);
+        }, ParallelMinPoints);
+
+        std::vector<uint8_t> bitstream(HeaderSize + count * sizeof(uint32_t));
+        const uint32_t pointCount = static_cast<uint32_t>(count);
+        std::memcpy(bitstream.data(), &pointCount, sizeof(pointCount));
+        std::memcpy(bitstream.data() + HeaderSize, words.data(), count * sizeof(uint32_t));
+        return bitstream;
+    }
+
+    /**
+     * @brief 解码旋转四元数
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @return 4列单位四元数分量{rot_0, rot_1, rot_2, rot_3}
+     * @throw std::runtime_error 如果码流长度与点数不符
+     */
+    static std::vector<std::vector<float>> decode(const uint8_t* bitstream, size_t size, size_t numThreads = 1) {
+        if (size < HeaderSize) {
+            throw std::runtime_error("Truncated quaternion bitstream");
+        }
+        uint32_t pointCount;
+        std::memcpy(&pointCount, bitstream, sizeof(pointCount));
+        if (size - HeaderSize != static_cast<size_t>(pointCount) * sizeof(uint32_t)) {
+            SPDLOG_ERROR("Quaternion bitstream has {} bytes for {} points", size, pointCount);
+            throw std::runtime_error("Quaternion bitstream size mismatch");
+        }
+
+        std::vector<uint32_t> words(pointCount);
+        std::memcpy(words.data(), bitstream + HeaderSize, words.size() * sizeof(uint32_t));
+        std::vector<std::vector<float>> rotations(4, std::vector<float>(pointCount));
+        Parallel::forRange(pointCount, numThreads, [&](size_t begin, size_t end) {
+            float* dst[4] = {rotations[0].data() + begin, rotations[1].data() + begin, rotations[2].data() + begin, rotations[3].data() + begin};
+            unpackBlock(words.data() + begin, dst, end - begin);
+        }, ParallelMinPoints);
+        return rotations;
+    }
+
+    static std::vector<std::vector<float>> decode(const std::vector<uint8_t>& bitstream, size_t numThreads = 1) {
+        return decode(bitstream.data(), bitstream.size(), numThreads);
+    }
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 自适应二元概率模型，记录当前符号为0的概率
+class AdaptiveBitModel {
+public:
+    static constexpr uint32_t ProbabilityBits = 11;
+    static constexpr uint32_t ProbabilityOne = 1u << ProbabilityBits;
+    // 概率更新步长，越小适应越快
+    static constexpr uint32_t AdaptationShift = 5;
+
+    uint16_t probability = ProbabilityOne / 2;
+
+    void update(int bit) {
+        if (bit) {
+            probability -= probability >> AdaptationShift;
+        } else {
+            probability += (ProbabilityOne - probability) >> AdaptationShift;
+        }
+    }
+};
+
+// 二元自适应区间编码器（LZMA风格的进位传递实现）
+class RangeEncoder {
+private:
+    static constexpr uint32_t TopValue = 1u << 24;
+
+    std::vector<uint8_t> output;
+    uint64_t low = 0;
+    uint32_t range = 0xFFFFFFFFu;
+    uint8_t cache = 0;
+    uint64_t cacheSize = 1;
+
+    void shiftLow() {
+        if (static_cast<uint32_t>(low) < 0xFF000000u || (low >> 32) != 0) {
+            const uint8_t carry = static_cast<uint8_t>(low >> 32);
+            uint8_t temp = cache;
+            do {
+                output.push_back(static_cast<uint8_t>(temp + carry));
+                temp = 0xFF;
+            } while (--cacheSize != 0);
+            cache = static_cast<uint8_t>(low >> 24);
+        }
+        ++cacheSize;
+        low = (low & 0x00FFFFFFu) << 8;
+    }
+
+    void normalize() {
+        while (range < TopValue) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+public:
+    void encodeBit(AdaptiveBitModel& model, int bit) {
+        const uint32_t bound = (range >> AdaptiveBitModel::ProbabilityBits) * model.probability;
+        if (bit) {
+            low += bound;
+            range -= bound;
+        } else {
+            range = bound;
+        }
+        model.update(bit);
+        normalize();
+    }
+
+    // 以等概率编码value的低numBits位，高位在前
+    void encodeDirectBits(uint32_t value, int numBits) {
+        for (int i = numBits - 1; i >= 0; --i) {
+            range >>= 1;
+            if ((value >> i) & 1u) {
+                low += range;
+            }
+            normalize();
+        }
+    }
+
+    // 结束编码并取出码流
+    std::vector<uint8_t> finish() {
+        for (int i = 0; i < 5; ++i) {
+            shiftLow();
+        }
+        return std::move(output);
+    }
+};
+
+// 与RangeEncoder对应的解码器，读越界时按0补齐
+class RangeDecoder {
+private:
+    static constexpr uint32_t TopValue = 1u << 24;
+
+    const uint8_t* cursor;
+    const uint8_t* end;
+    uint32_t range = 0xFFFFFFFFu;
+    uint32_t code = 0;
+
+    uint8_t nextByte() {
+        return cursor < end ? *cursor++ : 0;
+    }
+
+    void normalize() {
+        while (range < TopValue) {
+            range <<= 8;
+            code = (code << 8) | nextByte();
+        }
+    }
+
+public:
+    RangeDecoder(const uint8_t* data, size_t size) : cursor(data), end(data + size) {
+        for (int i = 0; i < 5; ++i) {
+            code = (code << 8) | nextByte();
+        }
+    }
+
+    int decodeBit(AdaptiveBitModel& model) {
+        const uint32_t bound = (range >> AdaptiveBitModel::ProbabilityBits) * model.probability;
+        int bit;
+        if (code < bound) {
+            range = bound;
+            bit = 0;
+        } else {
+            code -= bound;
+            range -= bound;
+            bit = 1;
+        }
+        model.update(bit);
+        normalize();
+        return bit;
+    }
+
+    uint32_t decodeDirectBits(int numBits) {
+        uint32_t value = 0;
+        for (int i = 0; i < numBits; ++i) {
+            range >>= 1;
+            uint32_t bit = 0;
+            if (code >= range) {
+                code -= range;
+                bit = 1;
+            }
+            value = (value << 1) | bit;
+            normalize();
+        }
+        return value;
+    }
+};
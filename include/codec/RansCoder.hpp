@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 静态模型的rANS熵编码器，符号为字节
+// 编码端先统计直方图并归一化到2^12，频率表写在码流开头；4个状态交错编解码以提高解码的指令级并行度
+// 码流：字母表大小(uint16) + 各符号频率(uint16) + 负载字节数(uint32) + 负载
+class RansCoder {
+private:
+    static constexpr uint32_t ProbabilityBits = 12;
+    static constexpr uint32_t ProbabilityScale = 1u << ProbabilityBits;
+    // 状态的归一化下界，按字节输出
+    static constexpr uint32_t LowerBound = 1u << 23;
+    static constexpr size_t Lanes = 4;
+
+    struct FrequencyTable {
+        std::vector<uint32_t> frequencies;
+        std::vector<uint32_t> starts;
+    };
+
+    // 将直方图按比例缩放到ProbabilityScale，出现过的符号频率至少为1
+    static std::vector<uint32_t> normalize(const std::vector<uint64_t>& counts, size_t total) {
+        std::vector<uint32_t> frequencies(counts.size(), 0);
+        uint32_t sum = 0;
+        size_t largest = 0;
+        for (size_t symbol = 0; symbol < counts.size(); ++symbol) {
+            if (counts[symbol] == 0) {
+                continue;
+            }
+            frequencies[symbol] = std::max<uint32_t>(1, static_cast<uint32_t>(counts[symbol] * ProbabilityScale / total));
+            sum += frequencies[symbol];
+            if (counts[symbol] > counts[largest]) {
+                largest = symbol;
+            }
+        }
+        // 取整不足的部分补给最频繁的符号；下限1带来的超出部分不超过字母表大小，逐个从最大的频率中扣除
+        if (sum <= ProbabilityScale) {
+            frequencies[largest] += ProbabilityScale - sum;
+            return frequencies;
+        }
+        for (; sum > ProbabilityScale; --sum) {
+            --*std::max_element(frequencies.begin(), frequencies.end());
+        }
+        return frequencies;
+    }
+
+    static FrequencyTable makeTable(std::vector<uint32_t> frequencies) {
+        FrequencyTable table{std::move(frequencies), {}};
+        table.starts.resize(table.frequencies.size());
+        uint32_t start = 0;
+        for (size_t symbol = 0; symbol < table.frequencies.size(); ++symbol) {
+            table.starts[symbol] = start;
+            start += table.frequencies[symbol];
+        }
+        if (start != ProbabilityScale) {
+            SPDLOG_ERROR("rANS frequencies sum to {}, expected {}", start, ProbabilityScale);
+            throw std::runtime_error("Invalid rANS frequency table");
+        }
+        return table;
+    }
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& output, T value) {
+        const size_t offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static T read(const uint8_t* data, size_t size, size_t& offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::runtime_error("Truncated rANS bitstream");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+public:
+    /**
+     * @brief 编码符号序列
+     * @param symbols 符号序列，取值需小于alphabetSize
+     * @param alphabetSize 字母表大小，1~256
+     * @return 自包含的码流，解码时需另外给出符号个数
+     * @throw std::runtime_error 如果字母表大小无效或符号越界
+     */
+    static std::vector<uint8_t> encode(const uint8_t* symbols, size_t count, size_t alphabetSize) {
+        if (alphabetSize == 0 || alphabetSize > 256) {
+            throw std::runtime_error("rANS alphabet size must be in [1, 256]");
+        }
+        std::vector<uint64_t> counts(alphabetSize, 0);
+        for (size_t i = 0; i < count; ++i) {
+            if (symbols[i] >= alphabetSize) {
+                SPDLOG_ERROR("rANS symbol {} exceeds alphabet size {}", symbols[i], alphabetSize);
+                throw std::runtime_error("rANS symbol out of range");
+            }
+            ++counts[symbols[i]];
+        }
+
+        std::vector<uint32_t> frequencies(alphabetSize, 0);
+        if (count == 0) {
+            frequencies[0] = ProbabilityScale;
+        } else {
+            frequencies = normalize(counts, count);
+        }
+        const auto table = makeTable(std::move(frequencies));
+
+        // 逆序编码，字节也逆序写出，最后整体翻转，解码端即可顺序读取
+        std::vector<uint8_t> reversed;
+        reversed.reserve(count / 2 + 16);
+        std::array<uint32_t, Lanes> states;
+        states.fill(LowerBound);
+        for (size_t i = count; i-- > 0;) {
+            uint32_t& state = states[i % Lanes];
+            const uint32_t frequency = table.frequencies[symbols[i]];
+            const uint32_t maxState = ((LowerBound >> ProbabilityBits) << 8) * frequency;
+            while (state >= maxState) {
+                reversed.push_back(static_cast<uint8_t>(state));
+                state >>= 8;
+            }
+            state = ((state / frequency) << ProbabilityBits) + state % frequency + table.starts[symbols[i]];
+        }
+        for (size_t lane = Lanes; lane-- > 0;) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                reversed.push_back(static_cast<uint8_t>(states[lane] >> shift));
+            }
+        }
+
+        std::vector<uint8_t> output;
+        output.reserve(2 + alphabetSize * 2 + 4 + reversed.size());
+        append(output, static_cast<uint16_t>(alphabetSize));
+        for (const auto frequency : table.frequencies) {
+            append(output, static_cast<uint16_t>(frequency));
+        }
+        append(output, static_cast<uint32_t>(reversed.size()));
+        output.insert(output.end(), reversed.rbegin(), reversed.rend());
+        return output;
+    }
+
+    /**
+     * @brief 解码符号序列
+     * @param data 由encode生成的码流，其后可以跟随其他数据
+     * @param symbols 输出count个符号
+     * @return 本码流占用的字节数
+     * @throw std::runtime_error 如果码流头损坏
+     */
+    static size_t decode(const uint8_t* data, size_t size, uint8_t* symbols, size_t count) {
+        size_t offset = 0;
+        const size_t alphabetSize = read<uint16_t>(data, size, offset);
+        if (alphabetSize == 0 || alphabetSize > 256) {
+            throw std::runtime_error("Corrupted rANS bitstream: invalid alphabet size");
+        }
+        std::vector<uint32_t> frequencies(alphabetSize);
+        for (auto& frequency : frequencies) {
+            frequency = read<uint16_t>(data, size, offset);
+        }
+        const auto table = makeTable(std::move(frequencies));
+        const size_t payloadSize = read<uint32_t>(data, size, offset);
+        if (payloadSize > size - offset) {
+            throw std::runtime_error("Truncated rANS bitstream");
+        }
+
+        // 频率槽到符号的查找表
+        std::array<uint8_t, ProbabilityScale> slotSymbols;
+        for (size_t symbol = 0; symbol < alphabetSize; ++symbol) {
+            std::fill_n(slotSymbols.begin() + table.starts[symbol], table.frequencies[symbol], static_cast<uint8_t>(symbol));
+        }
+
+        // 读越界时按0补齐，损坏的码流只会得到错误的符号
+        const uint8_t* cursor = data + offset;
+        const uint8_t* end = cursor + payloadSize;
+        auto nextByte = [&cursor, end]() -> uint32_t { return cursor < end ? *cursor++ : 0; };
+
+        std::array<uint32_t, Lanes> states;
+        for (auto& state : states) {
+            state = 0;
+            for (int i = 0; i < 4; ++i) {
+                state = (state << 8) | nextByte();
+            }
+            // 合法码流的状态始终不低于下界，否则归一化循环可能无法结束
+            if (state < LowerBound) {
+                throw std::runtime_error("Corrupted rANS bitstream: invalid initial state");
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t& state = states[i % Lanes];
+            const uint32_t slot = state & (ProbabilityScale - 1);
+            const uint8_t symbol = slotSymbols[slot];
+            state = table.frequencies[symbol] * (state >> ProbabilityBits) + slot - table.starts[symbol];
+            while (state < LowerBound) {
+                state = (state << 8) | nextByte();
+            }
+            symbols[i] = symbol;
+        }
+        return offset + payloadSize;
+    }
+};
@@ -0,0 +1,275 @@
+#pragma once
+
+#include "AttributeCoder.hpp"
+#include "OctreeCoder.hpp"
+#include "QuaternionCoder.hpp"
+#include "Quantization.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "Transform.hpp"
+#include "utils/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 码率控制的目标，二者取其一：每帧码流字节数不超过maxBytes，或几何与属性的PSNR都不低于minPsnr
+struct RateTarget {
+    size_t maxBytes = 0;
+    double minPsnr = 0.0;
+};
+
+// 码率控制的搜索范围
+struct RateControlSettings {
+    // 几何位深在[minPositionBitDepth, 量化时的位深]内搜索
+    int minPositionBitDepth = 10;
+    // 属性各列位深同时降低[0, maxAttributeBitReduction]位，每列至少保留1位
+    int maxAttributeBitReduction = 4;
+};
+
+// 一个工作点及其代价：几何PSNR以世界坐标包围盒的最大边长为峰值，按轴平均平方误差；
+// 属性PSNR在各列的量化值域内归一化，按列平均平方误差
+struct OperatingPoint {
+    int positionBitDepth = 0;
+    int attributeBitReduction = 0;
+    size_t bytes = 0;
+    double positionPsnr = 0.0;
+    double attributePsnr = 0.0;
+};
+
+// 码率控制的编码结果，bbox为所选位深对应的对数域量化包围盒
+struct RateControlledFrame {
+    OperatingPoint point;
+    BoundingBox3D bbox;
+    std::vector<uint8_t> geometry;
+    std::vector<uint8_t> attributes;
+    std::vector<uint8_t> rotations;
+};
+
+/**
+ * @brief 帧级码率控制：在几何位深与属性位深上搜索满足字节预算或PSNR目标的工作点
+ *
+ * 每个试验点都复用一次量化和排序的结果：低位深的几何直接取最高位深量化坐标的高位(q >> s)，
+ * 曲线顺序在高位上同样成立，点序与属性顺序因此不变；配合调整后的包围盒，标准反量化恰好落在粗网格的格子中心。
+ * 几何码流只取决于几何位深，属性码流只取决于属性降低的位数，两张表各自编码一次，组合的代价直接相加
+ */
+class RateController {
+private:
+    // 误差为0时PSNR的上限
+    static constexpr double MaxPsnr = 999.0;
+
+    struct GeometryTrial {
+        std::vector<uint8_t> bitstream;
+        double psnr = 0.0;
+    };
+
+    struct AttributeTrial {
+        std::vector<uint8_t> bitstream;
+        double psnr = 0.0;
+    };
+
+    static double toPsnr(double meanSquaredError, double peak) {
+        if (meanSquaredError <= 0.0 || peak <= 0.0) {
+            return MaxPsnr;
+        }
+        return std::min(MaxPsnr, 10.0 * std::log10(peak * peak / meanSquaredError));
+    }
+
+    static GeometryTrial runGeometryTrial(const std::vector<std::vector<float>>& sortedPositions,
+                                          const std::vector<std::vector<uint16_t>>& sortedQuantized,
+                                          const BoundingBox3D& bbox, int fullBitDepth, int bitDepth, SpaceFillingCurve curve, double peak) {
+        GeometryTrial trial;
+        auto coarse = coarsenPositions(sortedQuantized, fullBitDepth - bitDepth);
+        trial.bitstream = OctreeCoder::encode(coarse, bitDepth, curve);
+
+        auto coarseBBox = coarsenBBox(bbox, fullBitDepth, bitDepth);
+        auto reconstructed = Quantization::dequantizePositionWithBBox<float, uint16_t>(coarse, coarseBBox, bitDepth);
+        Transform::inverseLogTransformInPlace(reconstructed, coarseBBox);
+        double sum = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            for (size_t i = 0; i < sortedPositions[axis].size(); ++i) {
+                const double error = static_cast<double>(reconstructed[axis][i]) - sortedPositions[axis][i];
+                sum += error * error;
+            }
+        }
+        trial.psnr = toPsnr(sum / (3.0 * static_cast<double>(sortedPositions[0].size())), peak);
+        return trial;
+    }
+
+    static AttributeTrial runAttributeTrial(const std::vector<std::vector<float>>& sortedAttributes,
+                                            const std::vector<AttributeQuantization>& settings, int reduction) {
+        AttributeTrial trial;
+        const auto reduced = reduceAttributeBitDepth(settings, reduction);
+        trial.bitstream = AttributeCoder::encode(sortedAttributes, reduced);
+
+        // 在量化值域内以范围归一化，不同量纲的列可以直接平均；NaN不计入
+        double sum = 0.0;
+        size_t samples = 0;
+        for (size_t column = 0; column < sortedAttributes.size(); ++column) {
+            const auto& values = sortedAttributes[column];
+            const auto& columnSettings = reduced[column];
+            const auto range = columnSettings.range ? *columnSettings.range : AttributeCoder::computeRange(values, columnSettings.domain);
+            const float extent = range[1] - range[0];
+            if (extent <= 0.0f) {
+                samples += values.size();
+                continue;
+            }
+            const auto levels = AttributeCoder::quantize(values, columnSettings.domain, columnSettings.bitDepth, range);
+            const double step = extent / static_cast<double>((1u << columnSettings.bitDepth) - 1);
+            for (size_t i = 0; i < values.size(); ++i) {
+                const float original = AttributeCoder::toDomain(values[i], columnSettings.domain);
+                if (std::isnan(original)) {
+                    continue;
+                }
+                const double error = (levels[i] * step + range[0] - original) / extent;
+                sum += error * error;
+                ++samples;
+            }
+        }
+        trial.psnr = toPsnr(samples > 0 ? sum / static_cast<double>(samples) : 0.0, 1.0);
+        return trial;
+    }
+
+public:
+    /**
+     * @brief 取量化坐标的高位，得到低位深的坐标，曲线顺序保持不变
+     * @param shift 丢弃的低位数
+     */
+    static std::vector<std::vector<uint16_t>> coarsenPositions(const std::vector<std::vector<uint16_t>>& quantized, int shift) {
+        std::vector<std::vector<uint16_t>> coarse(quantized.size());
+        for (size_t axis = 0; axis < quantized.size(); ++axis) {
+            coarse[axis].resize(quantized[axis].size());
+            std::transform(quantized[axis].begin(), quantized[axis].end(), coarse[axis].begin(),
+                           [shift](uint16_t value) { return static_cast<uint16_t>(value >> shift); });
+        }
+        return coarse;
+    }
+
+    /**
+     * @brief coarsenPositions对应的对数域包围盒：粗网格的步长为细网格的2^shift倍，
+     * 起点移到第一个格子的中心，在bitDepth位上按标准方式反量化即得到各格子的中心
+     */
+    static BoundingBox3D coarsenBBox(const BoundingBox3D& bbox, int fullBitDepth, int bitDepth) {
+        if (bitDepth == fullBitDepth) {
+            return bbox;
+        }
+        BoundingBox3D coarse = bbox;
+        const double cellLevels = static_cast<double>(1u << (fullBitDepth - bitDepth));
+        const double fullLevels = static_cast<double>((1u << fullBitDepth) - 1);
+        const double coarseLevels = static_cast<double>((1u << bitDepth) - 1);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const double step = (static_cast<double>(bbox.data[axis + 3]) - bbox.data[axis]) / fullLevels;
+            const double minValue = bbox.data[axis] + step * (cellLevels - 1.0) * 0.5;
+            coarse.data[axis] = static_cast<float>(minValue);
+            coarse.data[axis + 3] = static_cast<float>(minValue + step * cellLevels * coarseLevels);
+        }
+        return coarse;
+    }
+
+    /**
+     * @brief 各列位深同时降低reduction位，每列至少保留1位
+     */
+    static std::vector<AttributeQuantization> reduceAttributeBitDepth(const std::vector<AttributeQuantization>& settings, int reduction) {
+        auto reduced = settings;
+        for (auto& column : reduced) {
+            column.bitDepth = std::max(1, column.bitDepth - reduction);
+        }
+        return reduced;
+    }
+
+    /**
+     * @brief 搜索工作点并输出对应的码流
+     * @param sortedPositions 3列世界坐标，与sortedQuantized同序，用于度量几何误差
+     * @param sortedQuantized 在fullBitDepth位上量化并按curve排列的坐标
+     * @param bbox 量化所用的对数域包围盒
+     * @param sortedAttributes 与坐标同序的属性列
+     * @param attributeSettings 最高质量的属性量化设置，与属性列一一对应
+     * @param sortedRotations 与坐标同序的4列四元数，不参与搜索
+     * @param numThreads 线程数，各试验点并行编码，0表示使用全部硬件线程
+     * @return 字节预算下PSNR均值最高的工作点，或满足PSNR目标的最小工作点；目标无法达到时分别退回最小或最高质量的工作点
+     * @throw std::runtime_error 如果目标或搜索范围无效
+     */
+    static RateControlledFrame encode(const std::vector<std::vector<float>>& sortedPositions,
+                                      const std::vector<std::vector<uint16_t>>& sortedQuantized,
+                                      const BoundingBox3D& bbox, int fullBitDepth, SpaceFillingCurve curve,
+                                      const std::vector<std::vector<float>>& sortedAttributes,
+                                      const std::vector<AttributeQuantization>& attributeSettings,
+                                      const std::vector<std::vector<float>>& sortedRotations,
+                                      const RateTarget& target, const RateControlSettings& settings = {}, size_t numThreads = 1) {
+        if ((target.maxBytes == 0) == (target.minPsnr <= 0.0)) {
+            SPDLOG_ERROR("Rate target must set exactly one of the byte budget and the PSNR");
+            throw std::runtime_error("Rate target must set exactly one of the byte budget and the PSNR");
+        }
+        if (fullBitDepth < 1 || fullBitDepth > 16 || settings.minPositionBitDepth < 1 || settings.minPositionBitDepth > fullBitDepth
+            || settings.maxAttributeBitReduction < 0) {
+            SPDLOG_ERROR("Invalid rate control range: bit depth {} down to {}, attribute reduction {}",
+                         fullBitDepth, settings.minPositionBitDepth, settings.maxAttributeBitReduction);
+            throw std::runtime_error("Invalid rate control range");
+        }
+
+        const auto worldBBox = BoundingBox3D::calculateFromPoints(sortedPositions, numThreads);
+        double peak = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            peak = std::max(peak, static_cast<double>(worldBBox.data[axis + 3]) - worldBBox.data[axis]);
+        }
+
+        // 几何表、属性表和旋转共用一组任务，各任务单线程，任务之间并行
+        const int minBitDepth = settings.minPositionBitDepth;
+        const size_t geometryTrials = static_cast<size_t>(fullBitDepth - minBitDepth + 1);
+        const size_t attributeTrials = static_cast<size_t>(settings.maxAttributeBitReduction + 1);
+        std::vector<GeometryTrial> geometry(geometryTrials);
+        std::vector<AttributeTrial> attributes(attributeTrials);
+        std::vector<uint8_t> rotations;
+        Parallel::forRange(geometryTrials + attributeTrials + 1, numThreads, [&](size_t first, size_t last) {
+            for (size_t job = first; job < last; ++job) {
+                if (job < geometryTrials) {
+                    geometry[job] = runGeometryTrial(sortedPositions, sortedQuantized, bbox, fullBitDepth,
+                                                     minBitDepth + static_cast<int>(job), curve, peak);
+                } else if (job < geometryTrials + attributeTrials) {
+                    attributes[job - geometryTrials] = runAttributeTrial(sortedAttributes, attributeSettings, static_cast<int>(job - geometryTrials));
+                } else {
+                    rotations = QuaternionCoder::encode(sortedRotations);
+                }
+            }
+        }, 1);
+
+        // 两张表的所有组合中按目标选择
+        const auto quality = [](const OperatingPoint& point) { return (point.positionPsnr + point.attributePsnr) * 0.5; };
+        std::optional<OperatingPoint> best;
+        OperatingPoint smallest;
+        OperatingPoint finest;
+        for (size_t g = 0; g < geometryTrials; ++g) {
+            for (size_t a = 0; a < attributeTrials; ++a) {
+                OperatingPoint point{minBitDepth + static_cast<int>(g), static_cast<int>(a),
+                                     geometry[g].bitstream.size() + attributes[a].bitstream.size() + rotations.size(),
+                                     geometry[g].psnr, attributes[a].psnr};
+                if ((g == 0 && a == 0) || point.bytes < smallest.bytes) {
+                    smallest = point;
+                }
+                if (g + 1 == geometryTrials && a == 0) {
+                    finest = point;
+                }
+                if (target.maxBytes > 0) {
+                    if (point.bytes <= target.maxBytes && (!best || quality(point) > quality(*best)
+                                                           || (quality(point) == quality(*best) && point.bytes < best->bytes))) {
+                        best = point;
+                    }
+                } else if (std::min(point.positionPsnr, point.attributePsnr) >= target.minPsnr && (!best || point.bytes < best->bytes)) {
+                    best = point;
+                }
+            }
+        }
+        if (!best) {
+            best = target.maxBytes > 0 ? smallest : finest;
+            SPDLOG_WARN("Rate target is not reachable, using {} bits for positions and attribute reduction {} ({} bytes)",
+                        best->positionBitDepth, best->attributeBitReduction, best->bytes);
+        }
+
+        const size_t g = static_cast<size_t>(best->positionBitDepth - minBitDepth);
+        const size_t a = static_cast<size_t>(best->attributeBitReduction);
+        return {*best, coarsenBBox(bbox, fullBitDepth, best->positionBitDepth),
+                std::move(geometry[g].bitstream), std::move(attributes[a].bitstream), std::move(rotations)};
+    }
+};
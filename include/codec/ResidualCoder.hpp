@@ -0,0 +1,126 @@
+#pragma once
+
+#include "BitStream.hpp"
+#include "RansCoder.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 有符号整数残差的熵编码
+// 残差做zigzag映射后分为token和原始位：小于16的值直接作为token，其余按位宽与次高位组成token，剩余低位原样写出；
+// token经rANS编码，原始位紧随其后。码流不自带长度，由外层记录
+class ResidualCoder {
+private:
+    static constexpr uint32_t DirectTokens = 16;
+
+    static uint32_t toZigzag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static int32_t fromZigzag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1u);
+    }
+
+    static uint8_t tokenize(uint32_t value, BitWriter& rawBits) {
+        if (value < DirectTokens) {
+            return static_cast<uint8_t>(value);
+        }
+        const int width = std::bit_width(value);
+        rawBits.write(value, width - 2);
+        return static_cast<uint8_t>(DirectTokens + (width - 5) * 2 + ((value >> (width - 2)) & 1u));
+    }
+
+    static uint32_t detokenize(uint8_t token, BitReader& rawBits) {
+        if (token < DirectTokens) {
+            return token;
+        }
+        const int width = (token - DirectTokens) / 2 + 5;
+        const uint32_t top = 2u | ((token - DirectTokens) & 1u);
+        return (top << (width - 2)) | rawBits.read(width - 2);
+    }
+
+    static void checkBitDepth(int bitDepth) {
+        if (bitDepth < 1 || bitDepth > MaxBitDepth) {
+            SPDLOG_ERROR("Invalid residual bit depth: {}", bitDepth);
+            throw std::runtime_error("Invalid residual bit depth: " + std::to_string(bitDepth));
+        }
+    }
+
+public:
+    static constexpr int MaxBitDepth = 30;
+
+    // 残差绝对值小于2^bitDepth时使用的字母表大小
+    static size_t getAlphabetSize(int bitDepth) {
+        return DirectTokens + 2 * static_cast<size_t>(std::max(0, bitDepth + 1 - 4));
+    }
+
+    /**
+     * @brief 编码count个残差
+     * @param bitDepth 残差绝对值的位数上限，即|r| < 2^bitDepth
+     * @throw std::runtime_error 如果位深无效或残差超出位深
+     */
+    static std::vector<uint8_t> encode(const int32_t* residuals, size_t count, int bitDepth) {
+        checkBitDepth(bitDepth);
+        const uint32_t limit = 1u << (bitDepth + 1);
+        std::vector<uint8_t> tokens(count);
+        BitWriter rawBits;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t zigzag = toZigzag(residuals[i]);
+            if (zigzag >= limit) {
+                SPDLOG_ERROR("Residual {} exceeds {} bits", residuals[i], bitDepth);
+                throw std::runtime_error("Residual exceeds bit depth");
+            }
+            tokens[i] = tokenize(zigzag, rawBits);
+        }
+        auto output = RansCoder::encode(tokens.data(), count, getAlphabetSize(bitDepth));
+        const auto raw = rawBits.finish();
+        output.insert(output.end(), raw.begin(), raw.end());
+        return output;
+    }
+
+    /**
+     * @brief 解码count个残差
+     * @param data 由encode生成的完整码流
+     * @throw std::runtime_error 如果码流损坏
+     */
+    static void decode(const uint8_t* data, size_t size, int32_t* residuals, size_t count, int bitDepth) {
+        checkBitDepth(bitDepth);
+        std::vector<uint8_t> tokens(count);
+        const size_t tokenBytes = RansCoder::decode(data, size, tokens.data(), count);
+        const size_t alphabetSize = getAlphabetSize(bitDepth);
+        BitReader rawBits(data + tokenBytes, size - tokenBytes);
+        for (size_t i = 0; i < count; ++i) {
+            if (tokens[i] >= alphabetSize) {
+                throw std::runtime_error("Corrupted residual bitstream: token out of range");
+            }
+            residuals[i] = fromZigzag(detokenize(tokens[i], rawBits));
+        }
+    }
+
+    // 差分编码：第一个值以0为预测，其余以前一个值为预测
+    template<typename T>
+    static std::vector<uint8_t> encodeDelta(const T* values, size_t count, int bitDepth) {
+        std::vector<int32_t> residuals(count);
+        int32_t previous = 0;
+        for (size_t i = 0; i < count; ++i) {
+            residuals[i] = static_cast<int32_t>(values[i]) - previous;
+            previous = static_cast<int32_t>(values[i]);
+        }
+        return encode(residuals.data(), count, bitDepth);
+    }
+
+    template<typename T>
+    static void decodeDelta(const uint8_t* data, size_t size, T* values, size_t count, int bitDepth) {
+        std::vector<int32_t> residuals(count);
+        decode(data, size, residuals.data(), count, bitDepth);
+        int32_t previous = 0;
+        for (size_t i = 0; i < count; ++i) {
+            previous += residuals[i];
+            values[i] = static_cast<T>(previous);
+        }
+    }
+};
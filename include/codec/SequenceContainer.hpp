@@ -0,0 +1,515 @@
+#pragma once
+
+#include "AttributeCoder.hpp"
+#include "Quantization.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "io/FileTools.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <mio/mmap.hpp>
+#include <spdlog/spdlog.h>
+
+// 序列中各帧负载的编码方式
+enum class SequenceCoding : uint8_t {
+    // 每帧独立编码，负载为对数域量化包围盒(6 x float)、几何、属性、旋转四个分段，
+    // 几何按元数据中的位深在该包围盒上反量化后做逆对数变换
+    INTRA = 0,
+    // 帧间编码，负载为TemporalEncoder输出的单帧码流
+    TEMPORAL = 1,
+    // 渐进式帧内编码，负载为量化包围盒与ProgressiveCoder码流两个分段，负载的任意前缀都可解码出低细节层次的预览
+    PROGRESSIVE = 2,
+    // 静态场景按曲线切成的空间块，每项是一块而不是一个时刻；负载布局与INTRA相同，
+    // 但各块的包围盒分段都是整个场景共用的同一量化网格，块边界上的点在相邻块中落在一致的格子里
+    SCENE = 3,
+    // 空间分块帧内编码，负载为TileCoder输出的单帧码流，各块可并行解码
+    TILED = 4,
+    // 分块自适应量化的帧内编码，负载为分块几何、属性、旋转三个分段；元数据的位深为全局网格位深
+    BLOCKED = 5,
+    // 码率控制的帧内编码，每帧位深不同，负载为对数域包围盒、几何、属性、旋转四个分段
+    RATE_CONTROLLED = 6
+};
+
+// 序列级元数据，解码任意一帧前需要的全部参数
+struct SequenceMetadata {
+    SequenceCoding coding = SequenceCoding::INTRA;
+    // 几何量化位深；码率控制模式下为各帧位深的上限，实际位深见各帧的几何码流
+    int positionBitDepth = 16;
+    SpaceFillingCurve curve = SpaceFillingCurve::MORTON;
+    // 帧间编码的关键帧间隔，帧内编码时为1
+    uint32_t keyframeInterval = 1;
+    // 与解码输出各列对应的PLY属性名
+    std::vector<std::string> positionNames;
+    std::vector<std::string> attributeNames;
+    std::vector<std::string> rotationNames;
+    std::vector<AttributeQuantization> attributeQuantization;
+    // 全序列原始坐标的包围盒，由写入的各帧合并而来
+    BoundingBox3D bbox{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// 帧索引表的一项，定长以便按帧号直接定位
+struct FrameIndexEntry {
+    // 负载在文件中的偏移，按文件头中的对齐值对齐
+    uint64_t offset = 0;
+    // 负载字节数，0表示该帧缺失(编码失败)
+    uint64_t size = 0;
+    uint32_t pointCount = 0;
+    // 标志位，见SequenceContainer::KeyFrameFlag
+    uint32_t flags = 0;
+};
+
+/**
+ * @brief 多帧序列容器：一个文件保存整个序列，播放端映射后可按帧号O(1)定位任意一帧
+ *
+ * 文件布局：文件头(64字节) + 元数据 + 各帧负载(按alignment对齐) + 帧索引表(每帧24字节)
+ * 文件头：magic "GSSQ" + 版本(uint16) + 保留(uint16) + 对齐(uint32) + 帧数(uint32) + 元数据偏移与字节数(uint64 x 2)
+ *        + 索引表偏移(uint64) + 序列包围盒(6 x float)
+ * 帧负载可以按任意顺序写入，索引表与文件头在finish时写出，因此多帧流水线中先完成的帧可以先写。
+ */
+class SequenceContainer {
+public:
+    static constexpr std::array<char, 4> Magic = {'G', 'S', 'S', 'Q'};
+    static constexpr uint16_t Version = 1;
+    static constexpr size_t HeaderSize = 64;
+    static constexpr size_t IndexEntrySize = 24;
+    // 关键帧可以独立解码，作为随机访问的起点
+    static constexpr uint32_t KeyFrameFlag = 1u;
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& output, T value) {
+        const size_t offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static T read(const uint8_t* data, size_t size, size_t& offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::runtime_error("Truncated sequence container");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    // packBBox输出的分段字节数
+    static constexpr size_t BBoxSectionSize = 6 * sizeof(float);
+
+    /**
+     * @brief packSections在各段数据之外附加的字节数：分段数(uint8) + 各段字节数(uint64)
+     * @param sectionCount 分段数
+     * @return 附加字节数
+     */
+    static constexpr size_t sectionsOverhead(size_t sectionCount) {
+        return sizeof(uint8_t) + sectionCount * sizeof(uint64_t);
+    }
+
+    /**
+     * @brief 对数域量化包围盒的负载分段：6 x float，解码端据此反量化几何
+     */
+    static std::vector<uint8_t> packBBox(const BoundingBox3D& bbox) {
+        std::vector<uint8_t> section(BBoxSectionSize);
+        std::memcpy(section.data(), bbox.data.data(), section.size());
+        return section;
+    }
+
+    /**
+     * @brief packBBox的逆过程
+     * @throw std::runtime_error 如果分段长度不是6个float
+     */
+    static BoundingBox3D unpackBBox(std::span<const uint8_t> section) {
+        BoundingBox3D bbox{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        if (section.size() != BBoxSectionSize) {
+            throw std::runtime_error("Corrupted frame payload: invalid bounding box section");
+        }
+        std::memcpy(bbox.data.data(), section.data(), section.size());
+        return bbox;
+    }
+
+    /**
+     * @brief 将多个码流打包为一个帧负载：分段数(uint8) + 各段字节数(uint64) + 各段数据
+     * @throw std::runtime_error 如果分段多于255个
+     */
+    static std::vector<uint8_t> packSections(const std::vector<std::vector<uint8_t>>& sections) {
+        if (sections.size() > UINT8_MAX) {
+            throw std::runtime_error("Too many sections in a frame payload");
+        }
+        std::vector<uint8_t> payload;
+        append(payload, static_cast<uint8_t>(sections.size()));
+        for (const auto& section : sections) {
+            append(payload, static_cast<uint64_t>(section.size()));
+        }
+        for (const auto& section : sections) {
+            payload.insert(payload.end(), section.begin(), section.end());
+        }
+        return payload;
+    }
+
+    /**
+     * @brief packSections的逆过程，返回指向负载内部的视图
+     * @throw std::runtime_error 如果负载损坏
+     */
+    static std::vector<std::span<const uint8_t>> unpackSections(std::span<const uint8_t> payload) {
+        size_t offset = 0;
+        const size_t count = read<uint8_t>(payload.data(), payload.size(), offset);
+        std::vector<uint64_t> sizes(count);
+        for (auto& size : sizes) {
+            size = read<uint64_t>(payload.data(), payload.size(), offset);
+        }
+        std::vector<std::span<const uint8_t>> sections;
+        sections.reserve(count);
+        for (const uint64_t size : sizes) {
+            if (size > payload.size() - offset) {
+                throw std::runtime_error("Corrupted frame payload: section exceeds payload");
+            }
+            sections.push_back(payload.subspan(offset, size));
+            offset += size;
+        }
+        return sections;
+    }
+
+    static std::vector<uint8_t> serializeMetadata(const SequenceMetadata& metadata) {
+        std::vector<uint8_t> output;
+        append(output, static_cast<uint8_t>(metadata.coding));
+        append(output, static_cast<uint8_t>(metadata.positionBitDepth));
+        append(output, static_cast<uint8_t>(metadata.curve));
+        append(output, metadata.keyframeInterval);
+        for (const auto* names : {&metadata.positionNames, &metadata.attributeNames, &metadata.rotationNames}) {
+            append(output, static_cast<uint16_t>(names->size()));
+            for (const auto& name : *names) {
+                append(output, static_cast<uint16_t>(name.size()));
+                output.insert(output.end(), name.begin(), name.end());
+            }
+        }
+        append(output, static_cast<uint8_t>(metadata.attributeQuantization.size()));
+        for (const auto& quantization : metadata.attributeQuantization) {
+            append(output, static_cast<uint8_t>(quantization.domain));
+            append(output, static_cast<uint8_t>(quantization.bitDepth));
+            append(output, static_cast<uint8_t>(quantization.range.has_value()));
+            const auto range = quantization.range.value_or(std::array<float, 2>{0.0f, 0.0f});
+            append(output, range[0]);
+            append(output, range[1]);
+        }
+        return output;
+    }
+
+    /**
+     * @brief 解析元数据，包围盒不在元数据中，由文件头给出
+     * @throw std::runtime_error 如果元数据损坏
+     */
+    static SequenceMetadata deserializeMetadata(const uint8_t* data, size_t size) {
+        SequenceMetadata metadata;
+        size_t offset = 0;
+        const uint8_t coding = read<uint8_t>(data, size, offset);
+        metadata.positionBitDepth = read<uint8_t>(data, size, offset);
+        const uint8_t curve = read<uint8_t>(data, size, offset);
+        if (coding > static_cast<uint8_t>(SequenceCoding::RATE_CONTROLLED) || curve > static_cast<uint8_t>(SpaceFillingCurve::HILBERT)) {
+            throw std::runtime_error("Corrupted sequence metadata");
+        }
+        metadata.coding = static_cast<SequenceCoding>(coding);
+        metadata.curve = static_cast<SpaceFillingCurve>(curve);
+        metadata.keyframeInterval = read<uint32_t>(data, size, offset);
+        for (auto* names : {&metadata.positionNames, &metadata.attributeNames, &metadata.rotationNames}) {
+            names->resize(read<uint16_t>(data, size, offset));
+            for (auto& name : *names) {
+                const size_t length = read<uint16_t>(data, size, offset);
+                if (length > size - offset) {
+                    throw std::runtime_error("Truncated sequence container");
+                }
+                name.assign(reinterpret_cast<const char*>(data + offset), length);
+                offset += length;
+            }
+        }
+        metadata.attributeQuantization.resize(read<uint8_t>(data, size, offset));
+        for (auto& quantization : metadata.attributeQuantization) {
+            const uint8_t domain = read<uint8_t>(data, size, offset);
+            if (domain > static_cast<uint8_t>(AttributeDomain::SIGMOID)) {
+                throw std::runtime_error("Corrupted sequence metadata");
+            }
+            quantization.domain = static_cast<AttributeDomain>(domain);
+            quantization.bitDepth = read<uint8_t>(data, size, offset);
+            const bool hasRange = read<uint8_t>(data, size, offset) != 0;
+            const float minValue = read<float>(data, size, offset);
+            const float maxValue = read<float>(data, size, offset);
+            if (hasRange) {
+                quantization.range = std::array<float, 2>{minValue, maxValue};
+            }
+        }
+        return metadata;
+    }
+};
+
+/**
+ * @brief 序列容器的写入端，writeFrame线程安全且可按任意帧序调用
+ */
+class SequenceWriter {
+private:
+    std::string filePath;
+    SequenceMetadata metadata;
+    uint32_t alignment;
+    std::ofstream file;
+    std::mutex mutex;
+    uint64_t position = 0;
+    std::vector<FrameIndexEntry> index;
+    bool hasBBox = false;
+    bool finished = false;
+
+    void writePadding(uint64_t target) {
+        static constexpr std::array<char, 64> zeros{};
+        while (position < target) {
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(zeros.size(), target - position));
+            file.write(zeros.data(), static_cast<std::streamsize>(count));
+            position += count;
+        }
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        position += size;
+    }
+
+    uint64_t alignUp(uint64_t value) const {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    std::vector<uint8_t> makeHeader(uint64_t metadataSize, uint64_t indexOffset) const {
+        std::vector<uint8_t> header(SequenceContainer::Magic.begin(), SequenceContainer::Magic.end());
+        SequenceContainer::append(header, SequenceContainer::Version);
+        SequenceContainer::append(header, static_cast<uint16_t>(0));
+        SequenceContainer::append(header, alignment);
+        SequenceContainer::append(header, static_cast<uint32_t>(index.size()));
+        SequenceContainer::append(header, static_cast<uint64_t>(SequenceContainer::HeaderSize));
+        SequenceContainer::append(header, metadataSize);
+        SequenceContainer::append(header, indexOffset);
+        for (const float value : metadata.bbox.data) {
+            SequenceContainer::append(header, value);
+        }
+        return header;
+    }
+
+public:
+    /**
+     * @brief 创建序列文件并写入元数据
+     * @param frameCount 序列的帧数，索引表按此分配
+     * @param alignment 帧负载的对齐字节数，须为2的幂
+     * @throw std::runtime_error 如果对齐值无效或无法创建文件
+     */
+    SequenceWriter(const std::string& filePath, SequenceMetadata metadata, size_t frameCount, uint32_t alignment = 64)
+        : filePath(filePath), metadata(std::move(metadata)), alignment(alignment), index(frameCount) {
+        if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+            SPDLOG_ERROR("Sequence payload alignment must be a power of two, got {}", alignment);
+            throw std::runtime_error("Invalid sequence payload alignment");
+        }
+        if (frameCount > UINT32_MAX) {
+            throw std::runtime_error("Too many frames for a sequence container");
+        }
+        FileTools::checkAndCreateDir(filePath);
+        file.open(filePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            SPDLOG_ERROR("Failed to open file for writing: {}", filePath);
+            throw std::runtime_error("Failed to open file for writing: " + filePath);
+        }
+        // 文件头在finish时改写，此处先占位
+        const auto metadataBytes = SequenceContainer::serializeMetadata(this->metadata);
+        const auto header = makeHeader(metadataBytes.size(), 0);
+        writeBytes(header.data(), header.size());
+        writeBytes(metadataBytes.data(), metadataBytes.size());
+    }
+
+    ~SequenceWriter() {
+        if (!finished) {
+            try {
+                finish();
+            } catch (const std::exception& e) {
+                SPDLOG_ERROR("Failed to finish sequence {}: {}", filePath, e.what());
+            }
+        }
+    }
+
+    SequenceWriter(const SequenceWriter&) = delete;
+    SequenceWriter& operator=(const SequenceWriter&) = delete;
+
+    /**
+     * @brief 写入一帧的负载
+     * @param frameIndex 帧号，每帧只能写入一次
+     * @param bbox 该帧原始坐标的包围盒，并入序列包围盒
+     * @throw std::runtime_error 如果帧号越界、重复写入或写文件失败
+     */
+    void writeFrame(size_t frameIndex, const std::vector<uint8_t>& payload, size_t pointCount, bool keyFrame, const BoundingBox3D& bbox) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished || frameIndex >= index.size() || index[frameIndex].size != 0 || payload.empty() || pointCount > UINT32_MAX) {
+            SPDLOG_ERROR("Invalid write of frame {} ({} frames, finished: {})", frameIndex, index.size(), finished);
+            throw std::runtime_error("Invalid sequence frame write");
+        }
+        writePadding(alignUp(position));
+        index[frameIndex] = {position, payload.size(), static_cast<uint32_t>(pointCount), keyFrame ? SequenceContainer::KeyFrameFlag : 0u};
+        writeBytes(payload.data(), payload.size());
+        if (!file) {
+            throw std::runtime_error("Failed to write sequence file: " + filePath);
+        }
+
+        for (size_t axis = 0; axis < 3; ++axis) {
+            metadata.bbox.data[axis] = hasBBox ? std::min(metadata.bbox.data[axis], bbox.data[axis]) : bbox.data[axis];
+            metadata.bbox.data[axis + 3] = hasBBox ? std::max(metadata.bbox.data[axis + 3], bbox.data[axis + 3]) : bbox.data[axis + 3];
+        }
+        hasBBox = true;
+    }
+
+    /**
+     * @brief 写出索引表并更新文件头，之后不能再写入帧
+     * @throw std::runtime_error 如果写文件失败
+     */
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished) {
+            return;
+        }
+        finished = true;
+        writePadding(alignUp(position));
+        const uint64_t indexOffset = position;
+        for (const auto& entry : index) {
+            std::vector<uint8_t> bytes;
+            SequenceContainer::append(bytes, entry.offset);
+            SequenceContainer::append(bytes, entry.size);
+            SequenceContainer::append(bytes, entry.pointCount);
+            SequenceContainer::append(bytes, entry.flags);
+            writeBytes(bytes.data(), bytes.size());
+        }
+        const auto metadataBytes = SequenceContainer::serializeMetadata(metadata);
+        const auto header = makeHeader(metadataBytes.size(), indexOffset);
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Failed to write sequence file: " + filePath);
+        }
+    }
+};
+
+/**
+ * @brief 序列容器的读取端：映射整个文件，帧负载直接指向映射区域，不拷贝
+ */
+class SequenceReader {
+private:
+    mio::mmap_source mmap;
+    SequenceMetadata metadata;
+    uint32_t alignment = 0;
+    const uint8_t* indexTable = nullptr;
+    size_t frameCount = 0;
+
+    const uint8_t* data() const {
+        return reinterpret_cast<const uint8_t*>(mmap.data());
+    }
+
+public:
+    /**
+     * @brief 映射序列文件并解析文件头、元数据与索引表位置
+     * @throw std::runtime_error 如果无法映射文件或文件损坏
+     */
+    explicit SequenceReader(const std::string& filePath) {
+        FileTools::checkFileExists(filePath);
+        std::error_code error;
+        mmap = mio::make_mmap_source(filePath, error);
+        if (error) {
+            SPDLOG_ERROR("Failed to mmap file: {}, error: {}", filePath, error.message());
+            throw std::runtime_error("Failed to mmap file: " + filePath + ", error: " + error.message());
+        }
+        const size_t size = mmap.size();
+        if (size < SequenceContainer::HeaderSize || std::memcmp(data(), SequenceContainer::Magic.data(), SequenceContainer::Magic.size()) != 0) {
+            SPDLOG_ERROR("Not a sequence container: {}", filePath);
+            throw std::runtime_error("Not a sequence container: " + filePath);
+        }
+
+        size_t offset = SequenceContainer::Magic.size();
+        const auto version = SequenceContainer::read<uint16_t>(data(), size, offset);
+        if (version != SequenceContainer::Version) {
+            SPDLOG_ERROR("Unsupported sequence container version {}", version);
+            throw std::runtime_error("Unsupported sequence container version");
+        }
+        offset += sizeof(uint16_t);
+        alignment = SequenceContainer::read<uint32_t>(data(), size, offset);
+        frameCount = SequenceContainer::read<uint32_t>(data(), size, offset);
+        const auto metadataOffset = SequenceContainer::read<uint64_t>(data(), size, offset);
+        const auto metadataSize = SequenceContainer::read<uint64_t>(data(), size, offset);
+        const auto indexOffset = SequenceContainer::read<uint64_t>(data(), size, offset);
+        if (metadataOffset > size || metadataSize > size - metadataOffset
+            || indexOffset > size || static_cast<uint64_t>(frameCount) * SequenceContainer::IndexEntrySize > size - indexOffset) {
+            throw std::runtime_error("Corrupted sequence container: header out of range");
+        }
+        metadata = SequenceContainer::deserializeMetadata(data() + metadataOffset, metadataSize);
+        for (float& value : metadata.bbox.data) {
+            value = SequenceContainer::read<float>(data(), size, offset);
+        }
+        indexTable = data() + indexOffset;
+    }
+
+    const SequenceMetadata& getMetadata() const {
+        return metadata;
+    }
+
+    size_t getFrameCount() const {
+        return frameCount;
+    }
+
+    uint32_t getAlignment() const {
+        return alignment;
+    }
+
+    /**
+     * @brief 读取第frameIndex帧的索引项
+     * @throw std::out_of_range 如果帧号越界
+     * @throw std::runtime_error 如果负载超出文件范围
+     */
+    FrameIndexEntry getEntry(size_t frameIndex) const {
+        if (frameIndex >= frameCount) {
+            throw std::out_of_range("Sequence frame index out of range: " + std::to_string(frameIndex));
+        }
+        const uint8_t* entryData = indexTable + frameIndex * SequenceContainer::IndexEntrySize;
+        FrameIndexEntry entry;
+        size_t offset = 0;
+        entry.offset = SequenceContainer::read<uint64_t>(entryData, SequenceContainer::IndexEntrySize, offset);
+        entry.size = SequenceContainer::read<uint64_t>(entryData, SequenceContainer::IndexEntrySize, offset);
+        entry.pointCount = SequenceContainer::read<uint32_t>(entryData, SequenceContainer::IndexEntrySize, offset);
+        entry.flags = SequenceContainer::read<uint32_t>(entryData, SequenceContainer::IndexEntrySize, offset);
+        if (entry.offset > mmap.size() || entry.size > mmap.size() - entry.offset) {
+            throw std::runtime_error("Corrupted sequence container: frame out of range");
+        }
+        return entry;
+    }
+
+    /**
+     * @brief 第frameIndex帧的负载，指向映射区域，生命周期与reader相同；缺失的帧返回空
+     * @throw std::out_of_range 如果帧号越界
+     */
+    std::span<const uint8_t> getFrame(size_t frameIndex) const {
+        const auto entry = getEntry(frameIndex);
+        return {data() + entry.offset, static_cast<size_t>(entry.size)};
+    }
+
+    bool isKeyFrame(size_t frameIndex) const {
+        return (getEntry(frameIndex).flags & SequenceContainer::KeyFrameFlag) != 0;
+    }
+
+    /**
+     * @brief 解码第frameIndex帧需要从哪一帧开始，即不晚于它的最近关键帧
+     * @throw std::out_of_range 如果帧号越界
+     * @throw std::runtime_error 如果之前没有关键帧
+     */
+    size_t findKeyFrame(size_t frameIndex) const {
+        for (size_t i = frameIndex + 1; i-- > 0;) {
+            if (isKeyFrame(i)) {
+                return i;
+            }
+        }
+        throw std::runtime_error("No key frame before frame " + std::to_string(frameIndex));
+    }
+};
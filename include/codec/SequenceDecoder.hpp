@@ -0,0 +1,161 @@
+#pragma once
+
+#include "codec/SequenceContainer.hpp"
+#include "codec/Transform.hpp"
+#include "codec/Quantization.hpp"
+#include "codec/OctreeCoder.hpp"
+#include "codec/AttributeCoder.hpp"
+#include "codec/QuaternionCoder.hpp"
+#include "codec/TemporalCoder.hpp"
+#include "codec/ProgressiveCoder.hpp"
+#include "codec/TileCoder.hpp"
+#include "codec/BlockQuantizer.hpp"
+#include <climits>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+/**
+ * @brief 序列容器的解码端：按元数据中的编码模式解析帧负载，输出与编码端重建逐位相同的帧
+ *
+ * 帧内类模式的每帧独立解码；帧间模式从不晚于目标帧的最近关键帧开始顺序解码，
+ * 顺序播放时复用上一帧的解码状态，每帧只解码一次。
+ */
+class SequenceDecoder {
+private:
+    SequenceReader reader;
+    size_t numThreads;
+    TemporalDecoder temporalDecoder;
+    // 帧间解码器当前参考的帧号
+    std::optional<size_t> temporalFrame;
+
+    // 对数域量化坐标反量化后做逆变换，逆变换会改写包围盒，因此使用副本
+    std::vector<std::vector<float>> reconstructPositions(const std::vector<std::vector<uint16_t>>& quantized, const BoundingBox3D& bbox,
+                                                         int bitDepth) const {
+        auto positions = Quantization::dequantizePositionWithBBox<float, uint16_t>(quantized, bbox, bitDepth, numThreads);
+        auto inverseBBox = bbox;
+        Transform::inverseLogTransformInPlace(positions, inverseBBox, numThreads);
+        return positions;
+    }
+
+    // 负载为包围盒、几何、属性、旋转四个分段；码率控制模式的位深取自几何码流
+    DecodedFrame decodeSections(std::span<const uint8_t> payload, bool bitDepthFromGeometry) const {
+        const auto sections = SequenceContainer::unpackSections(payload);
+        if (sections.size() != 4) {
+            throw std::runtime_error("Corrupted frame payload: expected 4 sections");
+        }
+        const auto bbox = SequenceContainer::unpackBBox(sections[0]);
+        const int bitDepth = bitDepthFromGeometry ? OctreeCoder::getBitDepth(sections[1].data(), sections[1].size())
+                                                  : reader.getMetadata().positionBitDepth;
+        DecodedFrame frame;
+        frame.positions = reconstructPositions(OctreeCoder::decode<uint16_t>(sections[1].data(), sections[1].size()), bbox, bitDepth);
+        frame.attributes = AttributeCoder::decode(sections[2].data(), sections[2].size(), numThreads);
+        frame.rotations = QuaternionCoder::decode(sections[3].data(), sections[3].size(), numThreads);
+        return frame;
+    }
+
+    DecodedFrame decodeProgressive(std::span<const uint8_t> payload) const {
+        const auto sections = SequenceContainer::unpackSections(payload);
+        if (sections.size() != 2) {
+            throw std::runtime_error("Corrupted frame payload: expected 2 sections");
+        }
+        auto decoded = ProgressiveCoder::decode<uint16_t>(sections[1].data(), sections[1].size(), INT_MAX, numThreads);
+        DecodedFrame frame;
+        frame.positions = reconstructPositions(decoded.positions, SequenceContainer::unpackBBox(sections[0]), reader.getMetadata().positionBitDepth);
+        frame.attributes = std::move(decoded.attributes);
+        frame.rotations = std::move(decoded.rotations);
+        return frame;
+    }
+
+    DecodedFrame decodeTiled(std::span<const uint8_t> payload) const {
+        auto decoded = TileCoder::decode(payload.data(), payload.size(), numThreads);
+        return {std::move(decoded.positions), std::move(decoded.attributes), std::move(decoded.rotations)};
+    }
+
+    DecodedFrame decodeBlocked(std::span<const uint8_t> payload) const {
+        const auto sections = SequenceContainer::unpackSections(payload);
+        if (sections.size() != 3) {
+            throw std::runtime_error("Corrupted frame payload: expected 3 sections");
+        }
+        DecodedFrame frame;
+        frame.positions = BlockQuantizer::dequantize(BlockQuantizer::decode(sections[0].data(), sections[0].size(), numThreads), numThreads);
+        frame.attributes = AttributeCoder::decode(sections[1].data(), sections[1].size(), numThreads);
+        frame.rotations = QuaternionCoder::decode(sections[2].data(), sections[2].size(), numThreads);
+        return frame;
+    }
+
+    DecodedFrame decodeTemporal(size_t frameIndex) {
+        // 顺序播放时接着上一帧解码，否则从最近的关键帧开始；中途失败时丢弃解码状态
+        size_t first = reader.findKeyFrame(frameIndex);
+        if (temporalFrame && *temporalFrame >= first && *temporalFrame < frameIndex) {
+            first = *temporalFrame + 1;
+        }
+        temporalFrame.reset();
+        DecodedFrame frame;
+        for (size_t i = first; i <= frameIndex; ++i) {
+            const auto payload = getPayload(i);
+            frame = temporalDecoder.decodeFrame(payload.data(), payload.size());
+        }
+        temporalFrame = frameIndex;
+        return frame;
+    }
+
+    std::span<const uint8_t> getPayload(size_t frameIndex) const {
+        const auto payload = reader.getFrame(frameIndex);
+        if (payload.empty()) {
+            SPDLOG_ERROR("Frame {} is missing from the sequence", frameIndex);
+            throw std::runtime_error("Frame missing from sequence: " + std::to_string(frameIndex));
+        }
+        return payload;
+    }
+
+public:
+    /**
+     * @brief 打开序列文件
+     * @param numThreads 单帧内部使用的线程数，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果无法映射文件或文件损坏
+     */
+    explicit SequenceDecoder(const std::string& filePath, size_t numThreads = 1)
+        : reader(filePath), numThreads(numThreads), temporalDecoder(numThreads) {}
+
+    const SequenceReader& getReader() const {
+        return reader;
+    }
+
+    const SequenceMetadata& getMetadata() const {
+        return reader.getMetadata();
+    }
+
+    size_t getFrameCount() const {
+        return reader.getFrameCount();
+    }
+
+    /**
+     * @brief 解码第frameIndex帧，帧可以按任意顺序请求
+     * @return 与编码端重建结果一致的帧，列的含义见元数据中的属性名
+     * @throw std::out_of_range 如果帧号越界
+     * @throw std::runtime_error 如果帧缺失或负载损坏
+     */
+    DecodedFrame decodeFrame(size_t frameIndex) {
+        switch (reader.getMetadata().coding) {
+            case SequenceCoding::INTRA:
+            case SequenceCoding::SCENE:
+                return decodeSections(getPayload(frameIndex), false);
+            case SequenceCoding::RATE_CONTROLLED:
+                return decodeSections(getPayload(frameIndex), true);
+            case SequenceCoding::PROGRESSIVE:
+                return decodeProgressive(getPayload(frameIndex));
+            case SequenceCoding::TILED:
+                return decodeTiled(getPayload(frameIndex));
+            case SequenceCoding::BLOCKED:
+                return decodeBlocked(getPayload(frameIndex));
+            case SequenceCoding::TEMPORAL:
+                return decodeTemporal(frameIndex);
+        }
+        throw std::runtime_error("Unknown sequence coding");
+    }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "HilbertOrder.hpp"
+#include "MortonOrder.hpp"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 点的排列顺序，取值写入几何码流
+enum class SpaceFillingCurve : uint8_t {
+    MORTON = 0,
+    HILBERT = 1
+};
+
+// 八叉树按曲线顺序遍历子节点所需的状态表，莫顿序只有一个状态且次序即八分体编号
+struct CurveTraversal {
+    std::array<std::array<uint8_t, 8>, HilbertCurve::States> rank;
+    std::array<std::array<uint8_t, 8>, HilbertCurve::States> next;
+    // octant[state][rank]：rank的逆映射
+    std::array<std::array<uint8_t, 8>, HilbertCurve::States> octant;
+};
+
+// 莫顿序与希尔伯特序的统一入口
+class CurveOrder {
+private:
+    static constexpr CurveTraversal makeTraversal(SpaceFillingCurve curve) {
+        CurveTraversal traversal{};
+        for (size_t state = 0; state < HilbertCurve::States; ++state) {
+            for (uint8_t octant = 0; octant < 8; ++octant) {
+                const bool hilbert = curve == SpaceFillingCurve::HILBERT;
+                const uint8_t rank = hilbert ? HilbertCurve::Rank[state][octant] : octant;
+                traversal.rank[state][octant] = rank;
+                traversal.next[state][octant] = hilbert ? HilbertCurve::Next[state][octant] : 0;
+                traversal.octant[state][rank] = octant;
+            }
+        }
+        return traversal;
+    }
+
+public:
+    static const char* getName(SpaceFillingCurve curve) {
+        return curve == SpaceFillingCurve::HILBERT ? "hilbert" : "morton";
+    }
+
+    /**
+     * @brief 由名称解析曲线类型
+     * @throw std::runtime_error 如果名称不是morton或hilbert
+     */
+    static SpaceFillingCurve fromName(const std::string& name) {
+        if (name == "morton") return SpaceFillingCurve::MORTON;
+        if (name == "hilbert") return SpaceFillingCurve::HILBERT;
+        SPDLOG_ERROR("Unknown space filling curve: {}", name);
+        throw std::runtime_error("Unknown space filling curve: " + name);
+    }
+
+    static const CurveTraversal& getTraversal(SpaceFillingCurve curve) {
+        static constexpr CurveTraversal morton = makeTraversal(SpaceFillingCurve::MORTON);
+        static constexpr CurveTraversal hilbert = makeTraversal(SpaceFillingCurve::HILBERT);
+        return curve == SpaceFillingCurve::HILBERT ? hilbert : morton;
+    }
+
+    /**
+     * @brief 批量计算count个点的排序键
+     * @param bitDepth 每维位深，希尔伯特码依赖于它，莫顿码与之无关
+     */
+    template<typename CoordinateType>
+    static void encode3DKeys(SpaceFillingCurve curve, const CoordinateType* x, const CoordinateType* y, const CoordinateType* z, uint64_t* keys, size_t count, int bitDepth) {
+        if (curve == SpaceFillingCurve::HILBERT) {
+            HilbertEncoder::encode3DHilbertKeys(x, y, z, keys, count, bitDepth);
+        } else {
+            MortonEncoder::encode3DMortonKeys(x, y, z, keys, count);
+        }
+    }
+
+    // 按曲线排序的点索引，排序稳定
+    template<typename IndicesType = uint64_t, typename CoordinateType = uint32_t>
+    static std::vector<IndicesType> encode3DIndices(SpaceFillingCurve curve, const std::vector<std::vector<CoordinateType>>& coordinates, int bitDepth, size_t numThreads = 1) {
+        if (curve == SpaceFillingCurve::HILBERT) {
+            return HilbertEncoder::encode3DHilbertIndices<IndicesType>(coordinates, bitDepth, numThreads);
+        }
+        return MortonEncoder::encode3DMortonIndices<IndicesType>(coordinates, numThreads);
+    }
+};
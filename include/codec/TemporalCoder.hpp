@@ -0,0 +1,806 @@
+#pragma once
+
+#include "AttributeCoder.hpp"
+#include "OctreeCoder.hpp"
+#include "PositionPreprocessor.hpp"
+#include "Quantization.hpp"
+#include "QuaternionCoder.hpp"
+#include "RansCoder.hpp"
+#include "ResidualCoder.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "Transform.hpp"
+#include "utils/Parallel.hpp"
+#include "utils/RadixSort.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 帧间编码的帧类型，取值写入每帧码流的第一个字节
+enum class CodedFrameType : uint8_t {
+    // 关键帧：独立编码，并确定此后各帧共用的量化网格
+    KEY = 0,
+    // 预测帧：以上一帧的重建结果为参考，只编码匹配点的差值与增删列表
+    PREDICTED = 1
+};
+
+// 帧间编码的参数
+struct TemporalCodingSettings {
+    // 几何量化位深，不超过16
+    int positionBitDepth = 16;
+    SpaceFillingCurve curve = SpaceFillingCurve::MORTON;
+    // 各属性列的量化设置，未指定范围的列以关键帧的数据范围为准
+    std::vector<AttributeQuantization> attributes;
+    // 关键帧间隔，1表示每帧都是关键帧
+    size_t keyframeInterval = 30;
+    // 关键帧的包围盒与属性范围向两侧扩展的比例，使后续帧落在同一量化网格内；超出时提前插入关键帧
+    float gridMargin = 0.05f;
+    // 匹配时在参考帧曲线顺序上前后各检查的候选数
+    size_t searchWindow = 8;
+    // 匹配点之间允许的最大L1距离，单位为量化步长
+    uint32_t maxMatchDistance = 64;
+};
+
+// 量化网格上的一帧，点按曲线顺序排列，是编解码两端共享的帧间参考
+struct QuantizedFrame {
+    std::vector<std::vector<uint16_t>> positions;
+    // 各属性列的量化等级
+    std::vector<std::vector<uint16_t>> attributes;
+    // smallest-three打包后的旋转
+    std::vector<uint32_t> rotations;
+    // 与点一一对应的曲线排序键
+    std::vector<uint64_t> keys;
+
+    size_t size() const { return rotations.size(); }
+};
+
+// 一组关键帧与预测帧共用的量化网格，随关键帧写入码流
+struct QuantizationGrid {
+    int positionBitDepth = 16;
+    SpaceFillingCurve curve = SpaceFillingCurve::MORTON;
+    // 对数域的几何包围盒
+    BoundingBox3D bbox{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    // 各属性列的量化设置，范围均已确定
+    std::vector<AttributeQuantization> attributes;
+};
+
+// 解码得到的一帧，列的含义与编码输入一致
+struct DecodedFrame {
+    std::vector<std::vector<float>> positions;
+    std::vector<std::vector<float>> attributes;
+    std::vector<std::vector<float>> rotations;
+};
+
+/**
+ * @brief 帧间编码的公共部分：码流读写、帧间匹配与参考帧重建
+ *
+ * 关键帧码流：类型(uint8) + 网格 + 点数(uint32) + 分段{八叉树几何, 各属性列, 旋转}
+ * 预测帧码流：类型(uint8) + 参考点数、匹配点数、新增点数(各uint32) + 分段{保留标志, 3个坐标残差,
+ *   各属性列残差, 旋转下标残差, 3个旋转分量残差, [新增点的几何, 各属性列, 旋转]}
+ * 每个分段为字节数(uint32) + 数据。参考帧中未被匹配的点即被删除的点，由保留标志给出。
+ * 两端以相同方式由保留的参考点(按参考顺序)与新增点拼接出当前帧并按曲线稳定排序，得到下一帧的参考，因此参考帧无漂移。
+ */
+class TemporalCoder {
+private:
+    static constexpr uint32_t NoMatch = std::numeric_limits<uint32_t>::max();
+    // 旋转字中最大分量下标与三个分量的位置
+    static constexpr int RotationIndexShift = 30;
+    static constexpr int RotationComponentBits = 10;
+    static constexpr uint32_t RotationComponentMask = (1u << RotationComponentBits) - 1;
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& output, T value) {
+        const size_t offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    static void appendSection(std::vector<uint8_t>& output, const std::vector<uint8_t>& section) {
+        if (section.size() > UINT32_MAX) {
+            throw std::runtime_error("Temporal bitstream section too large");
+        }
+        append(output, static_cast<uint32_t>(section.size()));
+        output.insert(output.end(), section.begin(), section.end());
+    }
+
+    // 按顺序读取码流中的定长字段与分段
+    class Cursor {
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t offset = 0;
+
+    public:
+        Cursor(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+        template<typename T>
+        T read() {
+            if (offset + sizeof(T) > size) {
+                throw std::runtime_error("Truncated temporal bitstream");
+            }
+            T value;
+            std::memcpy(&value, data + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        std::pair<const uint8_t*, size_t> section() {
+            const size_t sectionSize = read<uint32_t>();
+            if (sectionSize > size - offset) {
+                SPDLOG_ERROR("Temporal bitstream section needs {} bytes, {} left", sectionSize, size - offset);
+                throw std::runtime_error("Truncated temporal bitstream");
+            }
+            const uint8_t* sectionData = data + offset;
+            offset += sectionSize;
+            return {sectionData, sectionSize};
+        }
+    };
+
+    // 并行生成各分段后按顺序写出
+    static void appendSections(std::vector<uint8_t>& output, const std::vector<std::function<std::vector<uint8_t>()>>& jobs, size_t numThreads) {
+        std::vector<std::vector<uint8_t>> sections(jobs.size());
+        Parallel::forRange(jobs.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                sections[i] = jobs[i]();
+            }
+        });
+        for (const auto& section : sections) {
+            appendSection(output, section);
+        }
+    }
+
+    static void runJobs(const std::vector<std::function<void()>>& jobs, size_t numThreads) {
+        Parallel::forRange(jobs.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                jobs[i]();
+            }
+        });
+    }
+
+    static void writeGrid(std::vector<uint8_t>& output, const QuantizationGrid& grid) {
+        append(output, static_cast<uint8_t>(grid.positionBitDepth));
+        append(output, static_cast<uint8_t>(grid.curve));
+        for (const float value : grid.bbox.data) {
+            append(output, value);
+        }
+        append(output, static_cast<uint8_t>(grid.attributes.size()));
+        for (const auto& attribute : grid.attributes) {
+            append(output, static_cast<uint8_t>(attribute.domain));
+            append(output, static_cast<uint8_t>(attribute.bitDepth));
+            append(output, (*attribute.range)[0]);
+            append(output, (*attribute.range)[1]);
+        }
+    }
+
+    static QuantizationGrid readGrid(Cursor& cursor) {
+        QuantizationGrid grid;
+        grid.positionBitDepth = cursor.read<uint8_t>();
+        const uint8_t curveId = cursor.read<uint8_t>();
+        if (grid.positionBitDepth < 1 || grid.positionBitDepth > 16 || curveId > static_cast<uint8_t>(SpaceFillingCurve::HILBERT)) {
+            throw std::runtime_error("Corrupted temporal bitstream: invalid grid");
+        }
+        grid.curve = static_cast<SpaceFillingCurve>(curveId);
+        for (float& value : grid.bbox.data) {
+            value = cursor.read<float>();
+        }
+        grid.attributes.resize(cursor.read<uint8_t>());
+        for (auto& attribute : grid.attributes) {
+            const uint8_t domain = cursor.read<uint8_t>();
+            attribute.bitDepth = cursor.read<uint8_t>();
+            if (domain > static_cast<uint8_t>(AttributeDomain::SIGMOID) || attribute.bitDepth < 1 || attribute.bitDepth > AttributeCoder::MaxBitDepth) {
+                throw std::runtime_error("Corrupted temporal bitstream: invalid attribute grid");
+            }
+            attribute.domain = static_cast<AttributeDomain>(domain);
+            const float minValue = cursor.read<float>();
+            const float maxValue = cursor.read<float>();
+            attribute.range = std::array<float, 2>{minValue, maxValue};
+        }
+        return grid;
+    }
+
+    static int getRotationIndex(uint32_t word) {
+        return static_cast<int>(word >> RotationIndexShift);
+    }
+
+    static int getRotationComponent(uint32_t word, int component) {
+        return static_cast<int>((word >> (RotationComponentBits * (2 - component))) & RotationComponentMask);
+    }
+
+    // 独立编码一组按曲线排序的点：几何、各属性列与旋转分段，关键帧与预测帧的新增点共用
+    static void encodeIntraSections(std::vector<uint8_t>& output, const QuantizationGrid& grid, const QuantizedFrame& frame, size_t numThreads) {
+        std::vector<std::function<std::vector<uint8_t>()>> jobs;
+        jobs.emplace_back([&]() { return OctreeCoder::encode(frame.positions, grid.positionBitDepth, grid.curve); });
+        for (size_t column = 0; column < frame.attributes.size(); ++column) {
+            jobs.emplace_back([&, column]() {
+                return ResidualCoder::encodeDelta(frame.attributes[column].data(), frame.size(), grid.attributes[column].bitDepth);
+            });
+        }
+        jobs.emplace_back([&]() {
+            std::vector<uint8_t> section(frame.size() * sizeof(uint32_t));
+            std::memcpy(section.data(), frame.rotations.data(), section.size());
+            return section;
+        });
+        appendSections(output, jobs, numThreads);
+    }
+
+    static QuantizedFrame decodeIntraSections(Cursor& cursor, const QuantizationGrid& grid, size_t count, size_t numThreads) {
+        QuantizedFrame frame;
+        const auto [geometryData, geometrySize] = cursor.section();
+        std::vector<std::pair<const uint8_t*, size_t>> attributeSections(grid.attributes.size());
+        for (auto& section : attributeSections) {
+            section = cursor.section();
+        }
+        const auto [rotationData, rotationSize] = cursor.section();
+        if (rotationSize != count * sizeof(uint32_t)) {
+            throw std::runtime_error("Corrupted temporal bitstream: rotation size mismatch");
+        }
+
+        frame.attributes.assign(grid.attributes.size(), std::vector<uint16_t>(count));
+        frame.rotations.resize(count);
+        std::memcpy(frame.rotations.data(), rotationData, rotationSize);
+        std::vector<std::function<void()>> jobs;
+        jobs.emplace_back([&, geometryData, geometrySize]() {
+            frame.positions = OctreeCoder::decode<uint16_t>(geometryData, geometrySize);
+        });
+        for (size_t column = 0; column < grid.attributes.size(); ++column) {
+            jobs.emplace_back([&, column]() {
+                ResidualCoder::decodeDelta(attributeSections[column].first, attributeSections[column].second,
+                                           frame.attributes[column].data(), count, grid.attributes[column].bitDepth);
+            });
+        }
+        runJobs(jobs, numThreads);
+        if (frame.positions[0].size() != count) {
+            throw std::runtime_error("Corrupted temporal bitstream: point count mismatch");
+        }
+        return frame;
+    }
+
+    static void resizeFrame(QuantizedFrame& frame, size_t attributeCount, size_t count) {
+        frame.positions.assign(3, std::vector<uint16_t>(count));
+        frame.attributes.assign(attributeCount, std::vector<uint16_t>(count));
+        frame.rotations.resize(count);
+    }
+
+    static void copyPoint(const QuantizedFrame& source, size_t sourceIndex, QuantizedFrame& target, size_t targetIndex) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            target.positions[axis][targetIndex] = source.positions[axis][sourceIndex];
+        }
+        for (size_t column = 0; column < source.attributes.size(); ++column) {
+            target.attributes[column][targetIndex] = source.attributes[column][sourceIndex];
+        }
+        target.rotations[targetIndex] = source.rotations[sourceIndex];
+    }
+
+    static void appendFrame(QuantizedFrame& target, size_t offset, const QuantizedFrame& source) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            std::copy(source.positions[axis].begin(), source.positions[axis].end(), target.positions[axis].begin() + offset);
+        }
+        for (size_t column = 0; column < source.attributes.size(); ++column) {
+            std::copy(source.attributes[column].begin(), source.attributes[column].end(), target.attributes[column].begin() + offset);
+        }
+        std::copy(source.rotations.begin(), source.rotations.end(), target.rotations.begin() + offset);
+    }
+
+public:
+    /**
+     * @brief 读取帧类型
+     * @throw std::runtime_error 如果码流为空或类型未知
+     */
+    static CodedFrameType getFrameType(const uint8_t* bitstream, size_t size) {
+        if (size == 0 || bitstream[0] > static_cast<uint8_t>(CodedFrameType::PREDICTED)) {
+            throw std::runtime_error("Invalid temporal frame type");
+        }
+        return static_cast<CodedFrameType>(bitstream[0]);
+    }
+
+    /**
+     * @brief 计算排序键并按曲线稳定排序，同时重排所有列
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
+    static void sortFrame(QuantizedFrame& frame, const QuantizationGrid& grid, size_t numThreads) {
+        const size_t count = frame.size();
+        frame.keys.resize(count);
+        CurveOrder::encode3DKeys(grid.curve, frame.positions[0].data(), frame.positions[1].data(), frame.positions[2].data(),
+                                 frame.keys.data(), count, grid.positionBitDepth);
+        std::vector<uint32_t> indices(count);
+        std::iota(indices.begin(), indices.end(), 0u);
+        RadixSort::sortPairs(frame.keys, indices, numThreads);
+        std::vector<std::vector<uint32_t>> rotationColumns(1);
+        rotationColumns[0] = std::move(frame.rotations);
+        Transform::reorderColumnsInPlace(indices, numThreads, frame.positions, frame.attributes, rotationColumns);
+        frame.rotations = std::move(rotationColumns[0]);
+    }
+
+    /**
+     * @brief 在量化网格上为当前帧的每个点寻找参考帧中的对应点
+     *
+     * 两帧均按曲线排序，当前帧的点依次在参考帧中二分定位到曲线上的位置，检查前后各searchWindow个未被占用的候选，
+     * 取L1距离最小者；距离超过maxMatchDistance时视为新增点。当前帧有序，定位点单调前进。
+     * @return 每个参考点匹配到的当前帧点下标，未匹配为UINT32_MAX
+     */
+    static std::vector<uint32_t> matchFrames(const QuantizedFrame& reference, const QuantizedFrame& current, size_t searchWindow, uint32_t maxMatchDistance) {
+        const size_t referenceCount = reference.size();
+        std::vector<uint32_t> matches(referenceCount, NoMatch);
+        size_t position = 0;
+        for (size_t i = 0; i < current.size(); ++i) {
+            const uint64_t key = current.keys[i];
+            position = static_cast<size_t>(std::lower_bound(reference.keys.begin() + static_cast<std::ptrdiff_t>(position), reference.keys.end(), key)
+                                           - reference.keys.begin());
+            const size_t begin = position > searchWindow ? position - searchWindow : 0;
+            const size_t end = std::min(referenceCount, position + searchWindow);
+            uint32_t bestDistance = maxMatchDistance + 1;
+            size_t best = referenceCount;
+            for (size_t j = begin; j < end; ++j) {
+                if (matches[j] != NoMatch) {
+                    continue;
+                }
+                uint32_t distance = 0;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    distance += static_cast<uint32_t>(std::abs(static_cast<int32_t>(current.positions[axis][i]) - static_cast<int32_t>(reference.positions[axis][j])));
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = j;
+                }
+            }
+            if (best < referenceCount) {
+                matches[best] = static_cast<uint32_t>(i);
+            }
+        }
+        return matches;
+    }
+
+    /**
+     * @brief 编码关键帧
+     * @param frame 已按grid.curve排序的量化帧
+     */
+    static std::vector<uint8_t> encodeKeyFrame(const QuantizationGrid& grid, const QuantizedFrame& frame, size_t numThreads) {
+        std::vector<uint8_t> output;
+        append(output, static_cast<uint8_t>(CodedFrameType::KEY));
+        writeGrid(output, grid);
+        append(output, static_cast<uint32_t>(frame.size()));
+        encodeIntraSections(output, grid, frame, numThreads);
+        return output;
+    }
+
+    /**
+     * @brief 编码预测帧，同时给出两端一致的重建结果作为下一帧的参考
+     * @param reference 上一帧的重建结果
+     * @param current 已按曲线排序的当前帧，keys有效
+     * @param reconstructed 输出当前帧的重建结果
+     */
+    static std::vector<uint8_t> encodePredictedFrame(const QuantizationGrid& grid, const QuantizedFrame& reference, const QuantizedFrame& current,
+                                                     const TemporalCodingSettings& settings, QuantizedFrame& reconstructed, size_t numThreads) {
+        const auto matches = matchFrames(reference, current, settings.searchWindow, settings.maxMatchDistance);
+        std::vector<uint8_t> kept(reference.size());
+        std::vector<uint8_t> inserted(current.size(), 1);
+        size_t matchedCount = 0;
+        for (size_t j = 0; j < reference.size(); ++j) {
+            kept[j] = matches[j] != NoMatch;
+            if (kept[j]) {
+                inserted[matches[j]] = 0;
+                ++matchedCount;
+            }
+        }
+        const size_t insertedCount = current.size() - matchedCount;
+
+        // 按参考顺序排列的匹配点与按曲线顺序排列的新增点
+        QuantizedFrame matchedFrame;
+        QuantizedFrame insertedFrame;
+        resizeFrame(matchedFrame, current.attributes.size(), matchedCount);
+        resizeFrame(insertedFrame, current.attributes.size(), insertedCount);
+        std::vector<uint32_t> matchedReference(matchedCount);
+        for (size_t j = 0, k = 0; j < reference.size(); ++j) {
+            if (kept[j]) {
+                matchedReference[k] = static_cast<uint32_t>(j);
+                copyPoint(current, matches[j], matchedFrame, k++);
+            }
+        }
+        for (size_t i = 0, k = 0; i < current.size(); ++i) {
+            if (inserted[i]) {
+                copyPoint(current, i, insertedFrame, k++);
+            }
+        }
+
+        std::vector<uint8_t> output;
+        append(output, static_cast<uint8_t>(CodedFrameType::PREDICTED));
+        append(output, static_cast<uint32_t>(reference.size()));
+        append(output, static_cast<uint32_t>(matchedCount));
+        append(output, static_cast<uint32_t>(insertedCount));
+
+        // 残差均为当前值减参考值
+        auto columnResiduals = [&](const std::vector<uint16_t>& currentColumn, const std::vector<uint16_t>& referenceColumn, int bitDepth) {
+            std::vector<int32_t> residuals(matchedCount);
+            for (size_t k = 0; k < matchedCount; ++k) {
+                residuals[k] = static_cast<int32_t>(currentColumn[k]) - static_cast<int32_t>(referenceColumn[matchedReference[k]]);
+            }
+            return ResidualCoder::encode(residuals.data(), matchedCount, bitDepth);
+        };
+        std::vector<std::function<std::vector<uint8_t>()>> jobs;
+        jobs.emplace_back([&]() { return RansCoder::encode(kept.data(), kept.size(), 2); });
+        for (size_t axis = 0; axis < 3; ++axis) {
+            jobs.emplace_back([&, axis]() { return columnResiduals(matchedFrame.positions[axis], reference.positions[axis], grid.positionBitDepth); });
+        }
+        for (size_t column = 0; column < current.attributes.size(); ++column) {
+            jobs.emplace_back([&, column]() {
+                return columnResiduals(matchedFrame.attributes[column], reference.attributes[column], grid.attributes[column].bitDepth);
+            });
+        }
+        jobs.emplace_back([&]() {
+            std::vector<int32_t> residuals(matchedCount);
+            for (size_t k = 0; k < matchedCount; ++k) {
+                residuals[k] = getRotationIndex(matchedFrame.rotations[k]) - getRotationIndex(reference.rotations[matchedReference[k]]);
+            }
+            return ResidualCoder::encode(residuals.data(), matchedCount, 2);
+        });
+        for (int component = 0; component < 3; ++component) {
+            jobs.emplace_back([&, component]() {
+                std::vector<int32_t> residuals(matchedCount);
+                for (size_t k = 0; k < matchedCount; ++k) {
+                    residuals[k] = getRotationComponent(matchedFrame.rotations[k], component)
+                                 - getRotationComponent(reference.rotations[matchedReference[k]], component);
+                }
+                return ResidualCoder::encode(residuals.data(), matchedCount, RotationComponentBits);
+            });
+        }
+        appendSections(output, jobs, numThreads);
+        if (insertedCount > 0) {
+            encodeIntraSections(output, grid, insertedFrame, numThreads);
+        }
+
+        reconstructed = assemble(grid, matchedFrame, insertedFrame, numThreads);
+        return output;
+    }
+
+    // 保留点在前、新增点在后拼接并按曲线稳定排序，两端以此得到相同的参考帧
+    static QuantizedFrame assemble(const QuantizationGrid& grid, const QuantizedFrame& matchedFrame, const QuantizedFrame& insertedFrame, size_t numThreads) {
+        QuantizedFrame frame;
+        resizeFrame(frame, grid.attributes.size(), matchedFrame.size() + insertedFrame.size());
+        appendFrame(frame, 0, matchedFrame);
+        appendFrame(frame, matchedFrame.size(), insertedFrame);
+        sortFrame(frame, grid, numThreads);
+        return frame;
+    }
+
+    /**
+     * @brief 解码关键帧
+     * @param grid 输出码流中的量化网格
+     * @throw std::runtime_error 如果码流损坏
+     */
+    static QuantizedFrame decodeKeyFrame(const uint8_t* bitstream, size_t size, QuantizationGrid& grid, size_t numThreads) {
+        Cursor cursor(bitstream, size);
+        if (static_cast<CodedFrameType>(cursor.read<uint8_t>()) != CodedFrameType::KEY) {
+            throw std::runtime_error("Not a key frame");
+        }
+        grid = readGrid(cursor);
+        const size_t count = cursor.read<uint32_t>();
+        return decodeIntraSections(cursor, grid, count, numThreads);
+    }
+
+    /**
+     * @brief 解码预测帧
+     * @param reference 上一帧的重建结果
+     * @return 当前帧的重建结果，按曲线排序
+     * @throw std::runtime_error 如果码流损坏或与参考帧不符
+     */
+    static QuantizedFrame decodePredictedFrame(const uint8_t* bitstream, size_t size, const QuantizationGrid& grid, const QuantizedFrame& reference, size_t numThreads) {
+        Cursor cursor(bitstream, size);
+        if (static_cast<CodedFrameType>(cursor.read<uint8_t>()) != CodedFrameType::PREDICTED) {
+            throw std::runtime_error("Not a predicted frame");
+        }
+        const size_t referenceCount = cursor.read<uint32_t>();
+        const size_t matchedCount = cursor.read<uint32_t>();
+        const size_t insertedCount = cursor.read<uint32_t>();
+        if (referenceCount != reference.size() || matchedCount > referenceCount) {
+            SPDLOG_ERROR("Predicted frame expects {} reference points, decoder holds {}", referenceCount, reference.size());
+            throw std::runtime_error("Predicted frame does not match the reference frame");
+        }
+
+        std::vector<uint8_t> kept(referenceCount);
+        const auto [keptData, keptSize] = cursor.section();
+        RansCoder::decode(keptData, keptSize, kept.data(), referenceCount);
+        std::vector<uint32_t> matchedReference;
+        matchedReference.reserve(matchedCount);
+        for (size_t j = 0; j < referenceCount; ++j) {
+            if (kept[j] > 1) {
+                throw std::runtime_error("Corrupted temporal bitstream: invalid keep flag");
+            }
+            if (kept[j]) {
+                matchedReference.push_back(static_cast<uint32_t>(j));
+            }
+        }
+        if (matchedReference.size() != matchedCount) {
+            throw std::runtime_error("Corrupted temporal bitstream: matched count mismatch");
+        }
+
+        const size_t attributeCount = grid.attributes.size();
+        std::vector<std::pair<const uint8_t*, size_t>> sections(3 + attributeCount + 4);
+        for (auto& section : sections) {
+            section = cursor.section();
+        }
+
+        QuantizedFrame matchedFrame;
+        resizeFrame(matchedFrame, attributeCount, matchedCount);
+        auto applyResiduals = [&](size_t sectionIndex, const std::vector<uint16_t>& referenceColumn, std::vector<uint16_t>& column, int bitDepth) {
+            std::vector<int32_t> residuals(matchedCount);
+            ResidualCoder::decode(sections[sectionIndex].first, sections[sectionIndex].second, residuals.data(), matchedCount, bitDepth);
+            for (size_t k = 0; k < matchedCount; ++k) {
+                column[k] = static_cast<uint16_t>(static_cast<int32_t>(referenceColumn[matchedReference[k]]) + residuals[k]);
+            }
+        };
+        std::vector<std::function<void()>> jobs;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            jobs.emplace_back([&, axis]() { applyResiduals(axis, reference.positions[axis], matchedFrame.positions[axis], grid.positionBitDepth); });
+        }
+        for (size_t column = 0; column < attributeCount; ++column) {
+            jobs.emplace_back([&, column]() {
+                applyResiduals(3 + column, reference.attributes[column], matchedFrame.attributes[column], grid.attributes[column].bitDepth);
+            });
+        }
+        jobs.emplace_back([&]() {
+            std::array<std::vector<int32_t>, 4> residuals;
+            const size_t first = 3 + attributeCount;
+            for (size_t part = 0; part < 4; ++part) {
+                residuals[part].resize(matchedCount);
+                ResidualCoder::decode(sections[first + part].first, sections[first + part].second, residuals[part].data(), matchedCount,
+                                      part == 0 ? 2 : RotationComponentBits);
+            }
+            for (size_t k = 0; k < matchedCount; ++k) {
+                const uint32_t referenceWord = reference.rotations[matchedReference[k]];
+                uint32_t word = static_cast<uint32_t>(getRotationIndex(referenceWord) + residuals[0][k]) << RotationIndexShift;
+                for (int component = 0; component < 3; ++component) {
+                    const uint32_t value = static_cast<uint32_t>(getRotationComponent(referenceWord, component) + residuals[1 + component][k]);
+                    word |= (value & RotationComponentMask) << (RotationComponentBits * (2 - component));
+                }
+                matchedFrame.rotations[k] = word;
+            }
+        });
+        runJobs(jobs, numThreads);
+
+        QuantizedFrame insertedFrame;
+        if (insertedCount > 0) {
+            insertedFrame = decodeIntraSections(cursor, grid, insertedCount, numThreads);
+        } else {
+            resizeFrame(insertedFrame, attributeCount, 0);
+        }
+        return assemble(grid, matchedFrame, insertedFrame, numThreads);
+    }
+
+    /**
+     * @brief 将量化帧反量化为浮点列
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
+    static DecodedFrame dequantizeFrame(const QuantizationGrid& grid, const QuantizedFrame& frame, size_t numThreads) {
+        DecodedFrame decoded;
+        auto bbox = grid.bbox;
+        decoded.positions = Quantization::dequantizePositionWithBBox<float, uint16_t>(frame.positions, bbox, grid.positionBitDepth, numThreads);
+        Transform::inverseLogTransformInPlace(decoded.positions, bbox, numThreads);
+
+        decoded.attributes.resize(frame.attributes.size());
+        Parallel::forRange(frame.attributes.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                const auto& settings = grid.attributes[column];
+                decoded.attributes[column] = AttributeCoder::dequantize(frame.attributes[column], settings.domain, settings.bitDepth, *settings.range);
+            }
+        });
+
+        decoded.rotations.assign(4, std::vector<float>(frame.size()));
+        Parallel::forRange(frame.size(), numThreads, [&](size_t begin, size_t end) {
+            float* dst[4] = {decoded.rotations[0].data() + begin, decoded.rotations[1].data() + begin,
+                             decoded.rotations[2].data() + begin, decoded.rotations[3].data() + begin};
+            QuaternionCoder::unpackBlock(frame.rotations.data() + begin, dst, end - begin);
+        }, 1 << 14);
+        return decoded;
+    }
+};
+
+/**
+ * @brief 有状态的帧间编码器，各帧须按顺序调用encodeFrame
+ *
+ * 每隔keyframeInterval帧插入关键帧，关键帧的对数域包围盒与属性范围按gridMargin扩展后作为此后各帧的量化网格，
+ * 使相邻帧的量化坐标可直接相减。某帧超出网格时提前插入关键帧并重建网格。
+ */
+class TemporalEncoder {
+private:
+    TemporalCodingSettings settings;
+    size_t numThreads;
+    std::optional<QuantizationGrid> grid;
+    QuantizedFrame reference;
+    size_t framesSinceKey = 0;
+
+    static std::array<float, 2> expandRange(std::array<float, 2> range, float margin) {
+        const float padding = (range[1] - range[0]) * margin;
+        return {range[0] - padding, range[1] + padding};
+    }
+
+    static bool containsRange(const std::array<float, 2>& outer, const std::array<float, 2>& inner) {
+        return inner[0] >= outer[0] && inner[1] <= outer[1];
+    }
+
+    QuantizationGrid makeGrid(const BoundingBox3D& bbox, const std::vector<std::array<float, 2>>& ranges) const {
+        QuantizationGrid newGrid;
+        newGrid.positionBitDepth = settings.positionBitDepth;
+        newGrid.curve = settings.curve;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const auto range = expandRange({bbox.data[axis], bbox.data[axis + 3]}, settings.gridMargin);
+            newGrid.bbox.data[axis] = range[0];
+            newGrid.bbox.data[axis + 3] = range[1];
+        }
+        newGrid.attributes = settings.attributes;
+        for (size_t column = 0; column < ranges.size(); ++column) {
+            if (!newGrid.attributes[column].range) {
+                newGrid.attributes[column].range = expandRange(ranges[column], settings.gridMargin);
+            }
+        }
+        return newGrid;
+    }
+
+    // 当前帧是否完全落在已有网格内，指定了固定范围的属性按截断处理，不影响判断
+    bool fitsGrid(const BoundingBox3D& bbox, const std::vector<std::array<float, 2>>& ranges) const {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            if (!containsRange({grid->bbox.data[axis], grid->bbox.data[axis + 3]}, {bbox.data[axis], bbox.data[axis + 3]})) {
+                return false;
+            }
+        }
+        for (size_t column = 0; column < ranges.size(); ++column) {
+            if (!settings.attributes[column].range && !containsRange(*grid->attributes[column].range, ranges[column])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    QuantizedFrame quantizeFrame(const QuantizationGrid& frameGrid, const std::vector<std::vector<float>>& positions,
+                                 const std::vector<std::vector<float>>& attributes, const std::vector<std::vector<float>>& rotations) const {
+        auto preprocessed = PositionPreprocessor::process<uint16_t>(positions, frameGrid.bbox, frameGrid.positionBitDepth, numThreads, frameGrid.curve);
+        QuantizedFrame frame;
+        frame.positions = std::move(preprocessed.quantizedPositions);
+        frame.keys = std::move(preprocessed.curveKeys);
+
+        frame.attributes.resize(attributes.size());
+        Parallel::forRange(attributes.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                const auto& quantization = frameGrid.attributes[column];
+                frame.attributes[column] = AttributeCoder::quantize(attributes[column], quantization.domain, quantization.bitDepth, *quantization.range);
+            }
+        });
+
+        const size_t count = positions[0].size();
+        frame.rotations.resize(count);
+        Parallel::forRange(count, numThreads, [&](size_t begin, size_t end) {
+            const float* src[4] = {rotations[0].data() + begin, rotations[1].data() + begin, rotations[2].data() + begin, rotations[3].data() + begin};
+            QuaternionCoder::packBlock(src, frame.rotations.data() + begin, end - begin);
+        }, 1 << 14);
+
+        RadixSort::sortPairs(frame.keys, preprocessed.indices, numThreads);
+        std::vector<std::vector<uint32_t>> rotationColumns(1);
+        rotationColumns[0] = std::move(frame.rotations);
+        Transform::reorderColumnsInPlace(preprocessed.indices, numThreads, frame.positions, frame.attributes, rotationColumns);
+        frame.rotations = std::move(rotationColumns[0]);
+        return frame;
+    }
+
+public:
+    /**
+     * @param settings 帧间编码参数
+     * @param numThreads 单帧内部使用的线程数，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果几何位深超过16或关键帧间隔为0
+     */
+    explicit TemporalEncoder(TemporalCodingSettings settings, size_t numThreads = 1)
+        : settings(std::move(settings)), numThreads(numThreads) {
+        if (this->settings.positionBitDepth < 1 || this->settings.positionBitDepth > 16) {
+            SPDLOG_ERROR("Temporal coding supports position bit depths in [1, 16], got {}", this->settings.positionBitDepth);
+            throw std::runtime_error("Invalid temporal position bit depth");
+        }
+        if (this->settings.keyframeInterval == 0) {
+            throw std::runtime_error("Keyframe interval must be positive");
+        }
+    }
+
+    /**
+     * @brief 编码下一帧
+     * @param positions 3列原始坐标
+     * @param attributes 与settings.attributes一一对应的属性列
+     * @param rotations 4列旋转四元数分量
+     * @return 该帧的码流，首字节为帧类型
+     * @throw std::runtime_error 如果列数或列长度不匹配；失败时编码器状态不变
+     */
+    std::vector<uint8_t> encodeFrame(const std::vector<std::vector<float>>& positions, const std::vector<std::vector<float>>& attributes,
+                                     const std::vector<std::vector<float>>& rotations) {
+        if (attributes.size() != settings.attributes.size() || attributes.size() > UINT8_MAX || rotations.size() != 4) {
+            SPDLOG_ERROR("Temporal encoder expects {} attribute and 4 rotation columns, got {} and {}", settings.attributes.size(), attributes.size(), rotations.size());
+            throw std::runtime_error("Temporal encoder column count mismatch");
+        }
+        const size_t count = positions.empty() ? 0 : positions[0].size();
+        for (const auto* columns : {&attributes, &rotations}) {
+            for (const auto& column : *columns) {
+                if (column.size() != count) {
+                    throw std::runtime_error("Temporal encoder columns must have equal length");
+                }
+            }
+        }
+        if (count > UINT32_MAX) {
+            throw std::runtime_error("Too many points for temporal coding");
+        }
+
+        const auto bbox = PositionPreprocessor::computeBBox(positions, numThreads);
+        std::vector<std::array<float, 2>> ranges(attributes.size());
+        Parallel::forRange(attributes.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t column = begin; column < end; ++column) {
+                ranges[column] = AttributeCoder::computeRange(attributes[column], settings.attributes[column].domain);
+            }
+        });
+
+        const bool keyFrame = !grid || framesSinceKey + 1 >= settings.keyframeInterval || !fitsGrid(bbox, ranges);
+        const QuantizationGrid frameGrid = keyFrame ? makeGrid(bbox, ranges) : *grid;
+        auto current = quantizeFrame(frameGrid, positions, attributes, rotations);
+
+        std::vector<uint8_t> bitstream;
+        if (keyFrame) {
+            bitstream = TemporalCoder::encodeKeyFrame(frameGrid, current, numThreads);
+            reference = std::move(current);
+            framesSinceKey = 0;
+        } else {
+            QuantizedFrame reconstructed;
+            bitstream = TemporalCoder::encodePredictedFrame(frameGrid, reference, current, settings, reconstructed, numThreads);
+            reference = std::move(reconstructed);
+            ++framesSinceKey;
+        }
+        grid = frameGrid;
+        return bitstream;
+    }
+
+    // 下一帧强制编码为关键帧并重建网格。encodeFrame返回的码流没有送达解码端时调用，后续帧不再以它为参考
+    void forceKeyFrame() {
+        grid.reset();
+    }
+};
+
+// 有状态的帧间解码器，各帧须按编码顺序调用decodeFrame
+class TemporalDecoder {
+private:
+    size_t numThreads;
+    std::optional<QuantizationGrid> grid;
+    QuantizedFrame reference;
+
+public:
+    // numThreads：单帧内部使用的线程数，0表示使用全部硬件线程
+    explicit TemporalDecoder(size_t numThreads = 1) : numThreads(numThreads) {}
+
+    /**
+     * @brief 解码下一帧
+     * @return 按曲线顺序排列的重建帧
+     * @throw std::runtime_error 如果码流损坏或在关键帧之前收到预测帧；失败时解码器状态不变
+     */
+    DecodedFrame decodeFrame(const uint8_t* bitstream, size_t size) {
+        if (TemporalCoder::getFrameType(bitstream, size) == CodedFrameType::KEY) {
+            QuantizationGrid frameGrid;
+            auto frame = TemporalCoder::decodeKeyFrame(bitstream, size, frameGrid, numThreads);
+            auto decoded = TemporalCoder::dequantizeFrame(frameGrid, frame, numThreads);
+            grid = std::move(frameGrid);
+            reference = std::move(frame);
+            return decoded;
+        }
+        if (!grid) {
+            throw std::runtime_error("Predicted frame received before any key frame");
+        }
+        auto frame = TemporalCoder::decodePredictedFrame(bitstream, size, *grid, reference, numThreads);
+        auto decoded = TemporalCoder::dequantizeFrame(*grid, frame, numThreads);
+        reference = std::move(frame);
+        return decoded;
+    }
+
+    DecodedFrame decodeFrame(const std::vector<uint8_t>& bitstream) {
+        return decodeFrame(bitstream.data(), bitstream.size());
+    }
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "AttributeCoder.hpp"
+#include "OctreeCoder.hpp"
+#include "PositionPreprocessor.hpp"
+#include "QuaternionCoder.hpp"
+#include "Quantization.hpp"
+#include "SpaceFillingCurve.hpp"
+#include "Transform.hpp"
+#include "utils/Parallel.hpp"
+#include "utils/RadixSort.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 分块编码的参数
+struct TileCodingSettings {
+    int positionBitDepth = 16;
+    SpaceFillingCurve curve = SpaceFillingCurve::MORTON;
+    // 与属性列一一对应；未指定范围的列在每块内使用块的数据范围
+    std::vector<AttributeQuantization> attributes;
+    // 块数，点数少于块数时每块一个点
+    size_t tileCount = 8;
+};
+
+// 分块解码的结果，各块依次排列，块内按块的曲线顺序排列
+struct TiledFrame {
+    std::vector<std::vector<float>> positions;
+    std::vector<std::vector<float>> attributes;
+    std::vector<std::vector<float>> rotations;
+};
+
+/**
+ * @brief 空间分块编码：按整帧的曲线顺序把点切成点数相近的连续区间，每块是空间上紧凑的一团点，
+ * 各自求对数域包围盒、量化、排序并独立编码几何、属性和旋转，块之间没有依赖，编码和解码都按块并行
+ *
+ * 码流：点数(uint32) + 位深(uint8) + 曲线(uint8) + 属性列数(uint8) + 块数(uint32) + 块表 + 各块数据
+ * 块表每项：字节数(uint32) + 点数(uint32) + 对数域包围盒(6 x float)
+ * 块数据：几何、属性、旋转三个分段，每个分段为字节数(uint32) + 数据
+ */
+class TileCoder {
+private:
+    static constexpr size_t TileEntrySize = 32;
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& output, T value) {
+        const size_t offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static T read(const uint8_t* data, size_t size, size_t& offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::runtime_error("Truncated tiled bitstream");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    static void appendSection(std::vector<uint8_t>& output, const std::vector<uint8_t>& section) {
+        append(output, static_cast<uint32_t>(section.size()));
+        output.insert(output.end(), section.begin(), section.end());
+    }
+
+    static std::pair<const uint8_t*, size_t> readSection(const uint8_t* data, size_t size, size_t& offset) {
+        const size_t sectionSize = read<uint32_t>(data, size, offset);
+        if (sectionSize > size - offset) {
+            throw std::runtime_error("Truncated tiled bitstream");
+        }
+        const uint8_t* sectionData = data + offset;
+        offset += sectionSize;
+        return {sectionData, sectionSize};
+    }
+
+    // 块表中的一项，offset为块数据在码流中的位置
+    struct TileEntry {
+        size_t offset;
+        size_t size;
+        size_t pointCount;
+        BoundingBox3D bbox;
+    };
+
+    struct Header {
+        size_t pointCount;
+        int bitDepth;
+        SpaceFillingCurve curve;
+        size_t attributeCount;
+        std::vector<TileEntry> tiles;
+    };
+
+    static Header readHeader(const uint8_t* data, size_t size) {
+        size_t offset = 0;
+        Header header;
+        header.pointCount = read<uint32_t>(data, size, offset);
+        header.bitDepth = read<uint8_t>(data, size, offset);
+        const uint8_t curve = read<uint8_t>(data, size, offset);
+        if (header.bitDepth < 1 || header.bitDepth > 16 || curve > static_cast<uint8_t>(SpaceFillingCurve::HILBERT)) {
+            throw std::runtime_error("Corrupted tiled bitstream: invalid header");
+        }
+        header.curve = static_cast<SpaceFillingCurve>(curve);
+        header.attributeCount = read<uint8_t>(data, size, offset);
+        const size_t tileCount = read<uint32_t>(data, size, offset);
+        if (tileCount > (size - offset) / TileEntrySize) {
+            throw std::runtime_error("Truncated tiled bitstream");
+        }
+
+        size_t tileOffset = offset + tileCount * TileEntrySize;
+        size_t pointTotal = 0;
+        header.tiles.reserve(tileCount);
+        for (size_t tile = 0; tile < tileCount; ++tile) {
+            const size_t tileSize = read<uint32_t>(data, size, offset);
+            const size_t pointCount = read<uint32_t>(data, size, offset);
+            BoundingBox3D bbox{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+            for (float& value : bbox.data) {
+                value = read<float>(data, size, offset);
+            }
+            if (tileSize > size - tileOffset) {
+                throw std::runtime_error("Truncated tiled bitstream");
+            }
+            header.tiles.push_back({tileOffset, tileSize, pointCount, bbox});
+            tileOffset += tileSize;
+            pointTotal += pointCount;
+        }
+        if (pointTotal != header.pointCount) {
+            throw std::runtime_error("Corrupted tiled bitstream: point count mismatch");
+        }
+        return header;
+    }
+
+    // 独立编码一块：在块自己的包围盒上量化并按曲线重排
+    static std::vector<uint8_t> encodeTile(std::vector<std::vector<float>>& positions, std::vector<std::vector<float>>& attributes,
+                                           std::vector<std::vector<float>>& rotations, const TileCodingSettings& settings,
+                                           BoundingBox3D& bbox, size_t numThreads) {
+        auto preprocessed = PositionPreprocessor::process<uint16_t>(positions, settings.positionBitDepth, numThreads, settings.curve);
+        bbox = preprocessed.bbox;
+        RadixSort::sortPairs(preprocessed.curveKeys, preprocessed.indices, numThreads);
+        Transform::reorderColumnsInPlace(preprocessed.indices, numThreads, preprocessed.quantizedPositions, attributes, rotations);
+
+        std::vector<uint8_t> tile;
+        appendSection(tile, OctreeCoder::encode(preprocessed.quantizedPositions, settings.positionBitDepth, settings.curve));
+        appendSection(tile, AttributeCoder::encode(attributes, settings.attributes, numThreads));
+        appendSection(tile, QuaternionCoder::encode(rotations, numThreads));
+        return tile;
+    }
+
+    template<typename T>
+    static std::vector<std::vector<T>> gatherRange(const std::vector<std::vector<T>>& columns, const std::vector<uint32_t>& indices, size_t begin, size_t end) {
+        std::vector<std::vector<T>> gathered(columns.size(), std::vector<T>(end - begin));
+        for (size_t column = 0; column < columns.size(); ++column) {
+            for (size_t i = begin; i < end; ++i) {
+                gathered[column][i - begin] = columns[column][indices[i]];
+            }
+        }
+        return gathered;
+    }
+
+    static TiledFrame allocateFrame(size_t pointCount, size_t attributeCount) {
+        TiledFrame frame;
+        frame.positions.assign(3, std::vector<float>(pointCount));
+        frame.attributes.assign(attributeCount, std::vector<float>(pointCount));
+        frame.rotations.assign(4, std::vector<float>(pointCount));
+        return frame;
+    }
+
+    static void decodeTileInto(const uint8_t* data, const TileEntry& entry, int bitDepth, size_t first, TiledFrame& frame, size_t numThreads) {
+        size_t offset = 0;
+        const uint8_t* tile = data + entry.offset;
+        const auto [geometry, geometrySize] = readSection(tile, entry.size, offset);
+        const auto [attributes, attributesSize] = readSection(tile, entry.size, offset);
+        const auto [rotations, rotationsSize] = readSection(tile, entry.size, offset);
+
+        const auto quantized = OctreeCoder::decode<uint16_t>(geometry, geometrySize);
+        auto bbox = entry.bbox;
+        auto positions = Quantization::dequantizePositionWithBBox<float, uint16_t>(quantized, bbox, bitDepth, numThreads);
+        Transform::inverseLogTransformInPlace(positions, bbox, numThreads);
+        auto attributeColumns = AttributeCoder::decode(attributes, attributesSize, numThreads);
+        auto rotationColumns = QuaternionCoder::decode(rotations, rotationsSize, numThreads);
+        if (positions[0].size() != entry.pointCount || (!attributeColumns.empty() && attributeColumns[0].size() != entry.pointCount)
+            || attributeColumns.size() != frame.attributes.size() || rotationColumns[0].size() != entry.pointCount) {
+            throw std::runtime_error("Corrupted tiled bitstream: tile size mismatch");
+        }
+
+        auto place = [first](std::vector<std::vector<float>>& output, const std::vector<std::vector<float>>& columns) {
+            for (size_t column = 0; column < columns.size(); ++column) {
+                std::copy(columns[column].begin(), columns[column].end(), output[column].begin() + first);
+            }
+        };
+        place(frame.positions, positions);
+        place(frame.attributes, attributeColumns);
+        place(frame.rotations, rotationColumns);
+    }
+
+public:
+    /**
+     * @brief 分块编码一帧
+     * @param positions 3列原始坐标，点的顺序任意
+     * @param attributes 与settings.attributes一一对应的属性列
+     * @param rotations 4列旋转分量
+     * @param numThreads 线程数，各块并行编码，块数少于线程数时块内也并行，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果列数或长度不匹配、位深无效
+     */
+    static std::vector<uint8_t> encode(const std::vector<std::vector<float>>& positions, const std::vector<std::vector<float>>& attributes,
+                                       const std::vector<std::vector<float>>& rotations, const TileCodingSettings& settings, size_t numThreads = 1) {
+        if (positions.size() != 3 || rotations.size() != 4 || attributes.size() != settings.attributes.size() || attributes.size() > UINT8_MAX) {
+            throw std::runtime_error("Tiled coding requires 3 position, matching attribute and 4 rotation columns");
+        }
+        const size_t count = positions[0].size();
+        const auto checkLength = [count](const auto& columns) {
+            for (const auto& column : columns) {
+                if (column.size() != count) {
+                    throw std::runtime_error("Tiled coding requires columns of equal length");
+                }
+            }
+        };
+        checkLength(positions);
+        checkLength(attributes);
+        checkLength(rotations);
+        if (settings.positionBitDepth < 1 || settings.positionBitDepth > 16) {
+            SPDLOG_ERROR("Invalid tiled position bit depth: {}", settings.positionBitDepth);
+            throw std::runtime_error("Invalid tiled position bit depth: " + std::to_string(settings.positionBitDepth));
+        }
+        if (settings.tileCount == 0 || count > UINT32_MAX) {
+            throw std::runtime_error("Tiled coding requires at least one tile and fewer than 2^32 points");
+        }
+
+        // 整帧的曲线顺序只用于划分，块内在块自己的网格上重新排序
+        std::vector<uint32_t> order;
+        if (count > 0) {
+            auto preprocessed = PositionPreprocessor::process<uint16_t>(positions, settings.positionBitDepth, numThreads, settings.curve);
+            RadixSort::sortPairs(preprocessed.curveKeys, preprocessed.indices, numThreads);
+            order = std::move(preprocessed.indices);
+        }
+
+        const size_t tileCount = std::min(settings.tileCount, count);
+        const size_t threads = Parallel::resolveThreadCount(numThreads);
+        const size_t threadsPerTile = std::max<size_t>(1, threads / std::max<size_t>(1, tileCount));
+        std::vector<std::vector<uint8_t>> tiles(tileCount);
+        std::vector<BoundingBox3D> bboxes(tileCount, BoundingBox3D{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f});
+        Parallel::forRange(tileCount, threads, [&](size_t begin, size_t end) {
+            for (size_t tile = begin; tile < end; ++tile) {
+                const size_t first = count * tile / tileCount;
+                const size_t last = count * (tile + 1) / tileCount;
+                auto tilePositions = gatherRange(positions, order, first, last);
+                auto tileAttributes = gatherRange(attributes, order, first, last);
+                auto tileRotations = gatherRange(rotations, order, first, last);
+                tiles[tile] = encodeTile(tilePositions, tileAttributes, tileRotations, settings, bboxes[tile], threadsPerTile);
+            }
+        });
+
+        std::vector<uint8_t> bitstream;
+        append(bitstream, static_cast<uint32_t>(count));
+        append(bitstream, static_cast<uint8_t>(settings.positionBitDepth));
+        append(bitstream, static_cast<uint8_t>(settings.curve));
+        append(bitstream, static_cast<uint8_t>(attributes.size()));
+        append(bitstream, static_cast<uint32_t>(tileCount));
+        for (size_t tile = 0; tile < tileCount; ++tile) {
+            if (tiles[tile].size() > UINT32_MAX) {
+                throw std::runtime_error("Tile too large");
+            }
+            append(bitstream, static_cast<uint32_t>(tiles[tile].size()));
+            append(bitstream, static_cast<uint32_t>(count * (tile + 1) / tileCount - count * tile / tileCount));
+            for (const float value : bboxes[tile].data) {
+                append(bitstream, value);
+            }
+        }
+        for (const auto& tile : tiles) {
+            bitstream.insert(bitstream.end(), tile.begin(), tile.end());
+        }
+        return bitstream;
+    }
+
+    /**
+     * @brief 码流中的块数
+     * @throw std::runtime_error 如果码流头或块表损坏
+     */
+    static size_t getTileCount(const uint8_t* bitstream, size_t size) {
+        return readHeader(bitstream, size).tiles.size();
+    }
+
+    /**
+     * @brief 只解码其中一块，位置为原始坐标
+     * @throw std::runtime_error 如果块号越界或码流损坏
+     */
+    static TiledFrame decodeTile(const uint8_t* bitstream, size_t size, size_t tile, size_t numThreads = 1) {
+        const auto header = readHeader(bitstream, size);
+        if (tile >= header.tiles.size()) {
+            throw std::runtime_error("Tile index out of range: " + std::to_string(tile));
+        }
+        const auto& entry = header.tiles[tile];
+        auto frame = allocateFrame(entry.pointCount, header.attributeCount);
+        decodeTileInto(bitstream, entry, header.bitDepth, 0, frame, numThreads);
+        return frame;
+    }
+
+    /**
+     * @brief 并行解码全部块
+     * @param numThreads 线程数，各块并行解码，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果码流损坏
+     */
+    static TiledFrame decode(const uint8_t* bitstream, size_t size, size_t numThreads = 1) {
+        const auto header = readHeader(bitstream, size);
+        auto frame = allocateFrame(header.pointCount, header.attributeCount);
+        std::vector<size_t> firstPoints(header.tiles.size(), 0);
+        for (size_t tile = 1; tile < header.tiles.size(); ++tile) {
+            firstPoints[tile] = firstPoints[tile - 1] + header.tiles[tile - 1].pointCount;
+        }
+        const size_t threads = Parallel::resolveThreadCount(numThreads);
+        const size_t threadsPerTile = std::max<size_t>(1, threads / std::max<size_t>(1, header.tiles.size()));
+        Parallel::forRange(header.tiles.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t tile = begin; tile < end; ++tile) {
+                decodeTileInto(bitstream, header.tiles[tile], header.bitDepth, firstPoints[tile], frame, threadsPerTile);
+            }
+        });
+        return frame;
+    }
+
+    static TiledFrame decode(const std::vector<uint8_t>& bitstream, size_t numThreads = 1) {
+        return decode(bitstream.data(), bitstream.size(), numThreads);
+    }
+};
@@ -1,51 +1,233 @@
 #pragma once
 
 #include "Quantization.hpp"
+#include "utils/CpuFeatures.hpp"
+#include "utils/Parallel.hpp"
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <type_traits>
 
 class Transform{
-public:
+private:
+    // 并行重排时每个线程区间的最小行数
+    static constexpr size_t ReorderMinRows = 4096;
+
     template<typename T>
-    static void logTransformInPlace(std::vector<std::vector<T>>& positions, BoundingBox3D& bbox) {
-        for(auto& axisPositions : positions) {
-            std::transform(axisPositions.begin(), axisPositions.end(), axisPositions.begin(),
-                [](T val) {
-                    return std::signbit(val) ? -std::log(-val + 1.0f) : std::log(val + 1.0f);
+    static void checkColumnSizes(const std::vector<std::vector<T>>& columns, size_t numRows) {
+        for (const auto& column : columns) {
+            if (column.size() != numRows) {
+                throw std::runtime_error("Column size does not match the permutation size in reorderColumnsInPlace");
+            }
+        }
+    }
+
+    // 同类型的列共用一个暂存列：gather到暂存列后与原列交换，原列的存储成为下一列的暂存
+    template<typename T, typename IndicesType>
+    static void gatherColumns(const std::vector<IndicesType>& indices, std::vector<std::vector<T>>& columns, size_t numThreads) {
+        if (columns.empty()) {
+            return;
+        }
+        const size_t numRows = indices.size();
+        std::vector<T> scratch(numRows);
+        for (auto& column : columns) {
+            const T* src = column.data();
+            T* dst = scratch.data();
+            Parallel::forRange(numRows, numThreads, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    dst[i] = src[indices[i]];
                 }
-            );
+            }, ReorderMinRows);
+            column.swap(scratch);
+        }
+    }
+
+    // 对数变换并行时每个线程区间的最小点数
+    static constexpr size_t TransformMinPoints = 1 << 14;
+
+    // 标量路径直接使用libm，同时作为SIMD实现的精度基准
+    static float signedLog1pScalar(float value) {
+        return std::signbit(value) ? -std::log1p(-value) : std::log1p(value);
+    }
+
+    static float signedExpm1Scalar(float value) {
+        return std::signbit(value) ? -std::expm1(-value) : std::expm1(value);
+    }
+
+#if defined(GS_ARCH_X86)
+    // sign(x) * log1p(|x|)：拆分1 + |x|的指数与尾数，尾数归一化到[sqrt(1/2), sqrt(2))后用Cephes多项式求log，
+    // 再用(u - 1) - |x|修正1 + |x|的舍入误差，使小输入也保持相对精度。输入需为有限值
+    GS_TARGET_AVX2 static __m256 signedLog1pAvx2(__m256 x) {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 sign = _mm256_and_ps(x, signMask);
+        const __m256 a = _mm256_andnot_ps(signMask, x);
+
+        const __m256 u = _mm256_add_ps(one, a);
+        const __m256 roundingError = _mm256_sub_ps(_mm256_sub_ps(u, one), a);
+
+        const __m256i bits = _mm256_castps_si256(u);
+        __m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+        __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                              _mm256_set1_epi32(0x3F800000)));
+        const __m256 large = _mm256_cmp_ps(mantissa, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+        mantissa = _mm256_blendv_ps(mantissa, _mm256_mul_ps(mantissa, _mm256_set1_ps(0.5f)), large);
+        exponent = _mm256_add_ps(exponent, _mm256_and_ps(large, one));
+
+        const __m256 f = _mm256_sub_ps(mantissa, one);
+        const __m256 z = _mm256_mul_ps(f, f);
+        __m256 poly = _mm256_set1_ps(7.0376836292e-2f);
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(-1.1514610310e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(1.1676998740e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(-1.2420140846e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(1.4249322787e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(-1.6668057665e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(2.0000714765e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(-2.4999993993e-1f));
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(3.3333331174e-1f));
+        poly = _mm256_mul_ps(_mm256_mul_ps(poly, f), z);
+
+        // log(u) = e * ln2 + f - f^2 / 2 + f^3 * P(f)，ln2拆为高低两部分
+        poly = _mm256_fmadd_ps(exponent, _mm256_set1_ps(-2.12194440e-4f), poly);
+        poly = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), poly);
+        __m256 result = _mm256_add_ps(f, poly);
+        result = _mm256_fmadd_ps(exponent, _mm256_set1_ps(0.693359375f), result);
+        result = _mm256_sub_ps(result, _mm256_div_ps(roundingError, u));
+
+        return _mm256_or_ps(result, sign);
+    }
+
+    // sign(y) * expm1(|y|)：|y| = n * ln2 + r，|r| <= ln2 / 2，expm1(r)用8阶泰勒多项式，
+    // 结果为2^n * expm1(r) + (2^n - 1)，n = 0时不经过减1的抵消，小输入保持相对精度。
+    // n = 128时2^n超出float，改为2^127 * (2 * (expm1(r) + 1))，此时减1可以忽略。
+    // |y|截断到ln(FLT_MAX)以下，更大的输入饱和到接近FLT_MAX而不是无穷大。输入需为有限值
+    GS_TARGET_AVX2 static __m256 signedExpm1Avx2(__m256 y) {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 sign = _mm256_and_ps(y, signMask);
+        const __m256 a = _mm256_min_ps(_mm256_andnot_ps(signMask, y), _mm256_set1_ps(88.7228317f));
+
+        const __m256 n = _mm256_round_ps(_mm256_mul_ps(a, _mm256_set1_ps(1.44269504088896341f)),
+                                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), a);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+
+        __m256 poly = _mm256_set1_ps(1.0f / 40320.0f);
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(1.0f / 5040.0f));
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(1.0f / 720.0f));
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(1.0f / 120.0f));
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(1.0f / 24.0f));
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(1.0f / 6.0f));
+        poly = _mm256_fmadd_ps(poly, r, _mm256_set1_ps(0.5f));
+        const __m256 expm1R = _mm256_fmadd_ps(_mm256_mul_ps(r, r), poly, r);
+
+        // overflow为全1(-1)的掩码，n = 128时指数减1
+        const __m256i exponent = _mm256_cvtps_epi32(n);
+        const __m256i overflow = _mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(127));
+        const __m256i exponentBits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_add_epi32(exponent, overflow), _mm256_set1_epi32(127)), 23);
+        const __m256 scale = _mm256_castsi256_ps(exponentBits);
+        const __m256 result = _mm256_blendv_ps(_mm256_fmadd_ps(scale, expm1R, _mm256_sub_ps(scale, one)),
+                                               _mm256_mul_ps(scale, _mm256_add_ps(_mm256_add_ps(expm1R, one), _mm256_add_ps(expm1R, one))),
+                                               _mm256_castsi256_ps(overflow));
+
+        return _mm256_or_ps(result, sign);
+    }
+
+    // 不足8个的尾部拷贝到临时缓冲区处理，保证同一机器上所有元素走同一实现
+    template<__m256 (*Kernel)(__m256)>
+    GS_TARGET_AVX2 static void applyAvx2(float* data, size_t count) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(data + i, Kernel(_mm256_loadu_ps(data + i)));
         }
-        
-        // 更新边界框
-        for(auto& val : bbox.data) {
-            val = std::signbit(val) ? -std::log(-val + 1.0f) : std::log(val + 1.0f);
+        if (i < count) {
+            alignas(32) float tail[8] = {};
+            std::copy(data + i, data + count, tail);
+            _mm256_store_ps(tail, Kernel(_mm256_load_ps(tail)));
+            std::copy(tail, tail + (count - i), data + i);
+        }
+    }
+#endif
+
+    static void applySignedLog1p(float* data, size_t count, SimdLevel simdLevel) {
+#if defined(GS_ARCH_X86)
+        if (simdLevel >= SimdLevel::AVX2) {
+            applyAvx2<signedLog1pAvx2>(data, count);
+            return;
+        }
+#endif
+        std::transform(data, data + count, data, signedLog1pScalar);
+    }
+
+    static void applySignedExpm1(float* data, size_t count, SimdLevel simdLevel) {
+#if defined(GS_ARCH_X86)
+        if (simdLevel >= SimdLevel::AVX2) {
+            applyAvx2<signedExpm1Avx2>(data, count);
+            return;
         }
+#endif
+        std::transform(data, data + count, data, signedExpm1Scalar);
     }
 
+public:
+    /**
+     * @brief 对称对数变换x -> sign(x) * log(1 + |x|)，同时变换包围盒
+     * float数据在支持AVX2的CPU上使用多项式实现。以双精度log1p舍入到float为基准，在全部有限float上最大误差1ulp，
+     * 正逆变换往返误差小于16位量化步长；两项界限由gaussian-bench accuracy检查
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
     template<typename T>
-    static void inverseLogTransformInPlace(std::vector<std::vector<T>>& positions, BoundingBox3D& bbox) {
-        for (auto& axisPositions : positions) {
-            std::transform(axisPositions.begin(), axisPositions.end(), axisPositions.begin(),
-                [](T val) {
-                    if (val >= T{0}) {
-                        return static_cast<T>(std::exp(val) - 1.0);
-                    } else {
-                        return static_cast<T>(-(std::exp(-val) - 1.0));
+    static void logTransformInPlace(std::vector<std::vector<T>>& positions, BoundingBox3D& bbox, size_t numThreads = 1) {
+        const SimdLevel simdLevel = CpuFeatures::get().simdLevel;
+        for(auto& axisPositions : positions) {
+            if constexpr (std::is_same_v<T, float>) {
+                Parallel::forRange(axisPositions.size(), numThreads, [&](size_t begin, size_t end) {
+                    applySignedLog1p(axisPositions.data() + begin, end - begin, simdLevel);
+                }, TransformMinPoints);
+            } else {
+                std::transform(axisPositions.begin(), axisPositions.end(), axisPositions.begin(),
+                    [](T val) {
+                        return std::signbit(val) ? -std::log1p(-val) : std::log1p(val);
                     }
-                }
-            );
+                );
+            }
         }
 
-        // 逆变换边界框
-        for (auto& val : bbox.data) {
-            if (val >= T{0}) {
-                val = static_cast<T>(std::exp(static_cast<double>(val)) - 1.0);
+        // 更新边界框，与坐标使用同一实现，保证变换后的坐标仍落在包围盒内
+        applySignedLog1p(bbox.data.data(), bbox.data.size(), simdLevel);
+    }
+
+    // 对一段连续的float原地做对称对数变换，供按块处理的融合流程调用
+    static void logTransformInPlace(std::span<float> values) {
+        applySignedLog1p(values.data(), values.size(), CpuFeatures::get().simdLevel);
+    }
+
+    /**
+     * @brief logTransformInPlace的逆变换y -> sign(y) * (exp(|y|) - 1)，同时逆变换包围盒
+     * float数据在支持AVX2的CPU上使用多项式实现。以双精度expm1舍入到float为基准，在|y| <= ln(FLT_MAX)上最大误差1ulp
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
+    template<typename T>
+    static void inverseLogTransformInPlace(std::vector<std::vector<T>>& positions, BoundingBox3D& bbox, size_t numThreads = 1) {
+        const SimdLevel simdLevel = CpuFeatures::get().simdLevel;
+        for (auto& axisPositions : positions) {
+            if constexpr (std::is_same_v<T, float>) {
+                Parallel::forRange(axisPositions.size(), numThreads, [&](size_t begin, size_t end) {
+                    applySignedExpm1(axisPositions.data() + begin, end - begin, simdLevel);
+                }, TransformMinPoints);
             } else {
-                val = static_cast<T>(-(std::exp(static_cast<double>(-val)) - 1.0));
+                std::transform(axisPositions.begin(), axisPositions.end(), axisPositions.begin(),
+                    [](T val) {
+                        return std::signbit(val) ? -std::expm1(-val) : std::expm1(val);
+                    }
+                );
             }
         }
+
+        // 逆变换边界框
+        applySignedExpm1(bbox.data.data(), bbox.data.size(), simdLevel);
     }
 
     template<typename PropertyType, typename IndicesType = uint64_t>
@@ -59,6 +241,21 @@ public:
 
         property = std::move(sortedProperty);
     }
+
+    /**
+     * @brief 用同一个排列重排多组列，column[i] = column[indices[i]]
+     * 代替对每列单独调用sortInPlaceWithIndices：每种类型只分配一个暂存列并在各列间循环复用，
+     * 每列的gather按行区间多线程执行。逐列而非跨列分块处理，随机排列下可保留单列源数据在缓存中的复用。
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @param columnSets 若干组列，每组内的列类型相同，不同组的类型可以不同
+     * @throw std::runtime_error 如果某列长度与排列长度不一致
+     */
+    template<typename IndicesType, typename... ColumnTypes>
+    static void reorderColumnsInPlace(const std::vector<IndicesType>& indices, size_t numThreads, std::vector<std::vector<ColumnTypes>>&... columnSets) {
+        (checkColumnSizes(columnSets, indices.size()), ...);
+        (gatherColumns(indices, columnSets, numThreads), ...);
+    }
+
     // 将sh0转换为RGB颜色
     template<typename OutType = uint8_t, int ColorDepth = 8>
     static std::vector<std::vector<OutType>> sh0ToPlanarRGB(std::vector<std::vector<float>>& sh0) {
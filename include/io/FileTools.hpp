@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <filesystem>
 #include <regex>
 #include <iostream>
@@ -43,7 +44,7 @@ public:
      * @brief 在指定目录下查找符合给定正则表达式的所有文件路径
      * @param directory 需要查找的目录
      * @param pattern 文件名的正则表达式
-     * @return 符合条件的文件路径列表
+     * @return 符合条件的文件路径列表，按路径排序，目录遍历顺序因平台而异，帧序依赖于此
      */
     static std::vector<std::filesystem::path> findFilesMatchingPattern(const std::string& directory, const std::string& pattern) {
         namespace fs = std::filesystem;
@@ -67,6 +68,7 @@ public:
             }
         }
 
+        std::sort(matchedFiles.begin(), matchedFiles.end());
         return matchedFiles;
     }
     /**
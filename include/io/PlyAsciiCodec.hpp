@@ -0,0 +1,216 @@
+#pragma once
+
+#include "PlySchema.hpp"
+#include "PlyData.hpp"
+#include "utils/Parallel.hpp"
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+// ASCII格式PLY数据区的批量解析与格式化
+// 解析基于std::from_chars，按换行边界切分为多个块并行处理；格式化基于std::to_chars写入每线程的大缓冲区
+class PlyAsciiCodec {
+private:
+    // 并行解析时每个块的最小字节数
+    static constexpr size_t MinParseChunkBytes = 1 << 20;
+    // 并行格式化时每个块的记录数
+    static constexpr size_t FormatChunkRecords = 1 << 16;
+
+    struct ColumnTarget {
+        PropertyStorageType storageType;
+        char* data;
+    };
+
+    struct ColumnSource {
+        PropertyStorageType storageType;
+        const char* data;
+    };
+
+    static bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static const char* findLineEnd(const char* begin, const char* end) {
+        const void* newline = std::memchr(begin, '\n', static_cast<size_t>(end - begin));
+        return newline ? static_cast<const char*>(newline) : end;
+    }
+
+    template<typename T>
+    static const char* parseValue(const char* cursor, const char* lineEnd, T& value) {
+        while (cursor < lineEnd && isBlank(*cursor)) ++cursor;
+        if (cursor < lineEnd && *cursor == '+') ++cursor;
+        auto [next, error] = std::from_chars(cursor, lineEnd, value);
+        if (error != std::errc()) {
+            SPDLOG_ERROR("Failed to parse ASCII value near: {}", std::string(cursor, std::min<const char*>(cursor + 32, lineEnd)));
+            throw std::runtime_error("Failed to parse ASCII PLY value");
+        }
+        return next;
+    }
+
+    // 解析[begin, end)中的完整行，写入各列从firstRow开始的位置，返回解析的行数
+    static size_t parseLines(const char* begin, const char* end, const std::vector<ColumnTarget>& columns, size_t firstRow) {
+        size_t row = firstRow;
+        const char* cursor = begin;
+        while (cursor < end) {
+            const char* lineEnd = findLineEnd(cursor, end);
+            for (const auto& column : columns) {
+                switch (column.storageType) {
+                    case PropertyStorageType::INT32:
+                        cursor = parseValue(cursor, lineEnd, reinterpret_cast<int32_t*>(column.data)[row]);
+                        break;
+                    case PropertyStorageType::FLOAT32:
+                        cursor = parseValue(cursor, lineEnd, reinterpret_cast<float*>(column.data)[row]);
+                        break;
+                    default:
+                        throw std::runtime_error("Unsupported storage type for ASCII format");
+                }
+            }
+            cursor = lineEnd + 1;
+            ++row;
+        }
+        return row - firstRow;
+    }
+
+    static size_t countLines(const char* begin, const char* end) {
+        size_t lines = 0;
+        const char* cursor = begin;
+        while (cursor < end) {
+            cursor = findLineEnd(cursor, end) + 1;
+            ++lines;
+        }
+        return lines;
+    }
+
+    template<typename T>
+    static char* formatValue(char* out, char* outEnd, T value) {
+        auto [next, error] = std::to_chars(out, outEnd, value);
+        if (error != std::errc()) {
+            throw std::runtime_error("Failed to format ASCII PLY value");
+        }
+        return next;
+    }
+
+    // 单个值的最大字符数，float的最短往返表示不超过15个字符
+    static constexpr size_t MaxValueChars = 24;
+
+    static void formatRows(const std::vector<ColumnSource>& columns, size_t begin, size_t end, std::string& buffer) {
+        buffer.resize((end - begin) * columns.size() * MaxValueChars);
+        char* out = buffer.data();
+        char* outEnd = buffer.data() + buffer.size();
+        for (size_t row = begin; row < end; ++row) {
+            for (size_t j = 0; j < columns.size(); ++j) {
+                if (j > 0) *out++ = ' ';
+                switch (columns[j].storageType) {
+                    case PropertyStorageType::INT32:
+                        out = formatValue(out, outEnd, reinterpret_cast<const int32_t*>(columns[j].data)[row]);
+                        break;
+                    case PropertyStorageType::FLOAT32:
+                        out = formatValue(out, outEnd, reinterpret_cast<const float*>(columns[j].data)[row]);
+                        break;
+                    default:
+                        throw std::runtime_error("Unsupported storage type for ASCII format");
+                }
+            }
+            *out++ = '\n';
+        }
+        buffer.resize(static_cast<size_t>(out - buffer.data()));
+    }
+
+public:
+    /**
+     * @brief 跳过count行，返回这些行之后的位置
+     * @throw std::runtime_error 如果数据不足count行
+     */
+    static const char* findElementEnd(const char* begin, const char* end, size_t count) {
+        const char* cursor = begin;
+        for (size_t i = 0; i < count; ++i) {
+            if (cursor >= end) {
+                SPDLOG_ERROR("Truncated ASCII body: expected {} lines, got {}", count, i);
+                throw std::runtime_error("Truncated ASCII body");
+            }
+            cursor = std::min(findLineEnd(cursor, end) + 1, end);
+        }
+        return cursor;
+    }
+
+    /**
+     * @brief 解析count行ASCII记录到列中
+     * @param begin 数据区起始位置，应恰好包含count行
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
+    static void parse(const char* begin, const char* end, size_t count, std::vector<PropertyColumn>& columns, size_t numThreads) {
+        std::vector<ColumnTarget> targets;
+        for (auto& column : columns) {
+            targets.push_back({column.getStorageType(), column.rawData()});
+        }
+
+        // 按字节均分后，将切分点推进到下一个换行之后
+        const size_t totalBytes = static_cast<size_t>(end - begin);
+        const size_t maxChunks = std::max<size_t>(1, totalBytes / MinParseChunkBytes);
+        const size_t chunks = std::min(Parallel::resolveThreadCount(numThreads), maxChunks);
+        std::vector<const char*> bounds(chunks + 1, end);
+        bounds[0] = begin;
+        for (size_t i = 1; i < chunks; ++i) {
+            const char* split = std::max(bounds[i - 1], begin + totalBytes * i / chunks);
+            bounds[i] = split >= end ? end : std::min(findLineEnd(split, end) + 1, end);
+        }
+
+        // 先并行统计各块行数，得到每块的起始行号，再并行解析
+        std::vector<size_t> firstRows(chunks + 1, 0);
+        if (chunks > 1) {
+            std::vector<size_t> lineCounts(chunks);
+            Parallel::forRange(chunks, numThreads, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    lineCounts[i] = countLines(bounds[i], bounds[i + 1]);
+                }
+            });
+            for (size_t i = 0; i < chunks; ++i) {
+                firstRows[i + 1] = firstRows[i] + lineCounts[i];
+            }
+        } else {
+            firstRows[1] = count;
+        }
+        if (firstRows[chunks] != count) {
+            SPDLOG_ERROR("ASCII body line count mismatch: expected {}, got {}", count, firstRows[chunks]);
+            throw std::runtime_error("ASCII body line count mismatch");
+        }
+
+        Parallel::forRange(chunks, numThreads, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                parseLines(bounds[i], bounds[i + 1], targets, firstRows[i]);
+            }
+        });
+    }
+
+    /**
+     * @brief 将各列格式化为ASCII记录写入流，按块并行格式化后按顺序写出
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     */
+    static void write(std::ostream& file, const std::vector<const PropertyColumn*>& columns, size_t count, size_t numThreads) {
+        std::vector<ColumnSource> sources;
+        for (const auto* column : columns) {
+            sources.push_back({column->getStorageType(), column->rawData()});
+        }
+
+        // 每轮每个线程格式化一个块，限制缓冲区占用的内存
+        const size_t threads = Parallel::resolveThreadCount(numThreads);
+        std::vector<std::string> buffers(threads);
+        for (size_t roundBegin = 0; roundBegin < count; roundBegin += threads * FormatChunkRecords) {
+            const size_t roundEnd = std::min(count, roundBegin + threads * FormatChunkRecords);
+            const size_t roundChunks = (roundEnd - roundBegin + FormatChunkRecords - 1) / FormatChunkRecords;
+            Parallel::forRange(roundChunks, threads, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; ++i) {
+                    const size_t begin = roundBegin + i * FormatChunkRecords;
+                    formatRows(sources, begin, std::min(roundEnd, begin + FormatChunkRecords), buffers[i]);
+                }
+            });
+            for (size_t i = 0; i < roundChunks; ++i) {
+                file.write(buffers[i].data(), static_cast<std::streamsize>(buffers[i].size()));
+            }
+        }
+    }
+};
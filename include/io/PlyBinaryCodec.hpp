@@ -0,0 +1,466 @@
+#pragma once
+
+#include "PlySchema.hpp"
+#include "PlyData.hpp"
+#include "utils/CpuFeatures.hpp"
+#include "utils/Parallel.hpp"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+// PLY Header中声明的二进制数值类型
+enum class HeaderValueKind {
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64
+};
+
+class BinaryPropertyLayout {
+public:
+    size_t offset;                      // 属性在记录中的字节偏移
+    size_t size;                        // 属性在记录中的字节数
+    HeaderValueKind headerKind;         // 文件中的数值类型
+    PropertyStorageType storageType;    // 内存中的存储类型
+
+    // 文件中的4字节值可以按位直接拷贝到列中，不需要数值转换
+    bool isDirectCopy() const {
+        if (storageType == PropertyStorageType::FLOAT32) {
+            return headerKind == HeaderValueKind::FLOAT32;
+        }
+        return headerKind == HeaderValueKind::INT32 || headerKind == HeaderValueKind::UINT32;
+    }
+
+    static HeaderValueKind parseHeaderKind(const std::string& headerType) {
+        if (headerType == "char" || headerType == "int8") return HeaderValueKind::INT8;
+        if (headerType == "uchar" || headerType == "uint8") return HeaderValueKind::UINT8;
+        if (headerType == "short" || headerType == "int16") return HeaderValueKind::INT16;
+        if (headerType == "ushort" || headerType == "uint16") return HeaderValueKind::UINT16;
+        if (headerType == "int" || headerType == "int32") return HeaderValueKind::INT32;
+        if (headerType == "uint" || headerType == "uint32") return HeaderValueKind::UINT32;
+        if (headerType == "float" || headerType == "float32") return HeaderValueKind::FLOAT32;
+        if (headerType == "double" || headerType == "float64") return HeaderValueKind::FLOAT64;
+        SPDLOG_ERROR("Unsupported PLY header type: {}", headerType);
+        throw std::runtime_error("Unsupported PLY header type: " + headerType);
+    }
+};
+
+// 一段在记录中连续、且都可以直接拷贝的属性，批量转置的基本单位
+struct DirectPropertyRun {
+    size_t firstProperty;
+    size_t count;
+};
+
+// 由ElementSchema推导出的定长二进制记录布局
+class BinaryRecordLayout {
+public:
+    size_t stride = 0;
+    std::vector<BinaryPropertyLayout> properties;
+    std::vector<DirectPropertyRun> directRuns;
+    std::vector<size_t> convertedProperties;
+
+    static BinaryRecordLayout fromSchema(const ElementSchema& schema) {
+        return fromProperties(schema.properties);
+    }
+
+    // 按给定属性顺序紧密排列的记录布局
+    static BinaryRecordLayout fromProperties(const std::vector<PropertySchema>& properties) {
+        BinaryRecordLayout layout;
+        for (const auto& property : properties) {
+            BinaryPropertyLayout propertyLayout = {
+                layout.stride,
+                property.getHeaderTypeSize(),
+                BinaryPropertyLayout::parseHeaderKind(property.currentHeaderType),
+                property.storageType
+            };
+            layout.stride += propertyLayout.size;
+            layout.properties.push_back(propertyLayout);
+        }
+
+        layout.buildRuns();
+        return layout;
+    }
+
+    // 只保留部分属性的布局，记录步长不变，用于按需读取
+    BinaryRecordLayout subset(const std::vector<size_t>& propertyIndices) const {
+        BinaryRecordLayout layout;
+        layout.stride = stride;
+        for (size_t index : propertyIndices) {
+            layout.properties.push_back(properties.at(index));
+        }
+        layout.buildRuns();
+        return layout;
+    }
+
+    size_t getBodySize(size_t recordCount) const {
+        return stride * recordCount;
+    }
+
+private:
+    void buildRuns() {
+        directRuns.clear();
+        convertedProperties.clear();
+        for (size_t i = 0; i < properties.size(); ++i) {
+            if (!properties[i].isDirectCopy()) {
+                convertedProperties.push_back(i);
+                continue;
+            }
+            // 与上一段在记录中字节相邻则合并
+            if (!directRuns.empty()) {
+                auto& run = directRuns.back();
+                const auto& last = properties[run.firstProperty + run.count - 1];
+                if (run.firstProperty + run.count == i && last.offset + last.size == properties[i].offset) {
+                    run.count++;
+                    continue;
+                }
+            }
+            directRuns.push_back({i, 1});
+        }
+    }
+};
+
+// 小端序定长记录(AoS)与属性列(SoA)之间的批量转换
+// 可直接拷贝的属性按8列(AVX2)/4列(SSE)一组做寄存器内转置，其余属性逐值转换
+class PlyBinaryCodec {
+private:
+    // 每次处理的记录数，保证源数据块留在L2缓存中，以便多组属性复用
+    static constexpr size_t BlockRecords = 1024;
+    // 多线程时每个线程至少处理的记录数
+    static constexpr size_t ParallelChunkRecords = 16384;
+
+public:
+    // 将count条记录拆分写入各列的[firstRow, firstRow + count)区间
+    static void deinterleave(const char* records, size_t count, const BinaryRecordLayout& layout,
+                             std::vector<PropertyColumn>& columns, size_t firstRow = 0) {
+        if (columns.size() != layout.properties.size()) {
+            SPDLOG_ERROR("Column count {} does not match record layout {}", columns.size(), layout.properties.size());
+            throw std::runtime_error("Column count does not match record layout");
+        }
+
+        std::vector<char*> columnData(columns.size());
+        for (size_t i = 0; i < columns.size(); ++i) {
+            columnData[i] = columns[i].rawData() + firstRow * 4;
+        }
+
+        const SimdLevel simdLevel = CpuFeatures::get().simdLevel;
+        for (size_t begin = 0; begin < count; begin += BlockRecords) {
+            const size_t rows = std::min(BlockRecords, count - begin);
+            const char* block = records + begin * layout.stride;
+
+            for (const auto& run : layout.directRuns) {
+                deinterleaveRun(block, rows, layout, run, columnData.data(), begin, simdLevel);
+            }
+            for (size_t propertyIndex : layout.convertedProperties) {
+                convertProperty(block, rows, layout.stride, layout.properties[propertyIndex],
+                                columnData[propertyIndex] + begin * 4);
+            }
+        }
+    }
+
+    // 将各列[firstRow, firstRow + count)区间的值交织写成count条记录，deinterleave的逆过程
+    static void interleave(const std::vector<const PropertyColumn*>& columns, size_t count, const BinaryRecordLayout& layout,
+                           char* records, size_t firstRow = 0) {
+        if (columns.size() != layout.properties.size()) {
+            SPDLOG_ERROR("Column count {} does not match record layout {}", columns.size(), layout.properties.size());
+            throw std::runtime_error("Column count does not match record layout");
+        }
+
+        std::vector<const char*> columnData(columns.size());
+        for (size_t i = 0; i < columns.size(); ++i) {
+            columnData[i] = columns[i]->rawData() + firstRow * 4;
+        }
+
+        const SimdLevel simdLevel = CpuFeatures::get().simdLevel;
+        for (size_t begin = 0; begin < count; begin += BlockRecords) {
+            const size_t rows = std::min(BlockRecords, count - begin);
+            char* block = records + begin * layout.stride;
+
+            for (const auto& run : layout.directRuns) {
+                interleaveRun(columnData.data(), begin, rows, layout, run, block, simdLevel);
+            }
+            for (size_t propertyIndex : layout.convertedProperties) {
+                convertPropertyBack(columnData[propertyIndex] + begin * 4, rows, layout.stride,
+                                    layout.properties[propertyIndex], block);
+            }
+        }
+    }
+
+    static void interleaveParallel(const std::vector<const PropertyColumn*>& columns, size_t count, const BinaryRecordLayout& layout,
+                                   char* records, size_t numThreads) {
+        Parallel::forRange(count, numThreads, [&](size_t begin, size_t end) {
+            interleave(columns, end - begin, layout, records + begin * layout.stride, begin);
+        }, ParallelChunkRecords);
+    }
+
+    // 按记录区间划分给多个线程，各线程直接写入预分配列的对应区间
+    static void deinterleaveParallel(const char* records, size_t count, const BinaryRecordLayout& layout,
+                                     std::vector<PropertyColumn>& columns, size_t numThreads) {
+        Parallel::forRange(count, numThreads, [&](size_t begin, size_t end) {
+            deinterleave(records + begin * layout.stride, end - begin, layout, columns, begin);
+        }, ParallelChunkRecords);
+    }
+
+private:
+    static void deinterleaveRun(const char* block, size_t rows, const BinaryRecordLayout& layout,
+                                const DirectPropertyRun& run, char* const* columnData, size_t rowOffset,
+                                SimdLevel simdLevel) {
+        size_t property = run.firstProperty;
+        size_t remaining = run.count;
+        char* dst[8];
+
+#if defined(GS_ARCH_X86)
+        if (simdLevel >= SimdLevel::AVX2) {
+            for (; remaining >= 8; remaining -= 8, property += 8) {
+                for (size_t k = 0; k < 8; ++k) dst[k] = columnData[property + k] + rowOffset * 4;
+                deinterleave8Avx2(block + layout.properties[property].offset, layout.stride, rows, dst);
+            }
+        }
+        if (simdLevel >= SimdLevel::SSE) {
+            for (; remaining >= 4; remaining -= 4, property += 4) {
+                for (size_t k = 0; k < 4; ++k) dst[k] = columnData[property + k] + rowOffset * 4;
+                deinterleave4Sse(block + layout.properties[property].offset, layout.stride, rows, dst);
+            }
+        }
+#endif
+        while (remaining > 0) {
+            const size_t width = std::min<size_t>(remaining, 8);
+            for (size_t k = 0; k < width; ++k) dst[k] = columnData[property + k] + rowOffset * 4;
+            deinterleaveScalar(block + layout.properties[property].offset, layout.stride, rows, width, dst, 0);
+            remaining -= width;
+            property += width;
+        }
+    }
+
+    static void deinterleaveScalar(const char* src, size_t stride, size_t rows, size_t width,
+                                   char* const* dst, size_t firstRow) {
+        for (size_t r = firstRow; r < rows; ++r) {
+            const char* record = src + r * stride;
+            for (size_t k = 0; k < width; ++k) {
+                std::memcpy(dst[k] + r * 4, record + k * 4, 4);
+            }
+        }
+    }
+
+    static void interleaveRun(const char* const* columnData, size_t rowOffset, size_t rows, const BinaryRecordLayout& layout,
+                              const DirectPropertyRun& run, char* block, SimdLevel simdLevel) {
+        size_t property = run.firstProperty;
+        size_t remaining = run.count;
+        const char* src[8];
+
+#if defined(GS_ARCH_X86)
+        if (simdLevel >= SimdLevel::AVX2) {
+            for (; remaining >= 8; remaining -= 8, property += 8) {
+                for (size_t k = 0; k < 8; ++k) src[k] = columnData[property + k] + rowOffset * 4;
+                interleave8Avx2(src, block + layout.properties[property].offset, layout.stride, rows);
+            }
+        }
+        if (simdLevel >= SimdLevel::SSE) {
+            for (; remaining >= 4; remaining -= 4, property += 4) {
+                for (size_t k = 0; k < 4; ++k) src[k] = columnData[property + k] + rowOffset * 4;
+                interleave4Sse(src, block + layout.properties[property].offset, layout.stride, rows);
+            }
+        }
+#endif
+        while (remaining > 0) {
+            const size_t width = std::min<size_t>(remaining, 8);
+            for (size_t k = 0; k < width; ++k) src[k] = columnData[property + k] + rowOffset * 4;
+            interleaveScalar(src, block + layout.properties[property].offset, layout.stride, rows, width, 0);
+            remaining -= width;
+            property += width;
+        }
+    }
+
+    static void interleaveScalar(const char* const* src, char* dst, size_t stride, size_t rows, size_t width, size_t firstRow) {
+        for (size_t r = firstRow; r < rows; ++r) {
+            char* record = dst + r * stride;
+            for (size_t k = 0; k < width; ++k) {
+                std::memcpy(record + k * 4, src[k] + r * 4, 4);
+            }
+        }
+    }
+
+#if defined(GS_ARCH_X86)
+    GS_TARGET_AVX2 static void interleave8Avx2(const char* const* src, char* dst, size_t stride, size_t rows) {
+        size_t r = 0;
+        for (; r + 8 <= rows; r += 8) {
+            __m256 v[8];
+            for (size_t k = 0; k < 8; ++k) {
+                v[k] = _mm256_loadu_ps(reinterpret_cast<const float*>(src[k] + r * 4));
+            }
+            transpose8x8Avx2(v);
+            char* base = dst + r * stride;
+            for (size_t k = 0; k < 8; ++k) {
+                _mm256_storeu_ps(reinterpret_cast<float*>(base + k * stride), v[k]);
+            }
+        }
+        interleaveScalar(src, dst, stride, rows, 8, r);
+    }
+
+    static void interleave4Sse(const char* const* src, char* dst, size_t stride, size_t rows) {
+        size_t r = 0;
+        for (; r + 4 <= rows; r += 4) {
+            __m128 v0 = _mm_loadu_ps(reinterpret_cast<const float*>(src[0] + r * 4));
+            __m128 v1 = _mm_loadu_ps(reinterpret_cast<const float*>(src[1] + r * 4));
+            __m128 v2 = _mm_loadu_ps(reinterpret_cast<const float*>(src[2] + r * 4));
+            __m128 v3 = _mm_loadu_ps(reinterpret_cast<const float*>(src[3] + r * 4));
+            _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+            char* base = dst + r * stride;
+            _mm_storeu_ps(reinterpret_cast<float*>(base), v0);
+            _mm_storeu_ps(reinterpret_cast<float*>(base + stride), v1);
+            _mm_storeu_ps(reinterpret_cast<float*>(base + 2 * stride), v2);
+            _mm_storeu_ps(reinterpret_cast<float*>(base + 3 * stride), v3);
+        }
+        interleaveScalar(src, dst, stride, rows, 4, r);
+    }
+
+    GS_TARGET_AVX2 static void deinterleave8Avx2(const char* src, size_t stride, size_t rows, char* const* dst) {
+        size_t r = 0;
+        for (; r + 8 <= rows; r += 8) {
+            const char* base = src + r * stride;
+            __m256 v[8];
+            for (size_t k = 0; k < 8; ++k) {
+                v[k] = _mm256_loadu_ps(reinterpret_cast<const float*>(base + k * stride));
+            }
+            transpose8x8Avx2(v);
+            for (size_t k = 0; k < 8; ++k) {
+                _mm256_storeu_ps(reinterpret_cast<float*>(dst[k] + r * 4), v[k]);
+            }
+        }
+        deinterleaveScalar(src, stride, rows, 8, dst, r);
+    }
+
+    static void deinterleave4Sse(const char* src, size_t stride, size_t rows, char* const* dst) {
+        size_t r = 0;
+        for (; r + 4 <= rows; r += 4) {
+            const char* base = src + r * stride;
+            __m128 v0 = _mm_loadu_ps(reinterpret_cast<const float*>(base));
+            __m128 v1 = _mm_loadu_ps(reinterpret_cast<const float*>(base + stride));
+            __m128 v2 = _mm_loadu_ps(reinterpret_cast<const float*>(base + 2 * stride));
+            __m128 v3 = _mm_loadu_ps(reinterpret_cast<const float*>(base + 3 * stride));
+            _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+            _mm_storeu_ps(reinterpret_cast<float*>(dst[0] + r * 4), v0);
+            _mm_storeu_ps(reinterpret_cast<float*>(dst[1] + r * 4), v1);
+            _mm_storeu_ps(reinterpret_cast<float*>(dst[2] + r * 4), v2);
+            _mm_storeu_ps(reinterpret_cast<float*>(dst[3] + r * 4), v3);
+        }
+        deinterleaveScalar(src, stride, rows, 4, dst, r);
+    }
+
+    // 8x8的32位元素转置，shuffle只搬运比特，整型数据同样适用
+    GS_TARGET_AVX2 static void transpose8x8Avx2(__m256 (&v)[8]) {
+        __m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+        __m256 t1 = _mm256_unpackhi_ps(v[0], v[1]);
+        __m256 t2 = _mm256_unpacklo_ps(v[2], v[3]);
+        __m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+        __m256 t4 = _mm256_unpacklo_ps(v[4], v[5]);
+        __m256 t5 = _mm256_unpackhi_ps(v[4], v[5]);
+        __m256 t6 = _mm256_unpacklo_ps(v[6], v[7]);
+        __m256 t7 = _mm256_unpackhi_ps(v[6], v[7]);
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        v[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+        v[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+        v[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+        v[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+        v[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+        v[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+        v[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+        v[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+#endif
+
+    template<typename SourceType>
+    static SourceType loadValue(const char* src) {
+        SourceType value;
+        std::memcpy(&value, src, sizeof(SourceType));
+        return value;
+    }
+
+    template<typename SourceType, typename TargetType>
+    static void convertRows(const char* src, size_t rows, size_t stride, TargetType* dst) {
+        for (size_t r = 0; r < rows; ++r) {
+            dst[r] = static_cast<TargetType>(loadValue<SourceType>(src + r * stride));
+        }
+    }
+
+    template<typename TargetType>
+    static void convertRowsTo(const char* src, size_t rows, size_t stride, HeaderValueKind kind, TargetType* dst) {
+        switch (kind) {
+            case HeaderValueKind::INT8: convertRows<int8_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::UINT8: convertRows<uint8_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::INT16: convertRows<int16_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::UINT16: convertRows<uint16_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::INT32: convertRows<int32_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::UINT32: convertRows<uint32_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::FLOAT32: convertRows<float>(src, rows, stride, dst); break;
+            case HeaderValueKind::FLOAT64: convertRows<double>(src, rows, stride, dst); break;
+        }
+    }
+
+    template<typename TargetType, typename SourceType>
+    static void convertRowsBack(const SourceType* src, size_t rows, size_t stride, char* dst) {
+        for (size_t r = 0; r < rows; ++r) {
+            const TargetType value = static_cast<TargetType>(src[r]);
+            std::memcpy(dst + r * stride, &value, sizeof(TargetType));
+        }
+    }
+
+    template<typename SourceType>
+    static void convertRowsBackFrom(const SourceType* src, size_t rows, size_t stride, HeaderValueKind kind, char* dst) {
+        switch (kind) {
+            case HeaderValueKind::INT8: convertRowsBack<int8_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::UINT8: convertRowsBack<uint8_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::INT16: convertRowsBack<int16_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::UINT16: convertRowsBack<uint16_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::INT32: convertRowsBack<int32_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::UINT32: convertRowsBack<uint32_t>(src, rows, stride, dst); break;
+            case HeaderValueKind::FLOAT32: convertRowsBack<float>(src, rows, stride, dst); break;
+            case HeaderValueKind::FLOAT64: convertRowsBack<double>(src, rows, stride, dst); break;
+        }
+    }
+
+    // 写出时将存储类型转换回文件中声明的类型
+    static void convertPropertyBack(const char* src, size_t rows, size_t stride, const BinaryPropertyLayout& property, char* block) {
+        char* dst = block + property.offset;
+        switch (property.storageType) {
+            case PropertyStorageType::INT32:
+                convertRowsBackFrom(reinterpret_cast<const int32_t*>(src), rows, stride, property.headerKind, dst);
+                break;
+            case PropertyStorageType::FLOAT32:
+                convertRowsBackFrom(reinterpret_cast<const float*>(src), rows, stride, property.headerKind, dst);
+                break;
+            default:
+                SPDLOG_ERROR("Unsupported storage type during binary conversion");
+                throw std::runtime_error("Unsupported storage type during binary conversion");
+        }
+    }
+
+    // 文件类型与存储类型不一致的属性逐值转换
+    static void convertProperty(const char* block, size_t rows, size_t stride, const BinaryPropertyLayout& property, char* dst) {
+        const char* src = block + property.offset;
+        switch (property.storageType) {
+            case PropertyStorageType::INT32:
+                convertRowsTo(src, rows, stride, property.headerKind, reinterpret_cast<int32_t*>(dst));
+                break;
+            case PropertyStorageType::FLOAT32:
+                convertRowsTo(src, rows, stride, property.headerKind, reinterpret_cast<float*>(dst));
+                break;
+            default:
+                SPDLOG_ERROR("Unsupported storage type during binary conversion");
+                throw std::runtime_error("Unsupported storage type during binary conversion");
+        }
+    }
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "PlyView.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// 分块流式读取：在PlyView的映射上按固定点数依次物化部分属性，常驻内存与文件大小无关
+// 映射区按顺序访问提示内核预读，已读过的页随即释放，大于内存的场景也只占用一个块的空间
+// 仅支持binary_little_endian格式
+class PlyChunkReader {
+private:
+    PlyView view;
+    std::string elementName;
+    std::vector<std::string> propertyNames;
+    size_t chunkSize;
+    size_t count;
+    size_t position = 0;
+    // 已释放到的字节位置，按页对齐
+    size_t releasedBytes = 0;
+
+    // 页提示在不支持madvise的平台上为空操作，只影响常驻内存，不影响结果
+    static void advise([[maybe_unused]] const char* data, [[maybe_unused]] size_t size, [[maybe_unused]] bool sequential) {
+#if defined(__unix__) || defined(__APPLE__)
+        const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+        // 只影响性能，失败时忽略
+        madvise(reinterpret_cast<void*>(begin), end - begin, sequential ? MADV_SEQUENTIAL : MADV_DONTNEED);
+#endif
+    }
+
+    // 释放[0, bytes)中完整的页，页的后半部分可能属于下一个块，留到下次释放
+    void releaseConsumed(size_t bytes) {
+#if defined(__unix__) || defined(__APPLE__)
+        const auto body = view.getElementBody(elementName);
+        const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t pageEnd = (reinterpret_cast<uintptr_t>(body.data()) + bytes) & ~(pageSize - 1);
+        const uintptr_t releasedEnd = reinterpret_cast<uintptr_t>(body.data()) + releasedBytes;
+        if (pageEnd > releasedEnd) {
+            advise(body.data() + releasedBytes, pageEnd - releasedEnd, false);
+            releasedBytes = pageEnd - reinterpret_cast<uintptr_t>(body.data());
+        }
+#else
+        releasedBytes = bytes;
+#endif
+    }
+
+public:
+    /**
+     * @brief 打开文件，只解析Header
+     * @param propertyNames 每块物化的属性，按此顺序返回
+     * @param chunkSize 每块的点数，最后一块可能更少
+     * @throw std::runtime_error 如果文件不存在、不是binary_little_endian格式或缺少属性
+     */
+    PlyChunkReader(const std::string& filename, const std::string& elementName, std::vector<std::string> propertyNames, size_t chunkSize)
+        : view(PlyView::open(filename)), elementName(elementName), propertyNames(std::move(propertyNames)), chunkSize(chunkSize),
+          count(view.getCount(elementName)) {
+        if (chunkSize == 0) {
+            throw std::invalid_argument("Chunk size must be positive");
+        }
+        // 提前检查属性是否存在，避免读到一半才失败
+        view.materializeColumns(elementName, this->propertyNames, 0, 0);
+        const auto body = view.getElementBody(elementName);
+        advise(body.data(), body.size(), true);
+    }
+
+    size_t getCount() const {
+        return count;
+    }
+
+    size_t getChunkSize() const {
+        return chunkSize;
+    }
+
+    size_t getChunkCount() const {
+        return (count + chunkSize - 1) / chunkSize;
+    }
+
+    // 下一块第一个点的序号
+    size_t getPosition() const {
+        return position;
+    }
+
+    const std::vector<ElementSchema>& getSchemas() const {
+        return view.getSchemas();
+    }
+
+    /**
+     * @brief 读取下一块
+     * @param numThreads 块内并行拆分记录的线程数，0表示使用全部硬件线程
+     * @return 每个属性一列；读完后返回空
+     * @throw std::runtime_error 如果文件中的属性类型与T不一致
+     */
+    template<typename T>
+    std::vector<std::vector<T>> readChunk(size_t numThreads = 1) {
+        if (position >= count) {
+            return {};
+        }
+        const size_t chunkPoints = std::min(chunkSize, count - position);
+        auto columns = view.materializeColumns(elementName, propertyNames, position, chunkPoints, numThreads);
+        position += chunkPoints;
+        releaseConsumed(view.getElementBody(elementName).size() / count * position);
+
+        std::vector<std::vector<T>> result;
+        result.reserve(columns.size());
+        for (auto& column : columns) {
+            result.push_back(column.takeValues<T>());
+        }
+        return result;
+    }
+
+    // 回到文件开头，多遍处理(如先求包围盒再量化)时使用
+    void rewind() {
+        position = 0;
+        releasedBytes = 0;
+        const auto body = view.getElementBody(elementName);
+        advise(body.data(), body.size(), true);
+    }
+};
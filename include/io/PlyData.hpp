@@ -5,18 +5,123 @@
 #include <string>
 #include <variant>
 #include <vector>
+#include <span>
+#include <algorithm>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <spdlog/spdlog.h>
 #include "PlySchema.hpp"
 
-using PropertyValue = std::variant<int32_t, float>;
+// C++类型到PropertyStorageType的映射
+template<typename T>
+struct PropertyStorageTraits;
+
+template<>
+struct PropertyStorageTraits<int32_t> {
+    static constexpr PropertyStorageType storageType = PropertyStorageType::INT32;
+};
+
+template<>
+struct PropertyStorageTraits<float> {
+    static constexpr PropertyStorageType storageType = PropertyStorageType::FLOAT32;
+};
+
+// 按类型连续存储的一列属性数据，避免逐值的variant开销
+class PropertyColumn {
+public:
+    using Storage = std::variant<std::vector<int32_t>, std::vector<float>>;
+
+    PropertyColumn() = default;
+
+    template<typename T>
+    explicit PropertyColumn(std::vector<T>&& values) : storage(std::move(values)) {}
+
+    // 按存储类型创建指定长度的列
+    static PropertyColumn create(PropertyStorageType storageType, size_t size) {
+        switch (storageType) {
+            case PropertyStorageType::INT32:
+                return PropertyColumn(std::vector<int32_t>(size));
+            case PropertyStorageType::FLOAT32:
+                return PropertyColumn(std::vector<float>(size));
+            default:
+                SPDLOG_ERROR("Unsupported storage type for property column");
+                throw std::runtime_error("Unsupported storage type for property column");
+        }
+    }
+
+    PropertyStorageType getStorageType() const {
+        return std::holds_alternative<std::vector<int32_t>>(storage) ? PropertyStorageType::INT32 : PropertyStorageType::FLOAT32;
+    }
+
+    size_t size() const {
+        return std::visit([](const auto& values) { return values.size(); }, storage);
+    }
+
+    // 按4字节元素访问的原始数据指针，供批量编解码内核使用
+    const char* rawData() const {
+        return std::visit([](const auto& values) { return reinterpret_cast<const char*>(values.data()); }, storage);
+    }
+
+    char* rawData() {
+        return std::visit([](auto& values) { return reinterpret_cast<char*>(values.data()); }, storage);
+    }
+
+    template<typename T>
+    bool holds() const {
+        return std::holds_alternative<std::vector<T>>(storage);
+    }
+
+    // 只读视图，不发生拷贝
+    template<typename T>
+    std::span<const T> getSpan() const {
+        return getVectorRef<T>();
+    }
+
+    template<typename T>
+    std::span<T> getMutableSpan() {
+        return getVectorRef<T>();
+    }
+
+    // 移出列数据，之后该列为空
+    template<typename T>
+    std::vector<T> takeValues() {
+        std::vector<T> values = std::move(getVectorRef<T>());
+        storage = std::vector<T>();
+        return values;
+    }
+
+    template<typename T>
+    void setValues(std::vector<T>&& values) {
+        storage = std::move(values);
+    }
+
+private:
+    Storage storage;
+
+    template<typename T>
+    const std::vector<T>& getVectorRef() const {
+        static_assert(std::is_same_v<T, int32_t> || std::is_same_v<T, float>, "Unsupported property column type");
+        const auto* values = std::get_if<std::vector<T>>(&storage);
+        if (values == nullptr) {
+            SPDLOG_ERROR("Property column type mismatch");
+            throw std::runtime_error("Property column type mismatch");
+        }
+        return *values;
+    }
+
+    template<typename T>
+    std::vector<T>& getVectorRef() {
+        return const_cast<std::vector<T>&>(std::as_const(*this).getVectorRef<T>());
+    }
+};
 
 class Element{
 public:
     std::string name;
-    std::unordered_map<std::string, std::vector<PropertyValue>> properties;
+    std::unordered_map<std::string, PropertyColumn> properties;
 
-    const std::vector<PropertyValue>& getPropertyRefWithName(const std::string& propertyName) const {
+    const PropertyColumn& getPropertyRefWithName(const std::string& propertyName) const {
         auto propIt = properties.find(propertyName);
         if (propIt == properties.end()) {
             SPDLOG_ERROR("Property not found: {} in element {}", propertyName, name);
@@ -25,8 +130,12 @@ public:
         return propIt->second;
     }
 
-    void setProperty(const std::string& propertyName, std::vector<PropertyValue>&& values) {
-        properties[propertyName] = values;
+    PropertyColumn& getPropertyRefWithName(const std::string& propertyName) {
+        return const_cast<PropertyColumn&>(std::as_const(*this).getPropertyRefWithName(propertyName));
+    }
+
+    void setProperty(const std::string& propertyName, PropertyColumn&& column) {
+        properties[propertyName] = std::move(column);
     }
 
     void setName(const std::string& elementName) {
@@ -40,56 +149,78 @@ public:
     std::vector<ElementSchema> schemas;
 
     // 安全访问，获得常引用
-    const std::vector<PropertyValue>& getPropertyRefWithName(const std::string& elementName, const std::string& propertyName) const {
-        auto elemIt = elements.find(elementName);
-        if (elemIt == elements.end()) {
-            throw std::runtime_error("Element not found: " + elementName);
-        }
-        
-        return elemIt->second.getPropertyRefWithName(propertyName);
+    const PropertyColumn& getPropertyRefWithName(const std::string& elementName, const std::string& propertyName) const {
+        return getElementRefWithName(elementName).getPropertyRefWithName(propertyName);
     }
 
+    // 零拷贝访问单个属性列
     template <typename T>
-    const std::vector<std::vector<T>> getTypedProperties(const std::string& elementName, const std::vector<std::string>& propertyNames) const {
-        auto elemIt = elements.find(elementName);
-        if (elemIt == elements.end()) {
-            throw std::runtime_error("Element not found: " + elementName);
-        }
+    std::span<const T> getPropertySpan(const std::string& elementName, const std::string& propertyName) const {
+        return getPropertyRefWithName(elementName, propertyName).getSpan<T>();
+    }
+
+    // 拷贝出多个属性列，原数据保持不变
+    template <typename T>
+    std::vector<std::vector<T>> getTypedProperties(const std::string& elementName, const std::vector<std::string>& propertyNames) const {
+        const auto& element = getElementRefWithName(elementName);
 
         std::vector<std::vector<T>> result;
         result.reserve(propertyNames.size());
 
         for (const auto& propName : propertyNames) {
-            const auto& propValues = elemIt->second.getPropertyRefWithName(propName);
-            std::vector<T> typedValues;
-            typedValues.reserve(propValues.size());
+            auto values = element.getPropertyRefWithName(propName).getSpan<T>();
+            result.emplace_back(values.begin(), values.end());
+        }
 
-            for (const auto& val : propValues) {
-                typedValues.push_back(std::get<T>(val));
-            }
+        return result;
+    }
 
-            result.push_back(typedValues);
+    // 移出多个属性列，不发生拷贝；移出后的列为空，需要在写出前通过setProperties放回
+    template <typename T>
+    std::vector<std::vector<T>> takeTypedProperties(const std::string& elementName, const std::vector<std::string>& propertyNames) {
+        auto& element = getElementRefWithName(elementName);
+
+        std::vector<std::vector<T>> result;
+        result.reserve(propertyNames.size());
+
+        for (const auto& propName : propertyNames) {
+            result.push_back(element.getPropertyRefWithName(propName).takeValues<T>());
         }
 
         return result;
     }
 
-    void setProperty(const std::string& elementName, const std::string& propertyName, std::vector<PropertyValue>&& values) {
+    void setProperty(const std::string& elementName, const std::string& propertyName, PropertyColumn&& column) {
         elements[elementName].setName(elementName);
-        elements[elementName].setProperty(propertyName, std::move(values));
+        elements[elementName].setProperty(propertyName, std::move(column));
+    }
+
+    template <typename T>
+    void setProperty(const std::string& elementName,
+                    const std::string& propertyName,
+                    std::vector<T>&& values) {
+        setProperty(elementName, propertyName, PropertyColumn(std::move(values)));
     }
 
     template <typename T>
     void setProperty(const std::string& elementName,
                     const std::string& propertyName,
                     const std::vector<T>& values) {
+        setProperty(elementName, propertyName, std::vector<T>(values));
+    }
 
-        std::vector<PropertyValue> converted;
-        converted.reserve(values.size());
-        for (const T& val : values) {
-            converted.emplace_back(val);
+    // 接管values的所有权，不发生拷贝
+    template<typename T>
+    void setProperties(const std::string& elementName,
+                       const std::vector<std::string>& propertyNames,
+                       std::vector<std::vector<T>>&& values) {
+        if (propertyNames.size() != values.size()) {
+            throw std::runtime_error("Property names and values size mismatch.");
         }
-        setProperty(elementName, propertyName, std::move(converted));
+        for (size_t i = 0; i < propertyNames.size(); ++i) {
+            setProperty(elementName, propertyNames[i], std::move(values[i]));
+        }
+        values.clear();
     }
 
     template<typename T>
@@ -111,9 +242,22 @@ public:
     void printElementInfos() const {
         for (const auto& [elementName, element] : elements) {
             SPDLOG_INFO("Element: {}", elementName);
-            for (const auto& [propertyName, values] : element.properties) {
-                SPDLOG_INFO("  Property: {} ({} values)", propertyName, values.size());
+            for (const auto& [propertyName, column] : element.properties) {
+                SPDLOG_INFO("  Property: {} ({} values)", propertyName, column.size());
             }
         }
     }
-};
\ No newline at end of file
+
+private:
+    const Element& getElementRefWithName(const std::string& elementName) const {
+        auto elemIt = elements.find(elementName);
+        if (elemIt == elements.end()) {
+            throw std::runtime_error("Element not found: " + elementName);
+        }
+        return elemIt->second;
+    }
+
+    Element& getElementRefWithName(const std::string& elementName) {
+        return const_cast<Element&>(std::as_const(*this).getElementRefWithName(elementName));
+    }
+};
@@ -3,7 +3,9 @@
 #include "FileTools.hpp"
 #include "PlySchema.hpp"
 #include "PlyData.hpp"
-#include <functional>
+#include "PlyBinaryCodec.hpp"
+#include "PlyAsciiCodec.hpp"
+#include <sstream>
 #include <tuple>
 #include <mio/mmap.hpp>
 
@@ -15,11 +17,36 @@ public:
         char* end = begin + size;
         setg(begin, begin, end);
     }
+
+protected:
+    // 支持tellg/seekg，用于定位Header之后的数据区
+    pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        char* base = eback();
+        switch (dir) {
+            case std::ios_base::beg: break;
+            case std::ios_base::cur: offset += gptr() - base; break;
+            case std::ios_base::end: offset += egptr() - base; break;
+            default: return pos_type(off_type(-1));
+        }
+        if (offset < 0 || offset > egptr() - base) {
+            return pos_type(off_type(-1));
+        }
+        setg(base, base + offset, egptr());
+        return pos_type(offset);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
 };
 
 class PlyReader{
 
-private:
+public:
+    // 解析Header，结束后file位于数据区起始位置
     static std::tuple<std::vector<ElementSchema>, PlyFormat> parseHeader(std::istream& file){
         std::string line;
         std::vector<ElementSchema> elements;
@@ -72,111 +99,62 @@ private:
         return {elements, format};
     }
 
-    template<PlyFormat Format>
-    static std::function<void(std::istream&, std::vector<PropertyValue>&)> createPropertyParser(PropertyStorageType storageType) {
-        if constexpr (Format == PlyFormat::ASCII) {
-            switch (storageType) {
-                case PropertyStorageType::INT32:
-                    return [](std::istream& is, std::vector<PropertyValue>& output) {
-                        int32_t value;
-                        is >> value;
-                        output.emplace_back(value);
-                    };
-                case PropertyStorageType::FLOAT32:
-                    return [](std::istream& is, std::vector<PropertyValue>& output) {
-                        float value;
-                        is >> value;
-                        output.emplace_back(value);
-                    };
-                default:
-                    throw std::runtime_error("Unsupported storage type for ASCII format");
-            }
-        }
-        else if constexpr (Format == PlyFormat::BINARY_LITTLE_ENDIAN) {
-            switch (storageType) {
-                case PropertyStorageType::INT32:
-                    return [](std::istream& is, std::vector<PropertyValue>& output) {
-                        int32_t value;
-                        is.read(reinterpret_cast<char*>(&value), sizeof(value));
-                        output.emplace_back(value);
-                    };
-                case PropertyStorageType::FLOAT32:
-                    return [](std::istream& is, std::vector<PropertyValue>& output) {
-                        float value;
-                        is.read(reinterpret_cast<char*>(&value), sizeof(value));
-                        output.emplace_back(value);
-                    };
-                default:
-                    throw std::runtime_error("Unsupported storage type for binary format");
-            }
-        }
-        else {
-            static_assert(Format == PlyFormat::ASCII || Format == PlyFormat::BINARY_LITTLE_ENDIAN, 
-                        "Unsupported PlyFormat");
+private:
+
+    // 二进制格式直接在mmap区域上按记录步长批量拆分，不经过istream
+    static std::vector<PropertyColumn> parseBinaryElement(const char* body, size_t availableBytes, const ElementSchema& schema, size_t numThreads) {
+        auto layout = BinaryRecordLayout::fromSchema(schema);
+        const size_t count = static_cast<size_t>(schema.getCount());
+        if (layout.getBodySize(count) > availableBytes) {
+            SPDLOG_ERROR("Truncated binary body for element {}: need {} bytes, got {}", schema.getNameRef(), layout.getBodySize(count), availableBytes);
+            throw std::runtime_error("Truncated binary body for element " + schema.getNameRef());
         }
-    }
 
-    static std::vector<std::function<void(std::istream&, std::vector<PropertyValue>&)>> 
-        buildAllPropertyParsers(const ElementSchema& schema, PlyFormat format) {
-
-        std::vector<std::function<void(std::istream&, std::vector<PropertyValue>&)>> parsers;
-        auto propertyStorageTypes = schema.getPropertyStorageTypes();
-        for(int i = 0; i < schema.getNumberOfProperties(); ++i) {
-            switch (format) {
-                case PlyFormat::ASCII:
-                    parsers.push_back(createPropertyParser<PlyFormat::ASCII>(propertyStorageTypes[i]));
-                    break;
-                case PlyFormat::BINARY_LITTLE_ENDIAN:
-                    parsers.push_back(createPropertyParser<PlyFormat::BINARY_LITTLE_ENDIAN>(propertyStorageTypes[i]));
-                    break;
-                default:
-                    SPDLOG_ERROR("Unsupported PLY format during parser building");
-                    throw std::runtime_error("Unsupported PLY format during parser building");
-            }
+        std::vector<PropertyColumn> elementData;
+        elementData.reserve(schema.getNumberOfProperties());
+        for(auto storageType : schema.getPropertyStorageTypes()) {
+            elementData.push_back(PropertyColumn::create(storageType, count));
         }
 
-        return parsers;
+        PlyBinaryCodec::deinterleaveParallel(body, count, layout, elementData, numThreads);
+        return elementData;
     }
 
-    static std::vector<std::vector<PropertyValue>> parseElement(std::istream& file, const ElementSchema& schema, PlyFormat format) {
-        
-        std::vector<std::vector<PropertyValue>> elementData(schema.getNumberOfProperties());
-        for(int i = 0; i < schema.getNumberOfProperties(); ++i) {
-            elementData[i].reserve(schema.getCount());
-        }
-        auto parsers = buildAllPropertyParsers(schema, format);
-        std::string line;
+    static PlyData parseBinaryBody(const char* body, size_t bodySize, const std::vector<ElementSchema>& schemas, size_t numThreads) {
+        PlyData plyData;
 
-        switch (format) {
-            case PlyFormat::ASCII:
-                for(int i = 0; i < schema.getCount(); ++i) {
-                    std::getline(file, line);
-                    std::istringstream iss(line);
-                    for(int j = 0; j < parsers.size(); ++j) {
-                        parsers[j](iss, elementData[j]);
-                    }
-                }
-                break;
-            case PlyFormat::BINARY_LITTLE_ENDIAN:
-                for(int i = 0; i < schema.getCount(); ++i) {
-                    for(int j = 0; j < parsers.size(); ++j) {
-                        parsers[j](file, elementData[j]);
-                    }
-                }
-                break;
-            default:
-                SPDLOG_ERROR("Unsupported PLY format during element parsing");
-                throw std::runtime_error("Unsupported PLY format during element parsing");
+        for (const auto& schema : schemas) {
+            auto elementData = parseBinaryElement(body, bodySize, schema, numThreads);
+            const size_t elementBytes = schema.getRecordStride() * static_cast<size_t>(schema.getCount());
+            body += elementBytes;
+            bodySize -= elementBytes;
+
+            const auto& propertyNames = schema.getPropertyNames();
+            for (size_t i = 0; i < propertyNames.size(); ++i) {
+                plyData.setProperty(schema.getNameRef(), propertyNames[i], std::move(elementData[i]));
+            }
         }
 
-        return elementData;
+        return plyData;
     }
 
-    static PlyData parseBody(std::istream& file, const std::vector<ElementSchema>& schemas, PlyFormat format){
+    // ASCII格式同样直接在mmap区域上按行并行解析
+    static PlyData parseAsciiBody(const char* body, size_t bodySize, const std::vector<ElementSchema>& schemas, size_t numThreads) {
         PlyData plyData;
+        const char* bodyEnd = body + bodySize;
 
         for (const auto& schema : schemas) {
-            auto elementData = parseElement(file, schema, format);
+            const size_t count = static_cast<size_t>(schema.getCount());
+            const char* elementEnd = PlyAsciiCodec::findElementEnd(body, bodyEnd, count);
+
+            std::vector<PropertyColumn> elementData;
+            elementData.reserve(schema.getNumberOfProperties());
+            for(auto storageType : schema.getPropertyStorageTypes()) {
+                elementData.push_back(PropertyColumn::create(storageType, count));
+            }
+            PlyAsciiCodec::parse(body, elementEnd, count, elementData, numThreads);
+            body = elementEnd;
+
             const auto& propertyNames = schema.getPropertyNames();
             for (size_t i = 0; i < propertyNames.size(); ++i) {
                 plyData.setProperty(schema.getNameRef(), propertyNames[i], std::move(elementData[i]));
@@ -187,7 +165,12 @@ private:
     }
 
 public:
-    static PlyData readDataFromFile(const std::string& filename){
+    /**
+     * @brief 读取PLY文件
+     * @param filename 文件路径
+     * @param numThreads 数据区并行解析的线程数(二进制按记录区间，ASCII按换行切分的块)，0表示使用全部硬件线程
+     */
+    static PlyData readDataFromFile(const std::string& filename, size_t numThreads = 1){
         FileTools::checkFileExists(filename);
         
         // 使用mmap映射文件到内存
@@ -204,7 +187,22 @@ public:
 
         auto [schemas, format] = parseHeader(file);
 
-        auto plyData = parseBody(file, schemas, format);
+        const size_t headerSize = static_cast<size_t>(file.tellg());
+        const char* body = mmap.data() + headerSize;
+        const size_t bodySize = mmap.size() - headerSize;
+
+        PlyData plyData;
+        switch (format) {
+            case PlyFormat::ASCII:
+                plyData = parseAsciiBody(body, bodySize, schemas, numThreads);
+                break;
+            case PlyFormat::BINARY_LITTLE_ENDIAN:
+                plyData = parseBinaryBody(body, bodySize, schemas, numThreads);
+                break;
+            default:
+                SPDLOG_ERROR("Unsupported PLY format during body parsing");
+                throw std::runtime_error("Unsupported PLY format during body parsing");
+        }
         plyData.setSchemas(std::move(schemas));
 
         return plyData;
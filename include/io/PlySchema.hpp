@@ -28,6 +28,26 @@ public:
     void setCurrentHeaderType(const std::string& headerType) {
         currentHeaderType = headerType;
     }
+
+    // 当前Header类型在二进制记录中占用的字节数
+    size_t getHeaderTypeSize() const {
+        return getHeaderTypeSize(currentHeaderType);
+    }
+
+    static size_t getHeaderTypeSize(const std::string& headerType) {
+        if (headerType == "char" || headerType == "uchar" || headerType == "int8" || headerType == "uint8") {
+            return 1;
+        } else if (headerType == "short" || headerType == "ushort" || headerType == "int16" || headerType == "uint16") {
+            return 2;
+        } else if (headerType == "int" || headerType == "uint" || headerType == "int32" || headerType == "uint32"
+                || headerType == "float" || headerType == "float32") {
+            return 4;
+        } else if (headerType == "double" || headerType == "float64") {
+            return 8;
+        }
+        SPDLOG_ERROR("Unsupported PLY header type: {}", headerType);
+        throw std::runtime_error("Unsupported PLY header type: " + headerType);
+    }
 };
 
 class RegisteredSchema{
@@ -122,6 +142,15 @@ public:
         return static_cast<int>(properties.size());
     }
 
+    // 二进制格式下单条记录的字节数
+    size_t getRecordStride() const {
+        size_t stride = 0;
+        for (const auto& property : properties) {
+            stride += property.getHeaderTypeSize();
+        }
+        return stride;
+    }
+
     const std::vector<PropertyStorageType> getPropertyStorageTypes() const {
         std::vector<PropertyStorageType> storageTypes(properties.size());
         for (size_t i = 0; i < properties.size(); ++i) {
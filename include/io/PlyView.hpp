@@ -0,0 +1,183 @@
+#pragma once
+
+#include "FileTools.hpp"
+#include "PlySchema.hpp"
+#include "PlyData.hpp"
+#include "PlyBinaryCodec.hpp"
+#include "PlyReader.hpp"
+#include <cstring>
+#include <span>
+#include <mio/mmap.hpp>
+
+// 在mmap区域上按记录步长访问单个属性的惰性视图，不持有数据
+template<typename T>
+class StridedPropertyView {
+private:
+    const char* base;
+    size_t stride;
+    size_t count;
+
+public:
+    StridedPropertyView(const char* base, size_t stride, size_t count) : base(base), stride(stride), count(count) {}
+
+    size_t size() const {
+        return count;
+    }
+
+    T operator[](size_t index) const {
+        T value;
+        std::memcpy(&value, base + index * stride, sizeof(T));
+        return value;
+    }
+
+    // 将[first, first + output.size())区间的值拷贝到output
+    void copyTo(std::span<T> output, size_t first = 0) const {
+        if (first + output.size() > count) {
+            throw std::out_of_range("StridedPropertyView::copyTo out of range");
+        }
+        const char* src = base + first * stride;
+        for (size_t i = 0; i < output.size(); ++i) {
+            std::memcpy(&output[i], src + i * stride, sizeof(T));
+        }
+    }
+};
+
+// 只解析Header的零拷贝PLY视图，数据区保持映射状态，按需读取部分属性
+// 仅支持binary_little_endian格式，ASCII没有固定的记录步长
+class PlyView {
+private:
+    mio::mmap_source mmap;
+    std::vector<ElementSchema> schemas;
+    std::vector<BinaryRecordLayout> layouts;
+    std::vector<const char*> elementBodies;
+
+    size_t findElementIndex(const std::string& elementName) const {
+        for (size_t i = 0; i < schemas.size(); ++i) {
+            if (schemas[i].getNameRef() == elementName) {
+                return i;
+            }
+        }
+        SPDLOG_ERROR("Element not found: {}", elementName);
+        throw std::runtime_error("Element not found: " + elementName);
+    }
+
+    static size_t findPropertyIndex(const ElementSchema& schema, const std::string& propertyName) {
+        const auto& propertyNames = schema.getPropertyNames();
+        for (size_t i = 0; i < propertyNames.size(); ++i) {
+            if (propertyNames[i] == propertyName) {
+                return i;
+            }
+        }
+        SPDLOG_ERROR("Property not found: {} in element {}", propertyName, schema.getNameRef());
+        throw std::runtime_error("Property not found: " + propertyName + " in element " + schema.getNameRef());
+    }
+
+public:
+    static PlyView open(const std::string& filename) {
+        FileTools::checkFileExists(filename);
+
+        PlyView view;
+        std::error_code error;
+        view.mmap = mio::make_mmap_source(filename, error);
+        if (error) {
+            SPDLOG_ERROR("Failed to mmap file: {}, error: {}", filename, error.message());
+            throw std::runtime_error("Failed to mmap file: " + filename + ", error: " + error.message());
+        }
+
+        MmapStreambuf streambuf(view.mmap.data(), view.mmap.size());
+        std::istream file(&streambuf);
+        auto [schemas, format] = PlyReader::parseHeader(file);
+        if (format != PlyFormat::BINARY_LITTLE_ENDIAN) {
+            SPDLOG_ERROR("PlyView only supports binary_little_endian files: {}", filename);
+            throw std::runtime_error("PlyView only supports binary_little_endian files: " + filename);
+        }
+
+        // 计算各element数据区的起始位置
+        size_t offset = static_cast<size_t>(file.tellg());
+        for (const auto& schema : schemas) {
+            auto layout = BinaryRecordLayout::fromSchema(schema);
+            const size_t bodySize = layout.getBodySize(static_cast<size_t>(schema.getCount()));
+            if (offset + bodySize > view.mmap.size()) {
+                SPDLOG_ERROR("Truncated binary body for element {} in {}", schema.getNameRef(), filename);
+                throw std::runtime_error("Truncated binary body for element " + schema.getNameRef() + " in " + filename);
+            }
+            view.elementBodies.push_back(view.mmap.data() + offset);
+            view.layouts.push_back(std::move(layout));
+            offset += bodySize;
+        }
+        view.schemas = std::move(schemas);
+
+        return view;
+    }
+
+    const std::vector<ElementSchema>& getSchemas() const {
+        return schemas;
+    }
+
+    size_t getCount(const std::string& elementName) const {
+        return static_cast<size_t>(schemas[findElementIndex(elementName)].getCount());
+    }
+
+    // 惰性访问，要求文件中的类型与T的大小和种类一致
+    template<typename T>
+    StridedPropertyView<T> getPropertyView(const std::string& elementName, const std::string& propertyName) const {
+        const size_t elementIndex = findElementIndex(elementName);
+        const auto& layout = layouts[elementIndex];
+        const auto& property = layout.properties[findPropertyIndex(schemas[elementIndex], propertyName)];
+        if (!property.isDirectCopy() || property.storageType != PropertyStorageTraits<T>::storageType) {
+            SPDLOG_ERROR("Property {} cannot be viewed without conversion", propertyName);
+            throw std::runtime_error("Property " + propertyName + " cannot be viewed without conversion");
+        }
+        return StridedPropertyView<T>(elementBodies[elementIndex] + property.offset, layout.stride,
+                                      static_cast<size_t>(schemas[elementIndex].getCount()));
+    }
+
+    // element数据区在映射中的字节范围
+    std::span<const char> getElementBody(const std::string& elementName) const {
+        const size_t elementIndex = findElementIndex(elementName);
+        return {elementBodies[elementIndex], layouts[elementIndex].getBodySize(static_cast<size_t>(schemas[elementIndex].getCount()))};
+    }
+
+    // 按需将部分属性物化为列，只读取这些属性所在的字节；numThreads为0时使用全部硬件线程
+    std::vector<PropertyColumn> materializeColumns(const std::string& elementName, const std::vector<std::string>& propertyNames, size_t numThreads = 1) const {
+        return materializeColumns(elementName, propertyNames, 0, getCount(elementName), numThreads);
+    }
+
+    // 只物化[first, first + count)区间的记录，用于分块读取
+    std::vector<PropertyColumn> materializeColumns(const std::string& elementName, const std::vector<std::string>& propertyNames,
+                                                   size_t first, size_t count, size_t numThreads = 1) const {
+        const size_t elementIndex = findElementIndex(elementName);
+        const auto& schema = schemas[elementIndex];
+        if (first > static_cast<size_t>(schema.getCount()) || count > static_cast<size_t>(schema.getCount()) - first) {
+            SPDLOG_ERROR("Record range [{}, {}) out of element {} with {} records", first, first + count, elementName, schema.getCount());
+            throw std::out_of_range("Record range out of element " + elementName);
+        }
+
+        std::vector<size_t> propertyIndices;
+        std::vector<PropertyColumn> columns;
+        for (const auto& propertyName : propertyNames) {
+            const size_t propertyIndex = findPropertyIndex(schema, propertyName);
+            propertyIndices.push_back(propertyIndex);
+            columns.push_back(PropertyColumn::create(schema.properties[propertyIndex].storageType, count));
+        }
+
+        auto layout = layouts[elementIndex].subset(propertyIndices);
+        PlyBinaryCodec::deinterleaveParallel(elementBodies[elementIndex] + first * layout.stride, count, layout, columns, numThreads);
+        return columns;
+    }
+
+    PropertyColumn materializeColumn(const std::string& elementName, const std::string& propertyName, size_t numThreads = 1) const {
+        return std::move(materializeColumns(elementName, {propertyName}, numThreads).front());
+    }
+
+    template<typename T>
+    std::vector<std::vector<T>> materializeProperties(const std::string& elementName, const std::vector<std::string>& propertyNames, size_t numThreads = 1) const {
+        auto columns = materializeColumns(elementName, propertyNames, numThreads);
+        std::vector<std::vector<T>> result;
+        result.reserve(columns.size());
+        for (auto& column : columns) {
+            result.push_back(column.takeValues<T>());
+        }
+        return result;
+    }
+};
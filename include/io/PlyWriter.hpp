@@ -3,17 +3,65 @@
 #include "FileTools.hpp"
 #include "PlySchema.hpp"
 #include "PlyData.hpp"
+#include "PlyAsciiCodec.hpp"
+#include "PlyBinaryCodec.hpp"
+#include <filesystem>
 #include <fstream>
-#include <functional>
+#include <sstream>
 #include <unordered_set>
+#include <mio/mmap.hpp>
 #include <spdlog/spdlog.h>
 
 class PlyWriter {
 
 private:
-    static void writeHeader(std::ofstream& file, const PlyData& plyData, PlyFormat format) {
+    // 一个element中实际写出的属性
+    struct ElementSelection {
+        const ElementSchema* schema;
+        std::vector<PropertySchema> properties;
+        std::vector<const PropertyColumn*> columns;
+    };
+
+    // 获取列引用并检查其长度与类型是否与schema一致
+    static const PropertyColumn& getCheckedColumn(const PlyData& plyData, const ElementSchema& schema, const PropertySchema& property) {
+        const auto& column = plyData.getPropertyRefWithName(schema.getNameRef(), property.propertyName);
+        if (column.size() != static_cast<size_t>(schema.getCount())) {
+            SPDLOG_ERROR("Property {} has {} values, expected {}", property.propertyName, column.size(), schema.getCount());
+            throw std::runtime_error("Property size mismatch when writing: " + property.propertyName);
+        }
+        if (column.getStorageType() != property.storageType) {
+            SPDLOG_ERROR("Property {} storage type does not match its schema", property.propertyName);
+            throw std::runtime_error("Property storage type mismatch when writing: " + property.propertyName);
+        }
+        return column;
+    }
+
+    // 筛选需要写出的属性，propertyMasks为空指针时写出全部属性；没有任何属性被选中的element不写出
+    static std::vector<ElementSelection> selectProperties(const PlyData& plyData, const std::vector<std::string>* propertyMasks) {
+        std::unordered_set<std::string> maskSet;
+        if (propertyMasks != nullptr) {
+            maskSet.insert(propertyMasks->begin(), propertyMasks->end());
+        }
+
+        std::vector<ElementSelection> selections;
+        for (const auto& schema : plyData.schemas) {
+            ElementSelection selection{&schema, {}, {}};
+            for (const auto& property : schema.properties) {
+                if (propertyMasks == nullptr || maskSet.find(property.propertyName) != maskSet.end()) {
+                    selection.properties.push_back(property);
+                    selection.columns.push_back(&getCheckedColumn(plyData, schema, property));
+                }
+            }
+            if (propertyMasks == nullptr || !selection.properties.empty()) {
+                selections.push_back(std::move(selection));
+            }
+        }
+        return selections;
+    }
+
+    static void writeHeader(std::ostream& file, const std::vector<ElementSelection>& selections, PlyFormat format) {
         file << "ply\n";
-        
+
         switch (format) {
             case PlyFormat::ASCII:
                 file << "format ascii 1.0\n";
@@ -26,9 +74,9 @@ private:
                 throw std::runtime_error("Unsupported PLY format for writing");
         }
 
-        for (const auto& schema : plyData.schemas) {
-            file << "element " << schema.getNameRef() << " " << schema.getCount() << "\n";
-            for (const auto& property : schema.properties) {
+        for (const auto& selection : selections) {
+            file << "element " << selection.schema->getNameRef() << " " << selection.schema->getCount() << "\n";
+            for (const auto& property : selection.properties) {
                 file << "property " << property.currentHeaderType << " " << property.propertyName << "\n";
             }
         }
@@ -36,243 +84,104 @@ private:
         file << "end_header\n";
     }
 
-    template<PlyFormat Format>
-    static std::function<void(std::ostream&, const PropertyValue&)> createPropertyWriter(PropertyStorageType storageType) {
-        if constexpr (Format == PlyFormat::ASCII) {
-            switch (storageType) {
-                case PropertyStorageType::INT32:
-                    return [](std::ostream& os, const PropertyValue& value) {
-                        os << std::get<int32_t>(value);
-                    };
-                case PropertyStorageType::FLOAT32:
-                    return [](std::ostream& os, const PropertyValue& value) {
-                        os << std::get<float>(value);
-                    };
-                default:
-                    throw std::runtime_error("Unsupported storage type for ASCII format");
-            }
-        }
-        else if constexpr (Format == PlyFormat::BINARY_LITTLE_ENDIAN) {
-            switch (storageType) {
-                case PropertyStorageType::INT32:
-                    return [](std::ostream& os, const PropertyValue& value) {
-                        int32_t v = std::get<int32_t>(value);
-                        os.write(reinterpret_cast<const char*>(&v), sizeof(v));
-                    };
-                case PropertyStorageType::FLOAT32:
-                    return [](std::ostream& os, const PropertyValue& value) {
-                        float v = std::get<float>(value);
-                        os.write(reinterpret_cast<const char*>(&v), sizeof(v));
-                    };
-                default:
-                    throw std::runtime_error("Unsupported storage type for binary format");
-            }
-        }
-        else {
-            static_assert(Format == PlyFormat::ASCII || Format == PlyFormat::BINARY_LITTLE_ENDIAN,
-                        "Unsupported PlyFormat");
+    static void writeAsciiFile(const std::string& filename, const std::vector<ElementSelection>& selections, size_t numThreads) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            SPDLOG_ERROR("Failed to open file for writing: {}", filename);
+            throw std::runtime_error("Failed to open file for writing: " + filename);
         }
-    }
-
-    static std::vector<std::function<void(std::ostream&, const PropertyValue&)>>
-        buildAllPropertyWriters(const ElementSchema& schema, PlyFormat format) {
 
-        std::vector<std::function<void(std::ostream&, const PropertyValue&)>> writers;
-        auto propertyStorageTypes = schema.getPropertyStorageTypes();
-        for (int i = 0; i < schema.getNumberOfProperties(); ++i) {
-            switch (format) {
-                case PlyFormat::ASCII:
-                    writers.push_back(createPropertyWriter<PlyFormat::ASCII>(propertyStorageTypes[i]));
-                    break;
-                case PlyFormat::BINARY_LITTLE_ENDIAN:
-                    writers.push_back(createPropertyWriter<PlyFormat::BINARY_LITTLE_ENDIAN>(propertyStorageTypes[i]));
-                    break;
-                default:
-                    SPDLOG_ERROR("Unsupported PLY format during writer building");
-                    throw std::runtime_error("Unsupported PLY format during writer building");
-            }
+        writeHeader(file, selections, PlyFormat::ASCII);
+        for (const auto& selection : selections) {
+            PlyAsciiCodec::write(file, selection.columns, static_cast<size_t>(selection.schema->getCount()), numThreads);
         }
 
-        return writers;
+        file.close();
     }
 
-    static void writeElement(std::ofstream& file, const PlyData& plyData, const ElementSchema& schema, PlyFormat format) {
-        auto writers = buildAllPropertyWriters(schema, format);
-        const auto& propertyNames = schema.getPropertyNames();
-        const auto& elementName = schema.getNameRef();
-
-        // 获取所有属性数据的引用
-        std::vector<const std::vector<PropertyValue>*> propertyDataRefs;
-        for (const auto& propName : propertyNames) {
-            propertyDataRefs.push_back(&plyData.getPropertyRefWithName(elementName, propName));
-        }
-
-        switch (format) {
-            case PlyFormat::ASCII:
-                for (int i = 0; i < schema.getCount(); ++i) {
-                    for (size_t j = 0; j < writers.size(); ++j) {
-                        if (j > 0) file << " ";
-                        writers[j](file, (*propertyDataRefs[j])[i]);
-                    }
-                    file << "\n";
-                }
-                break;
-            case PlyFormat::BINARY_LITTLE_ENDIAN:
-                for (int i = 0; i < schema.getCount(); ++i) {
-                    for (size_t j = 0; j < writers.size(); ++j) {
-                        writers[j](file, (*propertyDataRefs[j])[i]);
-                    }
-                }
-                break;
-            default:
-                SPDLOG_ERROR("Unsupported PLY format during element writing");
-                throw std::runtime_error("Unsupported PLY format during element writing");
+    // 二进制格式的输出大小可以由Header和记录步长精确算出：
+    // 先写Header并将文件扩展到最终大小，再映射到内存，由多个线程将各列直接交织写入映射区
+    static void writeBinaryFile(const std::string& filename, const std::vector<ElementSelection>& selections, size_t numThreads) {
+        std::ostringstream header;
+        writeHeader(header, selections, PlyFormat::BINARY_LITTLE_ENDIAN);
+        const std::string headerString = header.str();
+
+        std::vector<BinaryRecordLayout> layouts;
+        size_t totalSize = headerString.size();
+        for (const auto& selection : selections) {
+            layouts.push_back(BinaryRecordLayout::fromProperties(selection.properties));
+            totalSize += layouts.back().getBodySize(static_cast<size_t>(selection.schema->getCount()));
+        }
+
+        {
+            std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                SPDLOG_ERROR("Failed to open file for writing: {}", filename);
+                throw std::runtime_error("Failed to open file for writing: " + filename);
+            }
+            file.write(headerString.data(), static_cast<std::streamsize>(headerString.size()));
         }
-    }
-
-    static void writeBody(std::ofstream& file, const PlyData& plyData, PlyFormat format) {
-        for (const auto& schema : plyData.schemas) {
-            writeElement(file, plyData, schema, format);
+        if (totalSize == headerString.size()) {
+            return;
         }
-    }
 
-    static void writeHeaderWithPropertyMasks(std::ofstream& file, const PlyData& plyData, PlyFormat format, const std::vector<std::string>& propertyMasks) {
-        file << "ply\n";
-        
-        switch (format) {
-            case PlyFormat::ASCII:
-                file << "format ascii 1.0\n";
-                break;
-            case PlyFormat::BINARY_LITTLE_ENDIAN:
-                file << "format binary_little_endian 1.0\n";
-                break;
-            default:
-                SPDLOG_ERROR("Unsupported PLY format for writing");
-                throw std::runtime_error("Unsupported PLY format for writing");
+        std::error_code error;
+        std::filesystem::resize_file(filename, totalSize, error);
+        if (error) {
+            SPDLOG_ERROR("Failed to resize file: {}, error: {}", filename, error.message());
+            throw std::runtime_error("Failed to resize file: " + filename + ", error: " + error.message());
         }
 
-        // 将propertyMasks转换为unordered_set以便快速查找
-        std::unordered_set<std::string> maskSet(propertyMasks.begin(), propertyMasks.end());
-
-        for (const auto& schema : plyData.schemas) {
-            // 统计有多少属性在mask中
-            int validPropertyCount = 0;
-            for (const auto& property : schema.properties) {
-                if (maskSet.find(property.propertyName) != maskSet.end()) {
-                    validPropertyCount++;
-                }
-            }
-
-            // 只有当至少有一个属性在mask中时才写入element
-            if (validPropertyCount > 0) {
-                file << "element " << schema.getNameRef() << " " << schema.getCount() << "\n";
-                for (const auto& property : schema.properties) {
-                    if (maskSet.find(property.propertyName) != maskSet.end()) {
-                        file << "property " << property.currentHeaderType << " " << property.propertyName << "\n";
-                    }
-                }
-            }
+        mio::mmap_sink mmap = mio::make_mmap_sink(filename, error);
+        if (error) {
+            SPDLOG_ERROR("Failed to mmap file for writing: {}, error: {}", filename, error.message());
+            throw std::runtime_error("Failed to mmap file for writing: " + filename + ", error: " + error.message());
         }
 
-        file << "end_header\n";
-    }
-
-    static void writeElementWithPropertyMasks(std::ofstream& file, const PlyData& plyData, const ElementSchema& schema, PlyFormat format, const std::vector<std::string>& propertyMasks) {
-        // 将propertyMasks转换为unordered_set以便快速查找
-        std::unordered_set<std::string> maskSet(propertyMasks.begin(), propertyMasks.end());
-
-        const auto& propertyNames = schema.getPropertyNames();
-        const auto& elementName = schema.getNameRef();
-
-        // 筛选出在mask中的属性
-        std::vector<int> validPropertyIndices;
-        std::vector<std::function<void(std::ostream&, const PropertyValue&)>> writers;
-        std::vector<const std::vector<PropertyValue>*> propertyDataRefs;
-
-        auto propertyStorageTypes = schema.getPropertyStorageTypes();
-        for (size_t i = 0; i < propertyNames.size(); ++i) {
-            if (maskSet.find(propertyNames[i]) != maskSet.end()) {
-                validPropertyIndices.push_back(i);
-                
-                // 创建对应的writer
-                switch (format) {
-                    case PlyFormat::ASCII:
-                        writers.push_back(createPropertyWriter<PlyFormat::ASCII>(propertyStorageTypes[i]));
-                        break;
-                    case PlyFormat::BINARY_LITTLE_ENDIAN:
-                        writers.push_back(createPropertyWriter<PlyFormat::BINARY_LITTLE_ENDIAN>(propertyStorageTypes[i]));
-                        break;
-                    default:
-                        SPDLOG_ERROR("Unsupported PLY format during writer building");
-                        throw std::runtime_error("Unsupported PLY format during writer building");
-                }
-
-                propertyDataRefs.push_back(&plyData.getPropertyRefWithName(elementName, propertyNames[i]));
-            }
+        char* body = mmap.data() + headerString.size();
+        for (size_t i = 0; i < selections.size(); ++i) {
+            const size_t count = static_cast<size_t>(selections[i].schema->getCount());
+            PlyBinaryCodec::interleaveParallel(selections[i].columns, count, layouts[i], body, numThreads);
+            body += layouts[i].getBodySize(count);
         }
 
-        // 如果没有有效属性，直接返回
-        if (validPropertyIndices.empty()) {
-            return;
+        mmap.sync(error);
+        if (error) {
+            SPDLOG_ERROR("Failed to flush file: {}, error: {}", filename, error.message());
+            throw std::runtime_error("Failed to flush file: " + filename + ", error: " + error.message());
         }
+    }
 
+    static void writeSelections(const std::string& filename, const std::vector<ElementSelection>& selections, PlyFormat format, size_t numThreads) {
         switch (format) {
             case PlyFormat::ASCII:
-                for (int i = 0; i < schema.getCount(); ++i) {
-                    for (size_t j = 0; j < writers.size(); ++j) {
-                        if (j > 0) file << " ";
-                        writers[j](file, (*propertyDataRefs[j])[i]);
-                    }
-                    file << "\n";
-                }
+                writeAsciiFile(filename, selections, numThreads);
                 break;
             case PlyFormat::BINARY_LITTLE_ENDIAN:
-                for (int i = 0; i < schema.getCount(); ++i) {
-                    for (size_t j = 0; j < writers.size(); ++j) {
-                        writers[j](file, (*propertyDataRefs[j])[i]);
-                    }
-                }
+                writeBinaryFile(filename, selections, numThreads);
                 break;
             default:
-                SPDLOG_ERROR("Unsupported PLY format during element writing");
-                throw std::runtime_error("Unsupported PLY format during element writing");
-        }
-    }
-
-    static void writeBodyWithPropertyMasks(std::ofstream& file, const PlyData& plyData, PlyFormat format, const std::vector<std::string>& propertyMasks) {
-        for (const auto& schema : plyData.schemas) {
-            writeElementWithPropertyMasks(file, plyData, schema, format, propertyMasks);
+                SPDLOG_ERROR("Unsupported PLY format for writing");
+                throw std::runtime_error("Unsupported PLY format for writing");
         }
     }
 
 public:
-    static void writeDataToFile(const std::string& filename, const PlyData& plyData, PlyFormat format = PlyFormat::BINARY_LITTLE_ENDIAN) {
+    /**
+     * @brief 写出PLY文件
+     * @param numThreads 并行交织/格式化的线程数，0表示使用全部硬件线程
+     */
+    static void writeDataToFile(const std::string& filename, const PlyData& plyData, PlyFormat format = PlyFormat::BINARY_LITTLE_ENDIAN, size_t numThreads = 1) {
         FileTools::checkAndCreateDir(filename);
-
-        std::ofstream file(filename, std::ios::binary);
-        if (!file.is_open()) {
-            SPDLOG_ERROR("Failed to open file for writing: {}", filename);
-            throw std::runtime_error("Failed to open file for writing: " + filename);
-        }
-
-        writeHeader(file, plyData, format);
-        writeBody(file, plyData, format);
-
-        file.close();
+        writeSelections(filename, selectProperties(plyData, nullptr), format, numThreads);
     }
 
-    static void writeDataToFileWithPropertyMasks(const std::string& filename, const PlyData& plyData, const std::vector<std::string>& propertyMasks, PlyFormat format = PlyFormat::BINARY_LITTLE_ENDIAN) {
+    /**
+     * @brief 只写出propertyMasks中列出的属性
+     * @param numThreads 并行交织/格式化的线程数，0表示使用全部硬件线程
+     */
+    static void writeDataToFileWithPropertyMasks(const std::string& filename, const PlyData& plyData, const std::vector<std::string>& propertyMasks, PlyFormat format = PlyFormat::BINARY_LITTLE_ENDIAN, size_t numThreads = 1) {
         FileTools::checkAndCreateDir(filename);
-
-        std::ofstream file(filename, std::ios::binary);
-        if (!file.is_open()) {
-            SPDLOG_ERROR("Failed to open file for writing: {}", filename);
-            throw std::runtime_error("Failed to open file for writing: " + filename);
-        }
-
-        writeHeaderWithPropertyMasks(file, plyData, format, propertyMasks);
-        writeBodyWithPropertyMasks(file, plyData, format, propertyMasks);
-
-        file.close();
+        writeSelections(filename, selectProperties(plyData, &propertyMasks), format, numThreads);
     }
 };
@@ -0,0 +1,386 @@
+#pragma once
+
+#include "io/PlyData.hpp"
+#include "io/PlyChunkReader.hpp"
+#include "codec/SpaceFillingCurve.hpp"
+#include "codec/Transform.hpp"
+#include "codec/Quantization.hpp"
+#include "codec/OctreeCoder.hpp"
+#include "codec/AttributeCoder.hpp"
+#include "codec/QuaternionCoder.hpp"
+#include "codec/PositionPreprocessor.hpp"
+#include "codec/TemporalCoder.hpp"
+#include "codec/ProgressiveCoder.hpp"
+#include "codec/TileCoder.hpp"
+#include "codec/BlockQuantizer.hpp"
+#include "codec/RateController.hpp"
+#include "codec/SequenceContainer.hpp"
+#include "utils/ExternalSorter.hpp"
+#include "utils/Parallel.hpp"
+#include "utils/RadixSort.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 帧编码的参数，各编码模式只使用与自己相关的部分
+struct FrameEncoderSettings {
+    // 几何量化位深，可在1~16之间调整
+    int positionBitDepth = 16;
+    std::vector<std::string> positionNames;
+    std::vector<std::string> attributeNames;
+    std::vector<std::string> rotationNames;
+    // 与attributeNames一一对应的量化设置
+    std::vector<AttributeQuantization> attributeQuantization;
+    // 帧间编码模式下的关键帧间隔
+    size_t keyframeInterval = 30;
+    // 渐进式编码模式下统计预览质量所用的码流前缀比例
+    double previewByteFraction = 0.05;
+    // 分块编码模式下每帧的块数
+    size_t tilesPerFrame = 16;
+    // 分块量化模式：全局网格位深决定最大几何误差，每块的最大点数
+    int blockGridBitDepth = 18;
+    size_t blockSplats = 4096;
+    // 码率控制模式的目标与搜索范围，字节预算针对整个帧负载
+    RateTarget rateTarget;
+    RateControlSettings rateControl;
+    // 静态场景模式：每次流式读取的点数、外存排序的内存预算、每个编码块的点数
+    size_t sceneChunkSplats = 1 << 20;
+    size_t sceneSortMemory = size_t{1} << 30;
+    size_t sceneBlockSplats = 1 << 20;
+    // 每帧内部使用的线程数
+    size_t threads = 1;
+};
+
+// 单帧在流水线各阶段之间传递的状态
+struct FrameContext {
+    size_t frameIndex = 0;
+    std::filesystem::path filePath;
+    SpaceFillingCurve positionOrder = SpaceFillingCurve::MORTON;
+    // 编码后存放解码重建的结果
+    PlyData data;
+    std::vector<std::vector<float>> positions;
+    std::vector<std::vector<float>> attributes;
+    std::vector<std::vector<float>> rotations;
+    std::optional<BoundingBox3D> bbox;
+    std::vector<std::vector<uint16_t>> quantizedPositions;
+    std::vector<uint64_t> curveKeys;
+    std::vector<uint32_t> curveIndices;
+};
+
+/**
+ * @brief 各编码模式的单帧编码阶段：编码一帧写入序列容器，并把解码重建的结果放入frame.data
+ *
+ * 帧内类模式的阶段互不依赖，可以在多帧流水线中并行执行；帧间模式持有编解码状态，
+ * encodeTemporalFrame须按帧序号逐帧调用。一个实例对应一个序列。
+ */
+class FrameEncoder {
+private:
+    FrameEncoderSettings settings;
+    TemporalEncoder temporalEncoder;
+    TemporalDecoder temporalDecoder;
+
+    void setReconstruction(FrameContext& frame, std::vector<std::vector<float>>&& positions, std::vector<std::vector<float>>&& attributes,
+                           std::vector<std::vector<float>>&& rotations) const {
+        frame.data.setProperties("vertex", settings.positionNames, std::move(positions));
+        frame.data.setProperties("vertex", settings.attributeNames, std::move(attributes));
+        frame.data.setProperties("vertex", settings.rotationNames, std::move(rotations));
+    }
+
+    // 对数域量化坐标反量化后做逆变换，逆变换会改写包围盒，因此使用副本
+    std::vector<std::vector<float>> reconstructPositions(const std::vector<std::vector<uint16_t>>& quantized, const BoundingBox3D& bbox,
+                                                         int bitDepth, size_t threads) const {
+        auto positions = Quantization::dequantizePositionWithBBox<float, uint16_t>(quantized, bbox, bitDepth, threads);
+        auto inverseBBox = bbox;
+        Transform::inverseLogTransformInPlace(positions, inverseBBox, threads);
+        return positions;
+    }
+
+public:
+    // temporalThreads：帧间模式逐帧串行，帧内并行使用的线程数，0表示使用全部硬件线程
+    FrameEncoder(FrameEncoderSettings settings, SpaceFillingCurve positionOrder, size_t temporalThreads = 0)
+        : settings(std::move(settings)),
+          temporalEncoder({this->settings.positionBitDepth, positionOrder, this->settings.attributeQuantization, this->settings.keyframeInterval},
+                          temporalThreads),
+          temporalDecoder(temporalThreads) {}
+
+    const FrameEncoderSettings& getSettings() const {
+        return settings;
+    }
+
+    /**
+     * @brief 编码模式对应的序列元数据
+     */
+    SequenceMetadata getMetadata(SequenceCoding coding, SpaceFillingCurve positionOrder) const {
+        // 分块模式的各块在blockGridBitDepth位的全局网格上量化，元数据记录的是该网格位深
+        return {coding, coding == SequenceCoding::BLOCKED ? settings.blockGridBitDepth : settings.positionBitDepth, positionOrder,
+                coding == SequenceCoding::TEMPORAL ? static_cast<uint32_t>(settings.keyframeInterval) : 1u,
+                settings.positionNames, settings.attributeNames, settings.rotationNames, settings.attributeQuantization};
+    }
+
+    // 变换量化，同时计算曲线排序键
+    void preprocessFrame(FrameContext& frame) const {
+        auto preprocessed = PositionPreprocessor::process<uint16_t>(frame.positions, settings.positionBitDepth, settings.threads, frame.positionOrder);
+        frame.positions.clear();
+        frame.bbox = preprocessed.bbox;
+        frame.quantizedPositions = std::move(preprocessed.quantizedPositions);
+        frame.curveKeys = std::move(preprocessed.curveKeys);
+        frame.curveIndices = std::move(preprocessed.indices);
+    }
+
+    // 按曲线顺序对量化后的数据重排
+    void reorderFrame(FrameContext& frame) const {
+        RadixSort::sortPairs(frame.curveKeys, frame.curveIndices, settings.threads);
+        Transform::reorderColumnsInPlace(frame.curveIndices, settings.threads, frame.quantizedPositions, frame.attributes, frame.rotations);
+        frame.curveKeys.clear();
+        frame.curveIndices.clear();
+    }
+
+    // 编码几何信息并解码重建，须先经过preprocessFrame与reorderFrame
+    void encodeFrame(FrameContext& frame, SequenceWriter& writer) const {
+        const auto& filePath = frame.filePath;
+        const size_t threads = settings.threads;
+
+        // 八叉树编码几何信息
+        auto geometryBitstream = OctreeCoder::encode(frame.quantizedPositions, settings.positionBitDepth, frame.positionOrder);
+        SPDLOG_INFO("Frame {} geometry: {} bytes, {:.3f} bpp", filePath.filename().string(), geometryBitstream.size(),
+                    geometryBitstream.size() * 8.0 / frame.quantizedPositions[0].size());
+
+        // 编码属性信息，属性已按曲线顺序排列
+        auto attributeBitstream = AttributeCoder::encode(frame.attributes, settings.attributeQuantization, threads);
+        auto rotationBitstream = QuaternionCoder::encode(frame.rotations, threads);
+        SPDLOG_INFO("Frame {} attributes: {} bytes, rotations: {} bytes, {:.3f} bytes per splat in total", filePath.filename().string(),
+                    attributeBitstream.size(), rotationBitstream.size(),
+                    static_cast<double>(geometryBitstream.size() + attributeBitstream.size() + rotationBitstream.size()) / frame.quantizedPositions[0].size());
+
+        // 解码几何信息，解码结果保持曲线顺序，与重排后的属性一一对应
+        auto dequantizedPositions = reconstructPositions(OctreeCoder::decode<uint16_t>(geometryBitstream), *frame.bbox, settings.positionBitDepth, threads);
+
+        // 量化包围盒与三个码流打包为一帧写入序列容器，每帧可独立解码，帧可以乱序完成
+        writer.writeFrame(frame.frameIndex, SequenceContainer::packSections({SequenceContainer::packBBox(*frame.bbox), geometryBitstream, attributeBitstream, rotationBitstream}),
+                          frame.quantizedPositions[0].size(), true, BoundingBox3D::calculateFromPoints(dequantizedPositions, threads));
+
+        setReconstruction(frame, std::move(dequantizedPositions), AttributeCoder::decode(attributeBitstream, threads),
+                          QuaternionCoder::decode(rotationBitstream, threads));
+        frame.attributes.clear();
+        frame.rotations.clear();
+        frame.quantizedPositions.clear();
+    }
+
+    // 渐进式编码并解码重建，同时统计码流前缀可解码出的预览；须先经过preprocessFrame与reorderFrame
+    void encodeProgressiveFrame(FrameContext& frame, SequenceWriter& writer) const {
+        const auto& filePath = frame.filePath;
+        const size_t threads = settings.threads;
+        const size_t pointCount = frame.quantizedPositions[0].size();
+        auto bitstream = ProgressiveCoder::encode(frame.quantizedPositions, settings.positionBitDepth, frame.positionOrder,
+                                                  frame.attributes, settings.attributeQuantization, frame.rotations, threads);
+        frame.attributes.clear();
+        frame.rotations.clear();
+        frame.quantizedPositions.clear();
+
+        // 只收到前缀时解码出预算内能完整解码的最细层级
+        const size_t previewBudget = static_cast<size_t>(bitstream.size() * settings.previewByteFraction);
+        const int levelCount = ProgressiveCoder::getLevelCount(bitstream.data(), bitstream.size());
+        if (ProgressiveCoder::getPrefixSize(bitstream.data(), bitstream.size(), 0) <= previewBudget) {
+            auto preview = ProgressiveCoder::decode<uint16_t>(bitstream.data(), previewBudget, INT_MAX, threads);
+            SPDLOG_INFO("Frame {} progressive: {} bytes, {:.3f} bytes per splat; first {:.0f}% decodes level {}/{} with {} of {} splats",
+                        filePath.filename().string(), bitstream.size(), static_cast<double>(bitstream.size()) / pointCount,
+                        settings.previewByteFraction * 100, preview.level, levelCount - 1, preview.positions[0].size(), pointCount);
+        }
+
+        // 完整解码，结果保持曲线顺序
+        auto decoded = ProgressiveCoder::decode<uint16_t>(bitstream, INT_MAX, threads);
+        auto dequantizedPositions = reconstructPositions(decoded.positions, *frame.bbox, settings.positionBitDepth, threads);
+
+        // 量化包围盒放在码流之前，负载的前缀即可解码预览
+        writer.writeFrame(frame.frameIndex, SequenceContainer::packSections({SequenceContainer::packBBox(*frame.bbox), bitstream}), pointCount, true,
+                          BoundingBox3D::calculateFromPoints(dequantizedPositions, threads));
+
+        setReconstruction(frame, std::move(dequantizedPositions), std::move(decoded.attributes), std::move(decoded.rotations));
+    }
+
+    // 分块编码并解码重建，块的编码与解码都按块并行，分块内部自行量化与排序
+    void encodeTiledFrame(FrameContext& frame, SequenceWriter& writer) const {
+        const auto& filePath = frame.filePath;
+        const size_t threads = settings.threads;
+        const size_t pointCount = frame.positions[0].size();
+        auto bitstream = TileCoder::encode(frame.positions, frame.attributes, frame.rotations,
+                                           {settings.positionBitDepth, frame.positionOrder, settings.attributeQuantization, settings.tilesPerFrame}, threads);
+        SPDLOG_INFO("Frame {} tiled: {} tiles, {} bytes, {:.3f} bytes per splat", filePath.filename().string(),
+                    TileCoder::getTileCount(bitstream.data(), bitstream.size()), bitstream.size(), static_cast<double>(bitstream.size()) / pointCount);
+        frame.positions.clear();
+        frame.attributes.clear();
+        frame.rotations.clear();
+
+        auto decoded = TileCoder::decode(bitstream, threads);
+        writer.writeFrame(frame.frameIndex, bitstream, pointCount, true, BoundingBox3D::calculateFromPoints(decoded.positions, threads));
+        setReconstruction(frame, std::move(decoded.positions), std::move(decoded.attributes), std::move(decoded.rotations));
+    }
+
+    // 分块自适应量化编码并解码重建，块内点序由量化器决定，属性随之重排
+    void encodeBlockedFrame(FrameContext& frame, SequenceWriter& writer) const {
+        const auto& filePath = frame.filePath;
+        const size_t threads = settings.threads;
+        const size_t pointCount = frame.positions[0].size();
+        auto quantized = BlockQuantizer::quantize(frame.positions, settings.blockGridBitDepth, settings.blockSplats, 0.0f, threads, frame.positionOrder);
+        frame.positions.clear();
+        Transform::reorderColumnsInPlace(quantized.order, threads, frame.attributes, frame.rotations);
+
+        auto geometryBitstream = BlockQuantizer::encode(quantized, frame.positionOrder, threads);
+        auto attributeBitstream = AttributeCoder::encode(frame.attributes, settings.attributeQuantization, threads);
+        auto rotationBitstream = QuaternionCoder::encode(frame.rotations, threads);
+        SPDLOG_INFO("Frame {} blocked: {} blocks, geometry {} bytes ({:.3f} bpp), {:.3f} bytes per splat in total", filePath.filename().string(),
+                    quantized.blocks.size(), geometryBitstream.size(), geometryBitstream.size() * 8.0 / pointCount,
+                    static_cast<double>(geometryBitstream.size() + attributeBitstream.size() + rotationBitstream.size()) / pointCount);
+        frame.attributes.clear();
+        frame.rotations.clear();
+
+        auto decodedPositions = BlockQuantizer::dequantize(BlockQuantizer::decode(geometryBitstream, threads), threads);
+        writer.writeFrame(frame.frameIndex, SequenceContainer::packSections({geometryBitstream, attributeBitstream, rotationBitstream}),
+                          pointCount, true, BoundingBox3D::calculateFromPoints(decodedPositions, threads));
+        setReconstruction(frame, std::move(decodedPositions), AttributeCoder::decode(attributeBitstream, threads),
+                          QuaternionCoder::decode(rotationBitstream, threads));
+    }
+
+    // 码率控制编码并解码重建：量化与排序只做一次，各试验点复用排序后的结果
+    void encodeRateControlledFrame(FrameContext& frame, SequenceWriter& writer) const {
+        const auto& filePath = frame.filePath;
+        const size_t threads = settings.threads;
+        const size_t pointCount = frame.positions[0].size();
+        auto preprocessed = PositionPreprocessor::process<uint16_t>(frame.positions, settings.positionBitDepth, threads, frame.positionOrder);
+        RadixSort::sortPairs(preprocessed.curveKeys, preprocessed.indices, threads);
+        // 原始坐标随之重排，用于度量几何误差
+        Transform::reorderColumnsInPlace(preprocessed.indices, threads, frame.positions, preprocessed.quantizedPositions,
+                                         frame.attributes, frame.rotations);
+
+        // 字节预算针对整个帧负载，扣除分段头与包围盒分段后才是三个码流可用的字节数；预算不足时仍按最小码流编码
+        const size_t payloadOverhead = SequenceContainer::sectionsOverhead(4) + SequenceContainer::BBoxSectionSize;
+        RateTarget streamTarget = settings.rateTarget;
+        if (streamTarget.maxBytes > 0) {
+            streamTarget.maxBytes = streamTarget.maxBytes > payloadOverhead ? streamTarget.maxBytes - payloadOverhead : 1;
+        }
+        auto coded = RateController::encode(frame.positions, preprocessed.quantizedPositions, preprocessed.bbox, settings.positionBitDepth,
+                                            frame.positionOrder, frame.attributes, settings.attributeQuantization, frame.rotations,
+                                            streamTarget, settings.rateControl, threads);
+        const auto& point = coded.point;
+        // 每帧位深不同，量化包围盒随帧写出，几何与属性码流各自记录位深
+        auto payload = SequenceContainer::packSections({SequenceContainer::packBBox(coded.bbox), coded.geometry, coded.attributes, coded.rotations});
+        SPDLOG_INFO("Frame {} rate control: {} position bits, attribute bits -{}, {} bytes ({:.3f} bytes per splat), PSNR {:.2f} dB (positions) / {:.2f} dB (attributes)",
+                    filePath.filename().string(), point.positionBitDepth, point.attributeBitReduction, payload.size(),
+                    static_cast<double>(payload.size()) / pointCount, point.positionPsnr, point.attributePsnr);
+        frame.positions.clear();
+        frame.attributes.clear();
+        frame.rotations.clear();
+
+        // 解码结果保持曲线顺序
+        auto dequantizedPositions = reconstructPositions(OctreeCoder::decode<uint16_t>(coded.geometry), coded.bbox, point.positionBitDepth, threads);
+        writer.writeFrame(frame.frameIndex, payload, pointCount, true, BoundingBox3D::calculateFromPoints(dequantizedPositions, threads));
+        setReconstruction(frame, std::move(dequantizedPositions), AttributeCoder::decode(coded.attributes, threads),
+                          QuaternionCoder::decode(coded.rotations, threads));
+    }
+
+    // 帧间编码并解码重建，依赖上一帧的结果，须在顺序阶段中执行
+    void encodeTemporalFrame(FrameContext& frame, SequenceWriter& writer) {
+        const auto& filePath = frame.filePath;
+        const size_t pointCount = frame.positions[0].size();
+        auto bitstream = temporalEncoder.encodeFrame(frame.positions, frame.attributes, frame.rotations);
+        const bool keyFrame = TemporalCoder::getFrameType(bitstream.data(), bitstream.size()) == CodedFrameType::KEY;
+        SPDLOG_INFO("Frame {} {} frame: {} bytes, {:.3f} bytes per splat", filePath.filename().string(), keyFrame ? "key" : "predicted",
+                    bitstream.size(), static_cast<double>(bitstream.size()) / pointCount);
+        frame.positions.clear();
+        frame.attributes.clear();
+        frame.rotations.clear();
+
+        // 解码结果按曲线顺序排列。编码器已把这一帧作为参考，解码或写出失败时该帧不在序列中，
+        // 下一帧须为关键帧，否则它的预测残差相对一个解码端没有的参考
+        DecodedFrame decoded;
+        try {
+            decoded = temporalDecoder.decodeFrame(bitstream);
+            writer.writeFrame(frame.frameIndex, bitstream, pointCount, keyFrame, BoundingBox3D::calculateFromPoints(decoded.positions, settings.threads));
+        } catch (...) {
+            temporalEncoder.forceKeyFrame();
+            throw;
+        }
+        setReconstruction(frame, std::move(decoded.positions), std::move(decoded.attributes), std::move(decoded.rotations));
+    }
+
+    /**
+     * @brief 外存编码一个静态场景：两遍流式读取(包围盒、量化与排序键)，外存排序后按曲线上连续的块帧内编码，
+     * 每块作为容器中的一项写出，常驻内存只取决于块大小与排序预算。各块共用一个量化网格(场景包围盒经对数变换的结果)，
+     * 网格随每块写出，解码端不需要重新计算对数变换，跨机器解码结果一致
+     * @param outputPath 容器文件路径
+     * @param sortPath 外存排序的临时目录
+     * @param onBlock 非空时每块编码后解码重建，按块号交给回调
+     * @throw std::runtime_error 如果场景中没有点，或读写失败
+     */
+    void encodeScene(const std::filesystem::path& filePath, SpaceFillingCurve positionOrder, const std::string& outputPath,
+                     const std::string& sortPath, const std::function<void(size_t, DecodedFrame&&)>& onBlock = nullptr) const {
+        std::vector<std::string> propertyNames = settings.positionNames;
+        propertyNames.insert(propertyNames.end(), settings.attributeNames.begin(), settings.attributeNames.end());
+        propertyNames.insert(propertyNames.end(), settings.rotationNames.begin(), settings.rotationNames.end());
+        const size_t threads = Parallel::resolveThreadCount(0);
+        PlyChunkReader reader(filePath.string(), "vertex", propertyNames, settings.sceneChunkSplats);
+        SPDLOG_INFO("Scene {}: {} splats in {} chunks", filePath.filename().string(), reader.getCount(), reader.getChunkCount());
+
+        std::optional<BoundingBox3D> bbox;
+        for (auto chunk = reader.readChunk<float>(threads); !chunk.empty(); chunk = reader.readChunk<float>(threads)) {
+            chunk.resize(settings.positionNames.size());
+            const auto chunkBBox = PositionPreprocessor::computeBBox(chunk, threads);
+            if (!bbox) {
+                bbox = chunkBBox;
+            }
+            for (size_t axis = 0; axis < 3; ++axis) {
+                bbox->data[axis] = std::min(bbox->data[axis], chunkBBox.data[axis]);
+                bbox->data[axis + 3] = std::max(bbox->data[axis + 3], chunkBBox.data[axis + 3]);
+            }
+        }
+        if (!bbox) {
+            SPDLOG_ERROR("Scene {} contains no splats", filePath.string());
+            throw std::runtime_error("Scene contains no splats: " + filePath.string());
+        }
+
+        reader.rewind();
+        ExternalSorter<float> sorter(sortPath, propertyNames.size(), settings.sceneSortMemory, threads);
+        for (auto chunk = reader.readChunk<float>(threads); !chunk.empty(); chunk = reader.readChunk<float>(threads)) {
+            std::vector<std::vector<float>> positions(std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.begin() + 3));
+            auto preprocessed = PositionPreprocessor::process<uint16_t>(positions, *bbox, settings.positionBitDepth, threads, positionOrder);
+            std::move(positions.begin(), positions.end(), chunk.begin());
+            sorter.add(preprocessed.curveKeys, chunk);
+        }
+
+        const size_t blockCount = (reader.getCount() + settings.sceneBlockSplats - 1) / settings.sceneBlockSplats;
+        SequenceWriter writer(outputPath, getMetadata(SequenceCoding::SCENE, positionOrder), blockCount);
+        const auto gridSection = SequenceContainer::packBBox(*bbox);
+        const size_t attributeCount = settings.attributeNames.size();
+        size_t blockIndex = 0;
+        size_t totalBytes = 0;
+        sorter.merge(settings.sceneBlockSplats, [&](std::vector<uint64_t>&, std::vector<std::vector<float>>& columns) {
+            auto first = std::make_move_iterator(columns.begin());
+            std::vector<std::vector<float>> positions(first, first + 3);
+            std::vector<std::vector<float>> attributes(first + 3, first + 3 + attributeCount);
+            std::vector<std::vector<float>> rotations(first + 3 + attributeCount, std::make_move_iterator(columns.end()));
+            // 与排序键使用同一网格，量化结果与排序时一致，块内已按曲线排列
+            auto quantized = PositionPreprocessor::process<uint16_t>(positions, *bbox, settings.positionBitDepth, threads, positionOrder).quantizedPositions;
+            auto geometryBitstream = OctreeCoder::encode(quantized, settings.positionBitDepth, positionOrder);
+            auto attributeBitstream = AttributeCoder::encode(attributes, settings.attributeQuantization, threads);
+            auto rotationBitstream = QuaternionCoder::encode(rotations, threads);
+            auto payload = SequenceContainer::packSections({gridSection, geometryBitstream, attributeBitstream, rotationBitstream});
+            totalBytes += payload.size();
+            writer.writeFrame(blockIndex, payload, positions[0].size(), true, BoundingBox3D::calculateFromPoints(positions, threads));
+            if (onBlock) {
+                onBlock(blockIndex, {reconstructPositions(OctreeCoder::decode<uint16_t>(geometryBitstream), *bbox, settings.positionBitDepth, threads),
+                                     AttributeCoder::decode(attributeBitstream, threads), QuaternionCoder::decode(rotationBitstream, threads)});
+            }
+            ++blockIndex;
+        });
+        writer.finish();
+        SPDLOG_INFO("Scene {}: {} blocks, {} bytes, {:.3f} bytes per splat", filePath.filename().string(), blockCount, totalBytes,
+                    static_cast<double>(totalBytes) / reader.getCount());
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "utils/ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+/**
+ * @brief 多帧流水线：每帧依次经过各阶段，不同帧的阶段在线程池上重叠执行
+ *
+ * 同时在处理中的帧数不超过maxInFlightFrames，帧对象在最后一个阶段结束后立即释放，
+ * 因此常驻内存约为maxInFlightFrames帧的数据量。例如第N+1帧的读取可以与第N帧的计算重叠。
+ * 顺序阶段按帧序号逐帧执行，用于依赖前一帧结果的处理（如帧间预测）；先到达的帧在此等待，不占用线程。
+ */
+template<typename FrameType>
+class FramePipeline {
+public:
+    struct Stage {
+        std::string name;
+        std::function<void(FrameType&)> process;
+        bool sequential = false;
+    };
+
+private:
+    ThreadPool& pool;
+    size_t maxInFlightFrames;
+    std::vector<Stage> stages;
+
+    // 单次run的共享状态
+    struct RunState {
+        std::counting_semaphore<> slots;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t remainingFrames;
+        std::exception_ptr firstError;
+        // 每个顺序阶段下一个应执行的帧序号，以及提前到达的帧；空指针表示该帧已失败，轮到它时直接跳过
+        std::vector<size_t> nextFrames;
+        std::vector<std::map<size_t, std::shared_ptr<FrameType>>> waitingFrames;
+
+        RunState(size_t maxInFlightFrames, size_t frameCount, size_t stageCount)
+            : slots(static_cast<std::ptrdiff_t>(maxInFlightFrames)), remainingFrames(frameCount),
+              nextFrames(stageCount, 0), waitingFrames(stageCount) {}
+    };
+
+    // 在顺序阶段登记一帧，轮到它时返回true；frame为空表示该帧在此之前已失败，只需让出顺序
+    bool enterSequential(RunState& state, std::shared_ptr<FrameType>& frame, size_t frameIndex, size_t stageIndex) {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.nextFrames[stageIndex] != frameIndex) {
+            state.waitingFrames[stageIndex].emplace(frameIndex, std::move(frame));
+            return false;
+        }
+        if (frame) {
+            return true;
+        }
+        ++state.nextFrames[stageIndex];
+        releaseWaiting(state, stageIndex);
+        return false;
+    }
+
+    // 顺序阶段处理完一帧后放行下一帧
+    void leaveSequential(RunState& state, size_t stageIndex) {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        ++state.nextFrames[stageIndex];
+        releaseWaiting(state, stageIndex);
+    }
+
+    // 调用时已持有锁：依次跳过已失败的帧，将轮到的等待帧提交到线程池
+    void releaseWaiting(RunState& state, size_t stageIndex) {
+        auto& waiting = state.waitingFrames[stageIndex];
+        for (auto it = waiting.find(state.nextFrames[stageIndex]); it != waiting.end(); it = waiting.find(state.nextFrames[stageIndex])) {
+            auto frame = std::move(it->second);
+            const size_t frameIndex = it->first;
+            waiting.erase(it);
+            if (frame) {
+                runStage(state, std::move(frame), frameIndex, stageIndex);
+                return;
+            }
+            ++state.nextFrames[stageIndex];
+        }
+    }
+
+    // 失败的帧不会再到达后续的顺序阶段，登记为跳过以免阻塞后面的帧
+    void skipSequential(RunState& state, size_t frameIndex, size_t failedStage) {
+        for (size_t stageIndex = failedStage + 1; stageIndex < stages.size(); ++stageIndex) {
+            if (stages[stageIndex].sequential) {
+                std::shared_ptr<FrameType> none;
+                enterSequential(state, none, frameIndex, stageIndex);
+            }
+        }
+    }
+
+    void finishFrame(RunState& state) {
+        state.slots.release();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (--state.remainingFrames == 0) {
+            state.finished.notify_all();
+        }
+    }
+
+    void failFrame(RunState& state, std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.firstError) state.firstError = error;
+        }
+        finishFrame(state);
+    }
+
+    void abortFrame(RunState& state, std::exception_ptr error, size_t frameIndex, size_t stageIndex) {
+        if (stages[stageIndex].sequential) {
+            leaveSequential(state, stageIndex);
+        }
+        skipSequential(state, frameIndex, stageIndex);
+        failFrame(state, error);
+    }
+
+    void scheduleStage(RunState& state, std::shared_ptr<FrameType> frame, size_t frameIndex, size_t stageIndex) {
+        if (stages[stageIndex].sequential && !enterSequential(state, frame, frameIndex, stageIndex)) {
+            return;
+        }
+        runStage(state, std::move(frame), frameIndex, stageIndex);
+    }
+
+    void runStage(RunState& state, std::shared_ptr<FrameType> frame, size_t frameIndex, size_t stageIndex) {
+        pool.enqueue([this, &state, frame = std::move(frame), frameIndex, stageIndex]() mutable {
+            const auto& stage = stages[stageIndex];
+            const auto start = std::chrono::high_resolution_clock::now();
+            try {
+                stage.process(*frame);
+            } catch (const std::exception& e) {
+                SPDLOG_ERROR("Frame {} failed in stage {}: {}", frameIndex, stage.name, e.what());
+                frame.reset();
+                abortFrame(state, std::current_exception(), frameIndex, stageIndex);
+                return;
+            } catch (...) {
+                SPDLOG_ERROR("Frame {} failed in stage {}", frameIndex, stage.name);
+                frame.reset();
+                abortFrame(state, std::current_exception(), frameIndex, stageIndex);
+                return;
+            }
+            [[maybe_unused]] const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+            SPDLOG_DEBUG("Frame {} stage {} time: {} ms", frameIndex, stage.name, duration);
+            if (stage.sequential) {
+                leaveSequential(state, stageIndex);
+            }
+
+            if (stageIndex + 1 < stages.size()) {
+                scheduleStage(state, std::move(frame), frameIndex, stageIndex + 1);
+            } else {
+                frame.reset();
+                finishFrame(state);
+            }
+        });
+    }
+
+public:
+    FramePipeline(ThreadPool& pool, size_t maxInFlightFrames)
+        : pool(pool), maxInFlightFrames(std::max<size_t>(1, maxInFlightFrames)) {}
+
+    FramePipeline& addStage(const std::string& name, std::function<void(FrameType&)> process) {
+        stages.push_back({name, std::move(process), false});
+        return *this;
+    }
+
+    // 添加顺序阶段：各帧按序号依次执行该阶段，前一帧完成(或失败)后才开始下一帧
+    FramePipeline& addSequentialStage(const std::string& name, std::function<void(FrameType&)> process) {
+        stages.push_back({name, std::move(process), true});
+        return *this;
+    }
+
+    /**
+     * @brief 处理frameCount帧，阻塞直到全部完成
+     * @param createFrame 按帧序号创建帧对象，在获得在途名额后才调用，以限制内存
+     * @throw 某帧失败时继续处理其余帧，结束后重新抛出第一个异常
+     */
+    void run(size_t frameCount, const std::function<FrameType(size_t)>& createFrame) {
+        if (frameCount == 0 || stages.empty()) {
+            return;
+        }
+
+        RunState state(maxInFlightFrames, frameCount, stages.size());
+        for (size_t i = 0; i < frameCount; ++i) {
+            state.slots.acquire();
+            scheduleStage(state, std::make_shared<FrameType>(createFrame(i)), i, 0);
+        }
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.finished.wait(lock, [&state]() { return state.remainingFrames == 0; });
+        if (state.firstError) {
+            std::rethrow_exception(state.firstError);
+        }
+    }
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <spdlog/spdlog.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GS_ARCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// 让单个函数在未开启全局指令集编译选项时也能使用对应的intrinsics
+// MSVC不需要额外标注，GCC/Clang通过target属性按函数启用
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GS_TARGET_AVX2
+#define GS_TARGET_AVX512
+#define GS_TARGET_BMI2
+#else
+#define GS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define GS_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma")))
+#define GS_TARGET_BMI2 __attribute__((target("bmi2")))
+#endif
+
+enum class SimdLevel {
+    SCALAR,
+    SSE,
+    AVX2,
+    AVX512
+};
+
+// 运行时CPU特性检测，结果在首次调用时缓存
+// 可通过环境变量GS_SIMD_LEVEL(scalar/sse/avx2/avx512)限制最高使用的指令集，便于排查问题；scalar同时禁用BMI2
+class CpuFeatures {
+public:
+    SimdLevel simdLevel = SimdLevel::SCALAR;
+    bool bmi2 = false;
+    // Zen3之前的AMD处理器上PDEP/PEXT由微码实现，延迟高达数百周期，不应使用
+    bool fastBmi2 = false;
+
+    static const CpuFeatures& get() {
+        static const CpuFeatures features = detect();
+        return features;
+    }
+
+    bool hasSse() const { return simdLevel >= SimdLevel::SSE; }
+    bool hasAvx2() const { return simdLevel >= SimdLevel::AVX2; }
+    bool hasAvx512() const { return simdLevel >= SimdLevel::AVX512; }
+    bool hasBmi2() const { return bmi2; }
+    bool hasFastBmi2() const { return fastBmi2; }
+
+private:
+    static CpuFeatures detect() {
+        CpuFeatures features;
+#if defined(GS_ARCH_X86)
+        uint32_t regs[4] = {};
+        cpuid(0, 0, regs);
+        const bool amd = regs[1] == 0x68747541u && regs[3] == 0x69746E65u && regs[2] == 0x444D4163u; // "AuthenticAMD"
+
+        cpuid(1, 0, regs);
+        const uint32_t baseFamily = (regs[0] >> 8) & 0xF;
+        const uint32_t family = baseFamily == 0xF ? baseFamily + ((regs[0] >> 20) & 0xFF) : baseFamily;
+        const bool osxsave = (regs[2] & (1u << 27)) != 0;
+        const bool avx = (regs[2] & (1u << 28)) != 0;
+        const bool fma = (regs[2] & (1u << 12)) != 0;
+        features.simdLevel = SimdLevel::SSE;
+
+        const uint64_t xcr0 = osxsave ? readXcr0() : 0;
+        const bool osAvx = (xcr0 & 0x6) == 0x6;
+        const bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+        cpuid(7, 0, regs);
+        const bool avx2 = (regs[1] & (1u << 5)) != 0;
+        const bool avx512f = (regs[1] & (1u << 16)) != 0;
+        const bool avx512dq = (regs[1] & (1u << 17)) != 0;
+        const bool avx512bw = (regs[1] & (1u << 30)) != 0;
+        const bool avx512vl = (regs[1] & (1u << 31)) != 0;
+        features.bmi2 = (regs[1] & (1u << 8)) != 0;
+        features.fastBmi2 = features.bmi2 && !(amd && family < 0x19);
+
+        if (avx && avx2 && fma && osAvx) {
+            features.simdLevel = SimdLevel::AVX2;
+            if (avx512f && avx512dq && avx512bw && avx512vl && osAvx512) {
+                features.simdLevel = SimdLevel::AVX512;
+            }
+        }
+#endif
+        applyEnvironmentLimit(features);
+        return features;
+    }
+
+    static void applyEnvironmentLimit(CpuFeatures& features) {
+        const char* env = std::getenv("GS_SIMD_LEVEL");
+        if (env == nullptr) {
+            return;
+        }
+        const std::string level(env);
+        SimdLevel limit = features.simdLevel;
+        if (level == "scalar") limit = SimdLevel::SCALAR;
+        else if (level == "sse") limit = SimdLevel::SSE;
+        else if (level == "avx2") limit = SimdLevel::AVX2;
+        else if (level == "avx512") limit = SimdLevel::AVX512;
+        else SPDLOG_WARN("Unknown GS_SIMD_LEVEL: {}", level);
+
+        if (limit < features.simdLevel) {
+            features.simdLevel = limit;
+        }
+        if (limit == SimdLevel::SCALAR) {
+            features.bmi2 = false;
+            features.fastBmi2 = false;
+        }
+    }
+
+#if defined(GS_ARCH_X86)
+    static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4]) {
+#if defined(_MSC_VER)
+        int out[4];
+        __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(out[i]);
+#else
+        if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+            regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        }
+#endif
+    }
+
+    static uint64_t readXcr0() {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+#endif
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+// 外存排序：按64位键稳定排序定长记录(键 + columnCount个T)，用于内存放不下的整个场景
+// 记录在内存中攒满预算后基数排序，按行写成一个有序段的临时文件；归并时每段只保留一个读缓冲区，
+// 用最小堆做多路归并，按块回调输出。只有一段时不落盘，直接在内存中排序输出
+template<typename T>
+class ExternalSorter {
+public:
+    // 归并输出的回调：一块记录的键与各列，回调可以移走其中的数据
+    using BlockCallback = std::function<void(std::vector<uint64_t>& keys, std::vector<std::vector<T>>& columns)>;
+
+private:
+    // 写段与读段时每次读写的最小字节数
+    static constexpr size_t MinIoBytes = 1 << 20;
+
+    std::filesystem::path directory;
+    std::string runPrefix;
+    size_t columnCount;
+    size_t memoryBudget;
+    size_t numThreads;
+    size_t runCapacity;
+    size_t totalCount = 0;
+    std::vector<uint64_t> keys;
+    std::vector<std::vector<T>> columns;
+    std::vector<std::filesystem::path> runs;
+    std::vector<size_t> runCounts;
+
+    size_t getRecordBytes() const {
+        return sizeof(uint64_t) + columnCount * sizeof(T);
+    }
+
+    // 内存中的记录按键排序后的下标，基数排序稳定，相同键保持加入顺序
+    std::vector<uint32_t> sortBuffered() {
+        std::vector<uint32_t> indices(keys.size());
+        std::iota(indices.begin(), indices.end(), 0u);
+        auto sortedKeys = keys;
+        RadixSort::sortPairs(sortedKeys, indices, numThreads);
+        return indices;
+    }
+
+    void clearBuffered() {
+        keys.clear();
+        for (auto& column : columns) {
+            column.clear();
+        }
+    }
+
+    // 将内存中的记录排序后写成一个有序段
+    void flushRun() {
+        if (keys.empty()) {
+            return;
+        }
+        const auto indices = sortBuffered();
+        const size_t recordBytes = getRecordBytes();
+        const auto path = directory / (runPrefix + std::to_string(runs.size()) + ".run");
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            SPDLOG_ERROR("Failed to create sort run: {}", path.string());
+            throw std::runtime_error("Failed to create sort run: " + path.string());
+        }
+        runs.push_back(path);
+        runCounts.push_back(keys.size());
+
+        const size_t batchRecords = std::max<size_t>(1, MinIoBytes / recordBytes);
+        std::vector<char> buffer(std::min(batchRecords, keys.size()) * recordBytes);
+        for (size_t begin = 0; begin < indices.size(); begin += batchRecords) {
+            const size_t end = std::min(indices.size(), begin + batchRecords);
+            char* record = buffer.data();
+            for (size_t i = begin; i < end; ++i, record += recordBytes) {
+                const uint32_t index = indices[i];
+                std::memcpy(record, &keys[index], sizeof(uint64_t));
+                for (size_t column = 0; column < columnCount; ++column) {
+                    std::memcpy(record + sizeof(uint64_t) + column * sizeof(T), &columns[column][index], sizeof(T));
+                }
+            }
+            file.write(buffer.data(), static_cast<std::streamsize>((end - begin) * recordBytes));
+        }
+        if (!file) {
+            SPDLOG_ERROR("Failed to write sort run: {}", path.string());
+            throw std::runtime_error("Failed to write sort run: " + path.string());
+        }
+        clearBuffered();
+    }
+
+    // 一个有序段的顺序读取游标
+    struct RunCursor {
+        std::ifstream file;
+        std::vector<char> buffer;
+        size_t remaining = 0;
+        size_t position = 0;
+        size_t filled = 0;
+    };
+
+    bool refill(RunCursor& cursor, size_t recordBytes) const {
+        if (cursor.remaining == 0) {
+            return false;
+        }
+        const size_t records = std::min(cursor.remaining, cursor.buffer.size() / recordBytes);
+        cursor.file.read(cursor.buffer.data(), static_cast<std::streamsize>(records * recordBytes));
+        if (!cursor.file) {
+            SPDLOG_ERROR("Failed to read sort run");
+            throw std::runtime_error("Failed to read sort run");
+        }
+        cursor.remaining -= records;
+        cursor.filled = records * recordBytes;
+        cursor.position = 0;
+        return true;
+    }
+
+    void mergeFromMemory(size_t blockSize, const BlockCallback& fn) {
+        const auto indices = sortBuffered();
+        std::vector<uint64_t> blockKeys;
+        std::vector<std::vector<T>> blockColumns(columnCount);
+        for (size_t begin = 0; begin < indices.size(); begin += blockSize) {
+            const size_t end = std::min(indices.size(), begin + blockSize);
+            blockKeys.resize(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                blockKeys[i - begin] = keys[indices[i]];
+            }
+            for (size_t column = 0; column < columnCount; ++column) {
+                blockColumns[column].resize(end - begin);
+                Parallel::forRange(end - begin, numThreads, [&](size_t first, size_t last) {
+                    for (size_t i = first; i < last; ++i) {
+                        blockColumns[column][i] = columns[column][indices[begin + i]];
+                    }
+                }, 1 << 14);
+            }
+            fn(blockKeys, blockColumns);
+        }
+        clearBuffered();
+    }
+
+    void mergeRuns(size_t blockSize, const BlockCallback& fn) {
+        const size_t recordBytes = getRecordBytes();
+        // 预算平分给各段的读缓冲区
+        const size_t bufferRecords = std::max<size_t>(1, memoryBudget / runs.size() / recordBytes);
+        std::vector<RunCursor> cursors(runs.size());
+        // 堆中为(键, 段号)，键相同时段号小的先出，保持稳定
+        using HeapEntry = std::pair<uint64_t, size_t>;
+        std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<>> heap;
+        auto currentKey = [](const RunCursor& cursor) {
+            uint64_t key;
+            std::memcpy(&key, cursor.buffer.data() + cursor.position, sizeof(uint64_t));
+            return key;
+        };
+        for (size_t run = 0; run < runs.size(); ++run) {
+            auto& cursor = cursors[run];
+            cursor.file.open(runs[run], std::ios::binary);
+            if (!cursor.file) {
+                SPDLOG_ERROR("Failed to open sort run: {}", runs[run].string());
+                throw std::runtime_error("Failed to open sort run: " + runs[run].string());
+            }
+            cursor.buffer.resize(std::min(bufferRecords, runCounts[run]) * recordBytes);
+            cursor.remaining = runCounts[run];
+            if (refill(cursor, recordBytes)) {
+                heap.emplace(currentKey(cursor), run);
+            }
+        }
+
+        std::vector<uint64_t> blockKeys;
+        std::vector<std::vector<T>> blockColumns(columnCount);
+        blockKeys.reserve(blockSize);
+        while (!heap.empty()) {
+            const auto [key, run] = heap.top();
+            heap.pop();
+            auto& cursor = cursors[run];
+            const char* record = cursor.buffer.data() + cursor.position;
+            blockKeys.push_back(key);
+            for (size_t column = 0; column < columnCount; ++column) {
+                T value;
+                std::memcpy(&value, record + sizeof(uint64_t) + column * sizeof(T), sizeof(T));
+                blockColumns[column].push_back(value);
+            }
+            cursor.position += recordBytes;
+            if (cursor.position < cursor.filled || refill(cursor, recordBytes)) {
+                heap.emplace(currentKey(cursor), run);
+            }
+
+            if (blockKeys.size() == blockSize || heap.empty()) {
+                fn(blockKeys, blockColumns);
+                blockKeys.clear();
+                for (auto& column : blockColumns) {
+                    column.clear();
+                }
+            }
+        }
+    }
+
+    void removeRuns() {
+        for (const auto& run : runs) {
+            std::error_code error;
+            std::filesystem::remove(run, error);
+        }
+        runs.clear();
+        runCounts.clear();
+    }
+
+public:
+    /**
+     * @brief 创建排序器
+     * @param directory 临时段文件所在的目录，不存在时创建
+     * @param columnCount 每条记录除键外的值个数
+     * @param memoryBudget 攒段与归并读缓冲区使用的字节数，不含调用方持有的输入和输出块
+     * @param numThreads 段内排序的线程数，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果无法创建目录
+     */
+    ExternalSorter(const std::filesystem::path& directory, size_t columnCount, size_t memoryBudget, size_t numThreads = 1)
+        : directory(directory), columnCount(columnCount), memoryBudget(memoryBudget), numThreads(numThreads), columns(columnCount) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            SPDLOG_ERROR("Failed to create sort directory: {}, error: {}", directory.string(), error.message());
+            throw std::runtime_error("Failed to create sort directory: " + directory.string());
+        }
+        // 同一目录下可能有多个排序器，段文件名带随机前缀
+        runPrefix = "sort-" + std::to_string(std::random_device{}()) + "-";
+        // 攒段时每条记录还需要排序用的下标、键的副本以及基数排序的临时数组
+        const size_t bufferedBytes = getRecordBytes() + 2 * (sizeof(uint64_t) + sizeof(uint32_t));
+        runCapacity = std::clamp<size_t>(memoryBudget / bufferedBytes, 1, UINT32_MAX);
+    }
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    ~ExternalSorter() {
+        removeRuns();
+    }
+
+    /**
+     * @brief 加入一批记录，内存中的记录达到预算时写出一个有序段
+     * @param batchColumns columnCount列，与batchKeys等长
+     * @throw std::runtime_error 如果列数或长度不匹配，或写临时文件失败
+     */
+    void add(const std::vector<uint64_t>& batchKeys, const std::vector<std::vector<T>>& batchColumns) {
+        if (batchColumns.size() != columnCount) {
+            throw std::runtime_error("External sort batch has " + std::to_string(batchColumns.size()) + " columns, expected " + std::to_string(columnCount));
+        }
+        for (const auto& column : batchColumns) {
+            if (column.size() != batchKeys.size()) {
+                throw std::runtime_error("External sort batch columns must match the key count");
+            }
+        }
+        for (size_t begin = 0; begin < batchKeys.size();) {
+            const size_t end = std::min(batchKeys.size(), begin + runCapacity - keys.size());
+            keys.insert(keys.end(), batchKeys.begin() + begin, batchKeys.begin() + end);
+            for (size_t column = 0; column < columnCount; ++column) {
+                columns[column].insert(columns[column].end(), batchColumns[column].begin() + begin, batchColumns[column].begin() + end);
+            }
+            totalCount += end - begin;
+            begin = end;
+            if (keys.size() == runCapacity) {
+                flushRun();
+            }
+        }
+    }
+
+    size_t size() const {
+        return totalCount;
+    }
+
+    // 已写出的有序段数
+    size_t getRunCount() const {
+        return runs.size();
+    }
+
+    /**
+     * @brief 按键升序输出全部记录，之后排序器为空
+     * @param blockSize 每次回调的记录数，最后一块可能更少
+     * @throw std::runtime_error 如果读写临时文件失败；回调抛出的异常原样传出
+     */
+    void merge(size_t blockSize, const BlockCallback& fn) {
+        if (blockSize == 0) {
+            throw std::invalid_argument("Block size must be positive");
+        }
+        if (runs.empty()) {
+            mergeFromMemory(blockSize, fn);
+        } else {
+            flushRun();
+            SPDLOG_INFO("Merging {} sorted runs of {} records", runs.size(), totalCount);
+            mergeRuns(blockSize, fn);
+            removeRuns();
+        }
+        totalCount = 0;
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+class Parallel {
+public:
+    // 0表示使用全部硬件线程
+    static size_t resolveThreadCount(size_t requested) {
+        if (requested != 0) {
+            return requested;
+        }
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * @brief 将[0, count)划分为连续区间并行执行fn(begin, end)
+     * @param count 总元素数
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @param fn 区间处理函数
+     * @param minChunk 每个区间的最小元素数，区间长度同时按其取整，避免相邻线程写同一缓存行
+     * @throw 重新抛出任一工作线程中的第一个异常
+     */
+    template<typename Fn>
+    static void forRange(size_t count, size_t numThreads, Fn&& fn, size_t minChunk = 1) {
+        if (count == 0) {
+            return;
+        }
+        minChunk = std::max<size_t>(1, minChunk);
+        const size_t maxChunks = (count + minChunk - 1) / minChunk;
+        const size_t chunks = std::min(resolveThreadCount(numThreads), maxChunks);
+        if (chunks <= 1) {
+            fn(size_t{0}, count);
+            return;
+        }
+
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        chunkSize = (chunkSize + minChunk - 1) / minChunk * minChunk;
+
+        std::vector<std::exception_ptr> errors(chunks);
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for (size_t i = 1; i < chunks; ++i) {
+            const size_t begin = std::min(count, i * chunkSize);
+            const size_t end = std::min(count, begin + chunkSize);
+            workers.emplace_back([&fn, &errors, i, begin, end]() {
+                try {
+                    if (begin < end) fn(begin, end);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        // 调用线程处理第一个区间
+        try {
+            fn(size_t{0}, std::min(count, chunkSize));
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// 按8位分段的LSD基数排序，排序稳定
+// 数据按线程切成连续块，每一趟先并行统计各块的桶计数，再按(桶, 块)顺序求前缀和，最后各块并行分发；
+// 所有元素在某一段上的取值相同时跳过该趟
+class RadixSort {
+private:
+    static constexpr int DigitBits = 8;
+    static constexpr size_t Buckets = size_t{1} << DigitBits;
+    // 每个块的最小元素数，数据量小时退化为单线程
+    static constexpr size_t MinBlockItems = 1 << 16;
+
+    using Histogram = std::array<size_t, Buckets>;
+
+    template<typename KeyType>
+    static size_t getDigit(KeyType key, int pass) {
+        return static_cast<size_t>((key >> (pass * DigitBits)) & (Buckets - 1));
+    }
+
+public:
+    /**
+     * @brief 按keys升序稳定排序，values随keys一起重排
+     * @param numThreads 线程数，0表示使用全部硬件线程
+     * @throw std::runtime_error 如果keys与values长度不一致
+     */
+    template<typename KeyType, typename ValueType>
+    static void sortPairs(std::vector<KeyType>& keys, std::vector<ValueType>& values, size_t numThreads = 1) {
+        static_assert(std::is_unsigned_v<KeyType>, "KeyType must be an unsigned integer");
+        constexpr int Passes = static_cast<int>(sizeof(KeyType) * 8 / DigitBits);
+
+        if (keys.size() != values.size()) {
+            throw std::runtime_error("Radix sort requires keys and values of equal length");
+        }
+        const size_t count = keys.size();
+        if (count < 2) {
+            return;
+        }
+
+        const size_t blocks = std::max<size_t>(1, std::min(Parallel::resolveThreadCount(numThreads), count / MinBlockItems));
+        auto blockBegin = [count, blocks](size_t block) { return count * block / blocks; };
+
+        // 一次遍历统计所有段的全局直方图，用于跳过取值恒定的段
+        std::vector<std::array<Histogram, Passes>> blockDigitCounts(blocks);
+        Parallel::forRange(blocks, blocks, [&](size_t first, size_t last) {
+            for (size_t block = first; block < last; ++block) {
+                auto& counts = blockDigitCounts[block];
+                for (auto& histogram : counts) histogram.fill(0);
+                const size_t end = blockBegin(block + 1);
+                for (size_t i = blockBegin(block); i < end; ++i) {
+                    for (int pass = 0; pass < Passes; ++pass) {
+                        ++counts[pass][getDigit(keys[i], pass)];
+                    }
+                }
+            }
+        });
+
+        std::vector<int> activePasses;
+        for (int pass = 0; pass < Passes; ++pass) {
+            Histogram total{};
+            for (const auto& counts : blockDigitCounts) {
+                for (size_t bucket = 0; bucket < Buckets; ++bucket) {
+                    total[bucket] += counts[pass][bucket];
+                }
+            }
+            bool constant = false;
+            for (const auto bucketCount : total) {
+                if (bucketCount == count) {
+                    constant = true;
+                    break;
+                }
+            }
+            if (!constant) {
+                activePasses.push_back(pass);
+            }
+        }
+        if (activePasses.empty()) {
+            return;
+        }
+
+        std::vector<KeyType> keyBuffer(count);
+        std::vector<ValueType> valueBuffer(count);
+        std::vector<Histogram> blockOffsets(blocks);
+        for (const int pass : activePasses) {
+            // 各块的桶计数依赖于上一趟后的排列，需要每趟重新统计
+            Parallel::forRange(blocks, blocks, [&](size_t first, size_t last) {
+                for (size_t block = first; block < last; ++block) {
+                    auto& histogram = blockOffsets[block];
+                    histogram.fill(0);
+                    const size_t end = blockBegin(block + 1);
+                    for (size_t i = blockBegin(block); i < end; ++i) {
+                        ++histogram[getDigit(keys[i], pass)];
+                    }
+                }
+            });
+
+            size_t offset = 0;
+            for (size_t bucket = 0; bucket < Buckets; ++bucket) {
+                for (size_t block = 0; block < blocks; ++block) {
+                    const size_t bucketCount = blockOffsets[block][bucket];
+                    blockOffsets[block][bucket] = offset;
+                    offset += bucketCount;
+                }
+            }
+
+            Parallel::forRange(blocks, blocks, [&](size_t first, size_t last) {
+                for (size_t block = first; block < last; ++block) {
+                    auto& offsets = blockOffsets[block];
+                    const size_t end = blockBegin(block + 1);
+                    for (size_t i = blockBegin(block); i < end; ++i) {
+                        const size_t destination = offsets[getDigit(keys[i], pass)]++;
+                        keyBuffer[destination] = keys[i];
+                        valueBuffer[destination] = values[i];
+                    }
+                }
+            });
+
+            keys.swap(keyBuffer);
+            values.swap(valueBuffer);
+        }
+    }
+};
@@ -1,109 +1,176 @@
 #include "io/PlyReader.hpp"
 #include "io/PlyWriter.hpp"
 #include "utils/Timer.hpp"
-#include "codec/MortonOrder.hpp"
-#include "codec/Transform.hpp"
-#include "codec/Quantization.hpp"
+#include "codec/SpaceFillingCurve.hpp"
+#include "codec/SequenceContainer.hpp"
+#include "pipeline/FramePipeline.hpp"
+#include "pipeline/FrameEncoder.hpp"
+#include "utils/ThreadPool.hpp"
 #include <cstdint>
+#include <optional>
 
 const std::string ROOT_PATH = "G:\\code\\cpp\\gaussian-stream\\";
 const std::string INPUT_PATH = "G:\\code\\icip2026\\datasets\\coffee_martini_origin_ply_\\";
-const std::string ENCODED_PLY_PATH = ROOT_PATH + "output\\encoded-ply\\";
-const std::string ENCODED_DRC_PATH = ROOT_PATH + "output\\encoded-drc\\";
+// 整个序列的编码结果写入一个容器文件
+const std::string ENCODED_SEQUENCE_PATH = ROOT_PATH + "output\\encoded-sequence.gss";
 const std::string DECODED_PLY_PATH = ROOT_PATH + "output\\decoded-ply\\";
-const std::string DRACO_ENCODER = "G:\\code\\cpp\\gaussian-stream\\draco_encoder.exe";
-const std::string DRACO_DECODER = "G:\\code\\cpp\\gaussian-stream\\draco_decoder.exe";
-
-void dracoEncode(const std::string& inputFile, const std::string& outputFile, int cl = 10, int qp = 16) {
-    std::string command = DRACO_ENCODER + " -i " + inputFile + " -o " + outputFile + " -qp " + std::to_string(qp) + " -cl " + std::to_string(cl);
-    auto res = std::system(command.c_str());
-    if(res != 0) {
-        SPDLOG_ERROR("Draco encoding failed for file: {}", inputFile);
-    }
+// 静态场景模式的输出与外存排序的临时目录
+const std::string ENCODED_SCENE_PATH = ROOT_PATH + "output\\encoded-scene.gss";
+const std::string SCENE_SORT_PATH = ROOT_PATH + "output\\sort-runs\\";
+
+// 几何量化位深，运行时参数，可在1~16之间调整
+const int POSITION_BIT_DEPTH = 16;
+
+// 默认的点排列顺序，可由命令行第一个参数(morton/hilbert)覆盖
+const SpaceFillingCurve DEFAULT_POSITION_ORDER = SpaceFillingCurve::MORTON;
+
+// 帧间编码模式下的关键帧间隔
+const size_t KEYFRAME_INTERVAL = 30;
+
+// 渐进式编码模式下统计预览质量所用的码流前缀比例
+const double PREVIEW_BYTE_FRACTION = 0.05;
+
+// 分块编码模式下每帧的块数
+const size_t TILES_PER_FRAME = 16;
+
+// 分块量化模式：全局网格位深决定最大几何误差，每块的最大点数
+const int BLOCK_GRID_BIT_DEPTH = 18;
+const size_t QUANTIZATION_BLOCK_SPLATS = 4096;
+
+// 码率控制模式的默认目标：每帧码流字节数，可由命令行第三个参数覆盖(字节数，或如"60dB"的PSNR目标)
+const size_t RATE_TARGET_BYTES = 2'500'000;
+// 码率控制的搜索范围：几何位深下限与属性位深的最大降低量
+const RateControlSettings RATE_CONTROL_SETTINGS = {10, 4};
+
+// 静态场景模式：每次流式读取的点数、外存排序的内存预算、每个编码块的点数
+const size_t SCENE_CHUNK_SPLATS = 1 << 20;
+const size_t SCENE_SORT_MEMORY = size_t{1} << 30;
+const size_t SCENE_BLOCK_SPLATS = 1 << 20;
+
+// 同时在处理中的帧数，限制常驻内存
+const size_t FRAMES_IN_FLIGHT = 4;
+// 每帧内部并行I/O使用的线程数，与在途帧数一起占满全部核心
+const size_t THREADS_PER_FRAME = std::max<size_t>(1, Parallel::resolveThreadCount(0) / FRAMES_IN_FLIGHT);
+
+const std::vector<std::string> POSITION_NAMES = {"x", "y", "z"};
+const std::vector<std::string> ATTRIBUTE_NAMES = {
+    "f_dc_0", "f_dc_1", "f_dc_2",
+    "opacity","scale_0", "scale_1", "scale_2"};
+// 旋转四元数单独以smallest-three方式打包
+const std::vector<std::string> ROTATION_NAMES = {"rot_0", "rot_1", "rot_2", "rot_3"};
+
+// 与ATTRIBUTE_NAMES一一对应的量化设置：opacity在sigmoid域量化，scale本身已是对数域
+const std::vector<AttributeQuantization> ATTRIBUTE_QUANTIZATION = {
+    {10}, {10}, {10},
+    {8, AttributeDomain::SIGMOID, std::array<float, 2>{0.0f, 1.0f}},
+    {10}, {10}, {10}};
+
+// 读取
+void readFrame(FrameContext& frame) {
+    frame.data = PlyReader::readDataFromFile(frame.filePath.string(), THREADS_PER_FRAME);
+    frame.positions = frame.data.takeTypedProperties<float>("vertex", POSITION_NAMES);
+    frame.attributes = frame.data.takeTypedProperties<float>("vertex", ATTRIBUTE_NAMES);
+    frame.rotations = frame.data.takeTypedProperties<float>("vertex", ROTATION_NAMES);
 }
-void dracoDecode(const std::string& inputFile, const std::string& outputFile) {
-    std::string command = DRACO_DECODER + " -i " + inputFile + " -o " + outputFile;
-    auto res = std::system(command.c_str());
-    if(res != 0) {
-        SPDLOG_ERROR("Draco decoding failed for file: {}", inputFile);
-    }
+
+// 保存最终解码结果
+void writeFrame(FrameContext& frame) {
+    auto finalDecodedPlyFilePath = DECODED_PLY_PATH + frame.filePath.filename().string();
+    PlyWriter::writeDataToFile(finalDecodedPlyFilePath, frame.data, PlyFormat::BINARY_LITTLE_ENDIAN, THREADS_PER_FRAME);
+    // PlyWriter::writeDataToFileWithPropertyMasks(finalDecodedPlyFilePath, frame.data, POSITION_NAMES);
 }
 
 int main(int argc, char **argv) {
+    // 命令行：[morton|hilbert] [intra|temporal|progressive|tiled|blocked|rate [字节数|PSNR dB]|scene [PLY文件]]
+    const SpaceFillingCurve positionOrder = argc > 1 ? CurveOrder::fromName(argv[1]) : DEFAULT_POSITION_ORDER;
+    const std::string mode = argc > 2 ? argv[2] : "intra";
+    if (mode != "intra" && mode != "temporal" && mode != "progressive" && mode != "tiled" && mode != "blocked" && mode != "rate" && mode != "scene") {
+        SPDLOG_ERROR("Unknown coding mode: {}", mode);
+        return 1;
+    }
+    const SequenceCoding coding = mode == "temporal" ? SequenceCoding::TEMPORAL
+                                : mode == "progressive" ? SequenceCoding::PROGRESSIVE
+                                : mode == "tiled" ? SequenceCoding::TILED
+                                : mode == "blocked" ? SequenceCoding::BLOCKED
+                                : mode == "rate" ? SequenceCoding::RATE_CONTROLLED : SequenceCoding::INTRA;
+    SPDLOG_INFO("Position order: {}, coding mode: {}", CurveOrder::getName(positionOrder), mode);
 
     auto files = FileTools::findFilesMatchingPattern(INPUT_PATH, R"(.*\.ply)");
     SPDLOG_INFO("Found {} PLY files in input directory.", files.size());
-    for(const auto& filePath : files) {
-
-        auto data = PlyReader::readDataFromFile(filePath.string());
-        auto positions = data.getTypedProperties<float>("vertex", {"x", "y", "z"});
-        auto attributes = data.getTypedProperties<float>("vertex", 
-            {"f_dc_0", "f_dc_1", "f_dc_2", 
-            "opacity","scale_0", "scale_1", "scale_2",
-            "rot_0", "rot_1", "rot_2", "rot_3"});
-        // 编码的流程
-        auto bbox = BoundingBox3D::calculateFromPoints(positions);
-
-        // 变换量化
-        Transform::logTransformInPlace(positions, bbox);
-        auto quantizedPositions = Quantization::quantizePositionWithBBox<uint16_t, float, 16>(positions, bbox);
-        
-        // 计算莫顿序
-        auto indices = MortonEncoder::calculateMortonIndices<uint64_t>(
-            Quantization::castVectors<uint32_t>(quantizedPositions)
-        );
-
-        // 对量化后的数据重排莫顿序
-        for(auto& position : quantizedPositions){
-            Transform::sortInPlaceWithIndices(position, indices);
-        }
-        
-        for(auto& attr : attributes){
-            Transform::sortInPlaceWithIndices(attr, indices);
-        }
 
-        // 写入几何信息的PLY码流
-        auto encodedPlyFilePath = ENCODED_PLY_PATH + filePath.filename().string();
-        auto quantizedPositionsFP32 = Quantization::castVectors<float>(quantizedPositions);
-        data.setProperties("vertex", {"x", "y", "z"}, quantizedPositionsFP32);
-        PlyWriter::writeDataToFileWithPropertyMasks(encodedPlyFilePath, data, {"x", "y", "z"});
-
-        // 使用Draco压缩几何信息
-        auto dracoEncodedFilePath = ENCODED_DRC_PATH + filePath.stem().string() + ".drc";
-        dracoEncode(encodedPlyFilePath, dracoEncodedFilePath, 10, 14);
-        // 使用Draco解压缩几何信息
-        auto dracoDecodedPlyFilePath = DECODED_PLY_PATH + filePath.filename().string();
-        dracoDecode(dracoEncodedFilePath, dracoDecodedPlyFilePath);
-
-        // 读取解码后的几何信息
-        auto decodedData = PlyReader::readDataFromFile(dracoDecodedPlyFilePath);
-        auto decodedQuantizedPositions = decodedData.getTypedProperties<float>("vertex", {"x", "y", "z"});
-        // auto decodedQuantizedPositions = quantizedPositionsFP32; // 使用原始的量化数据进行反量化反变换测试
-
-        // 计算解码后数据的莫顿序
-        auto decodedIndices = MortonEncoder::calculateMortonIndices<uint64_t>(
-            Quantization::castVectors<uint32_t>(decodedQuantizedPositions)
-        );
-        // 重排序
-        for(auto& position : decodedQuantizedPositions){
-            Transform::sortInPlaceWithIndices(position, decodedIndices);
+    // 以dB结尾的参数为PSNR目标，否则为字节预算
+    RateTarget rateTarget{RATE_TARGET_BYTES};
+    if (mode == "rate" && argc > 3) {
+        const std::string argument = argv[3];
+        rateTarget = argument.ends_with("dB") ? RateTarget{0, std::stod(argument.substr(0, argument.size() - 2))}
+                                               : RateTarget{std::stoull(argument)};
+    }
+    // 帧间模式下编码阶段逐帧串行，帧内并行使用全部线程；读写仍与其他帧重叠
+    FrameEncoder encoder({.positionBitDepth = POSITION_BIT_DEPTH, .positionNames = POSITION_NAMES, .attributeNames = ATTRIBUTE_NAMES,
+                          .rotationNames = ROTATION_NAMES, .attributeQuantization = ATTRIBUTE_QUANTIZATION,
+                          .keyframeInterval = KEYFRAME_INTERVAL, .previewByteFraction = PREVIEW_BYTE_FRACTION, .tilesPerFrame = TILES_PER_FRAME,
+                          .blockGridBitDepth = BLOCK_GRID_BIT_DEPTH, .blockSplats = QUANTIZATION_BLOCK_SPLATS,
+                          .rateTarget = rateTarget, .rateControl = RATE_CONTROL_SETTINGS,
+                          .sceneChunkSplats = SCENE_CHUNK_SPLATS, .sceneSortMemory = SCENE_SORT_MEMORY, .sceneBlockSplats = SCENE_BLOCK_SPLATS,
+                          .threads = THREADS_PER_FRAME},
+                         positionOrder, 0);
+
+    // 静态场景不经过帧流水线，默认编码输入目录中的第一个文件
+    if (mode == "scene") {
+        if (argc <= 3 && files.empty()) {
+            SPDLOG_ERROR("No scene to encode");
+            return 1;
         }
-        
-        // 反量化反变换
-        auto dequantizedPositions = Quantization::dequantizePositionWithBBox<float, float, 16>(decodedQuantizedPositions, bbox);
-        Transform::inverseLogTransformInPlace(dequantizedPositions, bbox);
-        
-        data.setProperties("vertex", {"x", "y", "z"}, dequantizedPositions);
-        data.setProperties("vertex", 
-            {"f_dc_0", "f_dc_1", "f_dc_2", 
-            "opacity","scale_0", "scale_1", "scale_2",
-            "rot_0", "rot_1", "rot_2", "rot_3"}, attributes);
-        
-        // 保存最终解码结果
-        auto finalDecodedPlyFilePath = DECODED_PLY_PATH + filePath.filename().string();
-        PlyWriter::writeDataToFile(finalDecodedPlyFilePath, data);
-        // PlyWriter::writeDataToFileWithPropertyMasks(finalDecodedPlyFilePath, data, {"x", "y", "z"});
+        TICK(scene);
+        encoder.encodeScene(argc > 3 ? std::filesystem::path(argv[3]) : files.front(), positionOrder, ENCODED_SCENE_PATH, SCENE_SORT_PATH);
+        TOCK(scene);
+        return 0;
+    }
+
+    ThreadPool pool;
+    FramePipeline<FrameContext> pipeline(pool, FRAMES_IN_FLIGHT);
+    SequenceWriter writer(ENCODED_SEQUENCE_PATH, encoder.getMetadata(coding, positionOrder), files.size());
+    pipeline.addStage("read", readFrame);
+    if (coding == SequenceCoding::TEMPORAL) {
+        pipeline.addSequentialStage("encode", [&encoder, &writer](FrameContext& frame) { encoder.encodeTemporalFrame(frame, writer); });
+    } else if (coding == SequenceCoding::TILED || coding == SequenceCoding::BLOCKED || coding == SequenceCoding::RATE_CONTROLLED) {
+        // 分块与码率控制在编码内部自行量化与排序
+        pipeline.addStage("encode", [&encoder, &writer, coding](FrameContext& frame) {
+            if (coding == SequenceCoding::TILED) {
+                encoder.encodeTiledFrame(frame, writer);
+            } else if (coding == SequenceCoding::BLOCKED) {
+                encoder.encodeBlockedFrame(frame, writer);
+            } else {
+                encoder.encodeRateControlledFrame(frame, writer);
+            }
+        });
+    } else {
+        pipeline.addStage("preprocess", [&encoder](FrameContext& frame) { encoder.preprocessFrame(frame); })
+                .addStage("reorder", [&encoder](FrameContext& frame) { encoder.reorderFrame(frame); })
+                .addStage("encode", [&encoder, &writer, coding](FrameContext& frame) {
+                    coding == SequenceCoding::PROGRESSIVE ? encoder.encodeProgressiveFrame(frame, writer) : encoder.encodeFrame(frame, writer);
+                });
+    }
+    pipeline.addStage("write", writeFrame);
+
+    TICK(sequence);
+    pipeline.run(files.size(), [&files, positionOrder](size_t index) {
+        FrameContext frame;
+        frame.frameIndex = index;
+        frame.filePath = files[index];
+        frame.positionOrder = positionOrder;
+        return frame;
+    });
+    writer.finish();
+    TOCK(sequence);
+
+    // 播放端只需映射容器文件，即可按帧号直接定位
+    SequenceReader reader(ENCODED_SEQUENCE_PATH);
+    size_t keyFrames = 0;
+    for (size_t i = 0; i < reader.getFrameCount(); ++i) {
+        keyFrames += reader.isKeyFrame(i);
     }
+    SPDLOG_INFO("Sequence container: {} frames, {} key frames", reader.getFrameCount(), keyFrames);
 
     return 0;
 }
@@ -8,16 +8,20 @@ if is_plat("windows") then
     add_defines("NOMINMAX")
 end
 
-if is_plat("windows") then
-    add_vectorexts("avx2")
-elseif is_plat("linux") then 
-    add_cxxflags("-mbmi2")
-end
-
-add_requires("spdlog", "mio", "morton-nd")
+add_requires("spdlog", "mio")
 
 target("gaussian-stream")
     set_kind("binary")
     add_includedirs("include")
-    add_packages("spdlog", "mio", "morton-nd")
-    add_files("src/*.cpp")
\ No newline at end of file
+    add_packages("spdlog", "mio")
+    add_files("src/*.cpp")
+
+target("gaussian-bench")
+    set_kind("binary")
+    add_includedirs("include")
+    add_packages("spdlog", "mio")
+    add_files("bench/*.cpp", "src/config.cpp")
+    -- xmake test：对数变换的精度检查，超出界限时失败
+    add_tests("accuracy", {runargs = "accuracy"})
+    -- xmake test：每种编码模式从容器文件解码，须与编码端的重建逐位相同
+    add_tests("container", {runargs = "container"})
\ No newline at end of file